@@ -1,6 +1,17 @@
 #ifndef BOULDERDASH_H_
 #define BOULDERDASH_H_
 
+#include "../../src/beam_search.h"
 #include "../../src/boulderdash_base.h"
+#include "../../src/grid_query.h"
+#include "../../src/level_generator.h"
+#include "../../src/level_loader.h"
+#include "../../src/observation_cache.h"
+#include "../../src/observation_codec.h"
+#include "../../src/render.h"
+#include "../../src/search.h"
+#include "../../src/solution_store.h"
+#include "../../src/trace.h"
+#include "../../src/visited_set.h"
 
 #endif    // BOULDERDASH_H_
@@ -1,19 +1,42 @@
 // pyboulderdash.cpp
 // Python bindings
 
+#include <pybind11/functional.h>
 #include <pybind11/numpy.h>
 #include <pybind11/operators.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
 #include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <vector>
 
 #include "boulderdash/boulderdash.h"
 
 namespace py = pybind11;
 
+namespace {
+auto to_element_set(const std::vector<boulderdash::HiddenCellType> &elements) -> boulderdash::ElementSet {
+    boulderdash::ElementSet set;
+    for (const auto element : elements) {
+        if (!boulderdash::BoulderDashGameState::is_valid_hidden_element(element)) {
+            throw std::invalid_argument("Invalid element.");
+        }
+        set.insert(element);
+    }
+    return set;
+}
+}    // namespace
+
 PYBIND11_MODULE(pyboulderdash, m) {
     m.doc() = "BoulderDash environment module docs.";
     using T = boulderdash::BoulderDashGameState;
@@ -99,13 +122,26 @@ PYBIND11_MODULE(pyboulderdash, m) {
         .def_readwrite("blob_max_percentage", &GP::blob_max_percentage)
         .def_readwrite("disable_explosions", &GP::disable_explosions)
         .def_readwrite("butterfly_explosion_ver", &GP::butterfly_explosion_ver)
-        .def_readwrite("butterfly_move_ver", &GP::butterfly_move_ver);
+        .def_readwrite("butterfly_move_ver", &GP::butterfly_move_ver)
+        .def_readwrite("chunk_size", &GP::chunk_size)
+        .def_readwrite("step_threads", &GP::step_threads)
+        .def_readwrite("sim_radius", &GP::sim_radius);
 
-    py::class_<T>(m, "BoulderDashGameState")
+    // The buffer aliases the grid storage read-only, so np.asarray(state) or memoryview(state) reads the hidden cells
+    // without copying.
+    py::class_<T>(m, "BoulderDashGameState", py::buffer_protocol())
         .def(py::init<const std::string &>())
         .def(py::init<const std::string &, const GP &>())
+        .def_buffer([](const T &self) {
+            const auto obs_shape = self.observation_shape();
+            auto *data = const_cast<boulderdash::HiddenCellType *>(self.get_grid_storage().data());    // NOLINT
+            return py::buffer_info(data, sizeof(int8_t), py::format_descriptor<int8_t>::format(), 2,
+                                   {obs_shape[1], obs_shape[2]},
+                                   {static_cast<py::ssize_t>(obs_shape[2]), static_cast<py::ssize_t>(1)}, true);
+        })
         .def_readonly_static("name", &T::name)
         .def_readonly_static("num_actions", &boulderdash::kNumActions)
+        .def_readonly_static("num_entity_fields", &boulderdash::kNumEntityFields)
         .def(py::self == py::self)    // NOLINT (misc-redundant-expression)
         .def(py::self != py::self)    // NOLINT (misc-redundant-expression)
         .def("__hash__", [](const T &self) { return self.get_hash(); })
@@ -125,10 +161,11 @@ PYBIND11_MODULE(pyboulderdash, m) {
                                       s.rows, s.cols, s.agent_idx, s.gems_required, s.random_state, s.reward_signal,
                                       s.hash, s.blob_chance, s.gravity, s.disable_explosions, s.magic_active,
                                       s.blob_enclosed, s.is_agent_alive, s.is_agent_in_exit, s.blob_swap, s.grid,
-                                      s.has_updated);
+                                      s.has_updated, s.chunk_size, s.step_threads, s.sim_radius);
             },
             [](py::tuple t) -> T {    // __setstate__
-                if (t.size() != 24) {
+                // States pickled before chunk_size, step_threads and sim_radius were added have 24 fields
+                if (t.size() != 24 && t.size() != 27) {
                     throw std::runtime_error("Invalid state");
                 }
                 T::InternalState s;
@@ -156,6 +193,10 @@ PYBIND11_MODULE(pyboulderdash, m) {
                 s.blob_swap = t[21].cast<int8_t>();                 // NOLINT(*-magic-numbers)
                 s.grid = t[22].cast<std::vector<int8_t>>();         // NOLINT(*-magic-numbers)
                 s.has_updated = t[23].cast<std::vector<bool>>();    // NOLINT(*-magic-numbers)
+                const bool current = t.size() == 27;                          // NOLINT(*-magic-numbers)
+                s.chunk_size = current ? t[24].cast<int>() : 0;               // NOLINT(*-magic-numbers)
+                s.step_threads = current ? t[25].cast<int>() : 0;             // NOLINT(*-magic-numbers)
+                s.sim_radius = current ? t[26].cast<int>() : 0;               // NOLINT(*-magic-numbers)
                 return {std::move(s)};
             }))
         .def("apply_action",
@@ -166,12 +207,34 @@ PYBIND11_MODULE(pyboulderdash, m) {
                  self.apply_action(static_cast<boulderdash::Action>(action));
              })
         .def("is_solution", &T::is_solution)
+        .def("is_approximate", &T::is_approximate)
         .def("observation_shape", &T::observation_shape)
         .def("get_observation",
              [](const T &self) {
                  py::array_t<float> out = py::cast(self.get_observation());
                  return out.reshape(self.observation_shape());
              })
+        .def("get_observation_compact",
+             [](const T &self) {
+                 py::array_t<int8_t> out = py::cast(self.get_observation_compact());
+                 const auto obs_shape = self.observation_shape();
+                 return out.reshape({obs_shape[1], obs_shape[2]});
+             })
+        .def(
+            "get_entities",
+            [](const T &self, int capacity, bool skip_empty, bool skip_dirt, bool skip_walls) {
+                if (capacity < 0) {
+                    throw std::invalid_argument("Capacity must be non-negative.");
+                }
+                py::array_t<int16_t> out({capacity, boulderdash::kNumEntityFields});
+                const boulderdash::EntityFilter filter{
+                    .skip_empty = skip_empty, .skip_dirt = skip_dirt, .skip_walls = skip_walls};
+                const int count = self.get_entities(
+                    std::span<int16_t>(out.mutable_data(), static_cast<std::size_t>(out.size())), filter);
+                return py::make_tuple(out, count);
+            },
+            py::arg("capacity"), py::arg("skip_empty") = true, py::arg("skip_dirt") = true,
+            py::arg("skip_walls") = true)
         .def("image_shape", &T::image_shape)
         .def("to_image",
              [](T &self) {
@@ -181,9 +244,385 @@ PYBIND11_MODULE(pyboulderdash, m) {
                                      static_cast<py::ssize_t>(obs_shape[2] * boulderdash::SPRITE_WIDTH),
                                      static_cast<py::ssize_t>(boulderdash::SPRITE_CHANNELS)});
              })
+        .def("get_changed_cells",
+             [](const T &self) {
+                 const auto &changes = self.get_changed_cells();
+                 py::array_t<int32_t> out({static_cast<py::ssize_t>(changes.size()), static_cast<py::ssize_t>(3)});
+                 auto view = out.mutable_unchecked<2>();
+                 for (py::ssize_t i = 0; i < static_cast<py::ssize_t>(changes.size()); ++i) {
+                     const auto &change = changes[static_cast<std::size_t>(i)];
+                     view(i, 0) = change.index;
+                     view(i, 1) = static_cast<int32_t>(change.old_type);
+                     view(i, 2) = static_cast<int32_t>(change.new_type);
+                 }
+                 return out;
+             })
         .def("get_reward_signal", &T::get_reward_signal)
         .def("get_agent_index", &T::get_agent_index)
         .def("agent_alive", &T::agent_alive)
         .def("agent_in_exit", &T::agent_in_exit)
-        .def("get_hidden_item", &T::get_hidden_item);
+        .def("get_hidden_item", &T::get_hidden_item)
+        .def_property_readonly("grid",
+                               [](const T &self) {
+                                   const auto obs_shape = self.observation_shape();
+                                   py::array_t<int8_t> out({obs_shape[1], obs_shape[2]});
+                                   self.get_hidden_grid(
+                                       std::span<int8_t>(out.mutable_data(), static_cast<std::size_t>(out.size())));
+                                   return out;
+                               })
+        .def(
+            "get_indices",
+            [](const T &self, boulderdash::HiddenCellType element) {
+                const auto indices = self.get_indices(element);
+                py::array_t<int32_t> out(static_cast<py::ssize_t>(indices.size()));
+                std::ranges::copy(indices, out.mutable_data());
+                return out;
+            },
+            py::arg("element"))
+        .def(
+            "get_indices",
+            [](const T &self, const std::vector<boulderdash::HiddenCellType> &elements) {
+                const auto indices = self.get_indices(to_element_set(elements));
+                py::array_t<int32_t> out(static_cast<py::ssize_t>(indices.size()));
+                std::ranges::copy(indices, out.mutable_data());
+                return out;
+            },
+            py::arg("elements"))
+        .def(
+            "count_elements",
+            [](const T &self, const std::vector<boulderdash::HiddenCellType> &elements) {
+                return self.count_elements(to_element_set(elements));
+            },
+            py::arg("elements"))
+        .def(
+            "has_elements",
+            [](const T &self, const std::vector<boulderdash::HiddenCellType> &elements) {
+                return self.has_elements(to_element_set(elements));
+            },
+            py::arg("elements"))
+        .def(
+            "get_positions",
+            [](const T &self, boulderdash::HiddenCellType element) {
+                const auto positions = self.get_positions(element);
+                py::array_t<int32_t> out({static_cast<py::ssize_t>(positions.size()), static_cast<py::ssize_t>(2)});
+                auto view = out.mutable_unchecked<2>();
+                for (py::ssize_t i = 0; i < static_cast<py::ssize_t>(positions.size()); ++i) {
+                    view(i, 0) = positions[static_cast<std::size_t>(i)].first;
+                    view(i, 1) = positions[static_cast<std::size_t>(i)].second;
+                }
+                return out;
+            },
+            py::arg("element"))
+        .def("get_agent_position",
+             [](const T &self) {
+                 const auto [row, col] = self.index_to_position(self.get_agent_index());
+                 py::array_t<int32_t> out(2);
+                 out.mutable_at(0) = row;
+                 out.mutable_at(1) = col;
+                 return out;
+             })
+        .def("grid_view", [](const py::object &self) { return py::memoryview(self); })
+        .def("get_element_counts", [](const T &self) {
+            py::array_t<int32_t> out(boulderdash::kNumHiddenCellType);
+            self.get_element_counts(std::span<int32_t>(out.mutable_data(), static_cast<std::size_t>(out.size())));
+            return out;
+        });
+
+    m.def("grid_query_isa", &boulderdash::grid_query_isa);
+    m.def(
+        "make_states",
+        [](const std::vector<std::string> &levels, const GP &params, int num_threads) {
+            const py::gil_scoped_release release;
+            return boulderdash::make_states(levels, params, num_threads);
+        },
+        py::arg("levels"), py::arg("params") = GP{}, py::arg("num_threads") = 0);
+    m.def(
+        "load_level_file",
+        [](const std::string &path, const GP &params, int num_threads) {
+            const py::gil_scoped_release release;
+            return boulderdash::make_states(boulderdash::read_level_file(path), params, num_threads);
+        },
+        py::arg("path"), py::arg("params") = GP{}, py::arg("num_threads") = 0);
+
+    py::enum_<boulderdash::LevelScenario>(m, "LevelScenario")
+        .value("kOneKey", boulderdash::LevelScenario::kOneKey)
+        .value("kThreeKeys", boulderdash::LevelScenario::kThreeKeys)
+        .value("kHard", boulderdash::LevelScenario::kHard);
+    m.def("generate_level", &boulderdash::generate_level, py::arg("scenario"), py::arg("seed"));
+    m.def("goals_reachable", &boulderdash::goals_reachable, py::arg("state"));
+
+    // No Python filter, the generator threads would need the GIL
+    using LS = boulderdash::LevelStream;
+    py::class_<LS>(m, "LevelStream")
+        .def(py::init([](boulderdash::LevelScenario scenario, uint64_t seed, std::size_t capacity, int num_threads,
+                         bool require_reachable, const GP &params) {
+                 return std::make_unique<LS>(boulderdash::LevelStreamOptions{.scenario = scenario,
+                                                                             .seed = seed,
+                                                                             .capacity = capacity,
+                                                                             .num_threads = num_threads,
+                                                                             .require_reachable = require_reachable,
+                                                                             .params = params});
+             }),
+             py::arg("scenario") = boulderdash::LevelScenario::kOneKey, py::arg("seed") = 0,
+             py::arg("capacity") = 1024, py::arg("num_threads") = 1, py::arg("require_reachable") = true,
+             py::arg("params") = GP{})
+        .def("next",
+             [](LS &self) {
+                 auto level = [&]() {
+                     const py::gil_scoped_release release;
+                     return self.next();
+                 }();
+                 return py::make_tuple(level.seed, std::move(level.board_str), std::move(level.state));
+             })
+        .def("try_next",
+             [](LS &self) -> py::object {
+                 auto level = self.try_next();
+                 if (!level) {
+                     return py::none();
+                 }
+                 return py::make_tuple(level->seed, std::move(level->board_str), std::move(level->state));
+             })
+        .def_property_readonly("ready", [](const LS &self) { return self.ready(); })
+        .def_property_readonly("waits", [](const LS &self) { return self.waits(); })
+        .def_property_readonly("rejected", [](const LS &self) { return self.rejected(); });
+
+    using OC = boulderdash::ObservationCache;
+    py::class_<OC>(m, "ObservationCache")
+        .def(py::init<std::size_t>(), py::arg("capacity"))
+        .def(py::init<std::size_t, std::size_t>(), py::arg("capacity"), py::arg("num_shards"))
+        .def("get",
+             [](OC &self, const T &state) {
+                 const auto obs = self.get(state);
+                 const auto obs_shape = state.observation_shape();
+                 py::array_t<int8_t> out({obs_shape[1], obs_shape[2]});
+                 std::copy(obs->begin(), obs->end(), out.mutable_data());
+                 return out;
+             })
+        .def("clear", &OC::clear)
+        .def("size", &OC::size)
+        .def_property_readonly("capacity", &OC::capacity)
+        .def_property_readonly("hits", &OC::hits)
+        .def_property_readonly("misses", &OC::misses);
+
+    using OE = boulderdash::ObservationEncoder;
+    py::class_<OE>(m, "ObservationEncoder")
+        .def(py::init<int, int, uint32_t>(), py::arg("rows"), py::arg("cols"), py::arg("keyframe_interval") = 64)
+        .def("append",
+             [](OE &self, const py::array_t<int8_t, py::array::c_style | py::array::forcecast> &frame) {
+                 self.append({frame.data(), static_cast<std::size_t>(frame.size())});
+             })
+        .def("finish",
+             [](OE &self) {
+                 const auto data = self.finish();
+                 return py::bytes(reinterpret_cast<const char *>(data.data()), data.size());    // NOLINT
+             })
+        .def_property_readonly("num_frames", &OE::num_frames)
+        .def_property_readonly("encoded_size", &OE::encoded_size);
+
+    using OD = boulderdash::ObservationDecoder;
+    py::class_<OD>(m, "ObservationDecoder")
+        .def(py::init([](const py::bytes &data) {
+                 const auto view = static_cast<std::string_view>(data);
+                 return std::make_unique<OD>(std::vector<uint8_t>(view.begin(), view.end()));
+             }),
+             py::arg("data"))
+        .def("get",
+             [](OD &self, uint64_t frame) {
+                 py::array_t<int8_t> out({self.rows(), self.cols()});
+                 self.decode(frame, {out.mutable_data(), static_cast<std::size_t>(out.size())});
+                 return out;
+             })
+        .def("__len__", &OD::num_frames)
+        .def_property_readonly("rows", &OD::rows)
+        .def_property_readonly("cols", &OD::cols)
+        .def_property_readonly("num_frames", &OD::num_frames);
+
+    using SS = boulderdash::SolutionStore;
+    py::class_<SS::Solution>(m, "Solution")
+        .def_property_readonly("actions",
+                               [](const SS::Solution &self) {
+                                   std::vector<int> actions(self.actions.size());
+                                   std::ranges::transform(self.actions, actions.begin(),
+                                                          [](boulderdash::Action a) { return static_cast<int>(a); });
+                                   return actions;
+                               })
+        .def_property_readonly("solver", [](const SS::Solution &self) { return self.metadata.solver; })
+        .def_property_readonly("expansions", [](const SS::Solution &self) { return self.metadata.expansions; })
+        .def_property_readonly("seconds", [](const SS::Solution &self) { return self.metadata.seconds; })
+        .def_property_readonly("optimal", [](const SS::Solution &self) { return self.metadata.optimal; });
+    py::class_<SS>(m, "SolutionStore")
+        .def(py::init([](const std::string &path, bool writable, std::size_t capacity) {
+                 return std::make_unique<SS>(path, writable ? SS::Mode::kWrite : SS::Mode::kRead, capacity);
+             }),
+             py::arg("path"), py::arg("writable") = false, py::arg("capacity") = SS::DEFAULT_CAPACITY)
+        .def(
+            "put",
+            [](SS &self, uint64_t hash, const std::vector<int> &actions, const std::string &solver,
+               uint64_t expansions, double seconds, bool optimal) {
+                std::vector<boulderdash::Action> solution;
+                solution.reserve(actions.size());
+                for (const int action : actions) {
+                    if (action < 0 || action >= T::action_space_size()) {
+                        throw std::invalid_argument("Invalid action.");
+                    }
+                    solution.push_back(static_cast<boulderdash::Action>(action));
+                }
+                const SS::Metadata metadata{
+                    .solver = solver, .expansions = expansions, .seconds = seconds, .optimal = optimal};
+                const py::gil_scoped_release release;
+                return self.put(hash, solution, metadata);
+            },
+            py::arg("hash"), py::arg("actions"), py::arg("solver") = "", py::arg("expansions") = 0,
+            py::arg("seconds") = 0.0, py::arg("optimal") = false)
+        .def("find", &SS::find, py::arg("hash"))
+        .def("solution_length", &SS::solution_length, py::arg("hash"))
+        .def("__contains__", &SS::contains)
+        .def("__len__", &SS::size)
+        .def("sync", &SS::sync)
+        .def_property_readonly("capacity", &SS::capacity);
+
+    using VS = boulderdash::VisitedSet;
+    py::class_<VS>(m, "VisitedSet")
+        .def(py::init<std::size_t>(), py::arg("memory_bytes"))
+        .def("insert", [](VS &self, const T &state) { return self.insert(state); }, py::arg("state"))
+        .def("insert", [](VS &self, uint64_t hash) { return self.insert(hash); }, py::arg("hash"))
+        .def("contains", [](const VS &self, const T &state) { return self.contains(state); }, py::arg("state"))
+        .def("contains", [](const VS &self, uint64_t hash) { return self.contains(hash); }, py::arg("hash"))
+        .def("estimated_false_positive_rate", &VS::estimated_false_positive_rate)
+        .def("stats",
+             [](const VS &self) {
+                 const auto stats = self.stats();
+                 py::dict out;
+                 out["inserted"] = stats.inserted;
+                 out["rejected"] = stats.rejected;
+                 out["fill"] = stats.fill;
+                 out["false_positive_rate"] = stats.false_positive_rate;
+                 return out;
+             })
+        .def("clear", &VS::clear)
+        .def_property_readonly("memory_bytes", &VS::memory_bytes);
+
+    py::class_<boulderdash::SearchResult>(m, "SearchResult")
+        .def_readonly("solved", &boulderdash::SearchResult::solved)
+        .def_readonly("exhausted", &boulderdash::SearchResult::exhausted)
+        .def_property_readonly("solution",
+                               [](const boulderdash::SearchResult &self) {
+                                   std::vector<int> actions(self.solution.size());
+                                   std::ranges::transform(self.solution, actions.begin(),
+                                                          [](boulderdash::Action a) { return static_cast<int>(a); });
+                                   return actions;
+                               })
+        .def_readonly("expanded", &boulderdash::SearchResult::expanded)
+        .def_readonly("generated", &boulderdash::SearchResult::generated);
+
+    using BFS = boulderdash::BreadthFirstSearch;
+    py::class_<BFS>(m, "BreadthFirstSearch")
+        .def(py::init([](const T &root, const std::string &checkpoint_dir, uint64_t checkpoint_interval) {
+                 return std::make_unique<BFS>(root, boulderdash::SearchOptions{checkpoint_dir, checkpoint_interval});
+             }),
+             py::arg("root"), py::arg("checkpoint_dir") = "", py::arg("checkpoint_interval") = 100000)
+        .def("run", &BFS::run, py::arg("max_expansions") = 0, py::call_guard<py::gil_scoped_release>())
+        .def("checkpoint", [](BFS &self) { self.checkpoint(); })
+        .def(
+            "wait_for_checkpoint", [](BFS &self) { self.wait_for_checkpoint(); },
+            py::call_guard<py::gil_scoped_release>())
+        .def_property_readonly("resumed", [](const BFS &self) { return self.resumed(); })
+        .def_property_readonly("expanded", [](const BFS &self) { return self.expanded(); })
+        .def_property_readonly("generated", [](const BFS &self) { return self.generated(); });
+
+    // The heuristic is a Python callable, so the GIL is held while searching
+    using BeFS = boulderdash::BestFirstSearch;
+    py::class_<BeFS>(m, "BestFirstSearch")
+        .def(py::init([](const T &root, BeFS::Heuristic heuristic, int64_t cost_weight,
+                         const std::string &checkpoint_dir, uint64_t checkpoint_interval) {
+                 return std::make_unique<BeFS>(root, std::move(heuristic), cost_weight,
+                                               boulderdash::SearchOptions{checkpoint_dir, checkpoint_interval});
+             }),
+             py::arg("root"), py::arg("heuristic"), py::arg("cost_weight") = 1, py::arg("checkpoint_dir") = "",
+             py::arg("checkpoint_interval") = 100000)
+        .def("run", &BeFS::run, py::arg("max_expansions") = 0)
+        .def("checkpoint", [](BeFS &self) { self.checkpoint(); })
+        .def(
+            "wait_for_checkpoint", [](BeFS &self) { self.wait_for_checkpoint(); },
+            py::call_guard<py::gil_scoped_release>())
+        .def_property_readonly("resumed", [](const BeFS &self) { return self.resumed(); })
+        .def_property_readonly("expanded", [](const BeFS &self) { return self.expanded(); })
+        .def_property_readonly("generated", [](const BeFS &self) { return self.generated(); });
+
+    py::class_<boulderdash::BeamSearchResult>(m, "BeamSearchResult")
+        .def_readonly("solved", &boulderdash::BeamSearchResult::solved)
+        .def_readonly("timed_out", &boulderdash::BeamSearchResult::timed_out)
+        .def_readonly("exhausted", &boulderdash::BeamSearchResult::exhausted)
+        .def_property_readonly("plan",
+                               [](const boulderdash::BeamSearchResult &self) {
+                                   std::vector<int> actions(self.plan.size());
+                                   std::ranges::transform(self.plan, actions.begin(),
+                                                          [](boulderdash::Action a) { return static_cast<int>(a); });
+                                   return actions;
+                               })
+        .def_readonly("score", &boulderdash::BeamSearchResult::score)
+        .def_readonly("depth", &boulderdash::BeamSearchResult::depth)
+        .def_readonly("expanded", &boulderdash::BeamSearchResult::expanded)
+        .def_readonly("generated", &boulderdash::BeamSearchResult::generated);
+
+    m.def("gem_distance_heuristic", &boulderdash::gem_distance_heuristic, py::arg("state"));
+    // Without a scorer the native heuristic is used. A Python scorer is called once per layer with the list of states,
+    // which are only valid during the call, and returns their scores. The GIL is released while expanding.
+    m.def(
+        "beam_search",
+        [](const T &root, const std::optional<py::function> &scorer, std::size_t width, double time_limit,
+           uint32_t max_depth, int num_threads) {
+            const boulderdash::BeamSearchOptions options{
+                .width = width,
+                .time_limit = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::duration<double>(time_limit)),
+                .max_depth = max_depth,
+                .num_threads = num_threads};
+            const py::gil_scoped_release release;
+            if (!scorer) {
+                return boulderdash::beam_search(root, boulderdash::gem_distance_heuristic, options);
+            }
+            const boulderdash::BeamBatchScorer batch_scorer = [&](std::span<const T *const> states,
+                                                                   std::span<int64_t> scores) {
+                const py::gil_scoped_acquire acquire;
+                py::list py_states;
+                for (const T *state : states) {
+                    py_states.append(py::cast(state, py::return_value_policy::reference));
+                }
+                const auto values = (*scorer)(py_states).cast<std::vector<int64_t>>();
+                if (values.size() != scores.size()) {
+                    throw std::invalid_argument("Scorer must return one score per state.");
+                }
+                std::ranges::copy(values, scores.begin());
+            };
+            return boulderdash::beam_search(root, batch_scorer, options);
+        },
+        py::arg("root"), py::arg("scorer") = py::none(), py::arg("width") = 1000, py::arg("time_limit") = 0.0,
+        py::arg("max_depth") = 0, py::arg("num_threads") = 0);
+
+    m.def("start_trace", &boulderdash::start_trace, py::arg("events_per_thread") = std::size_t{1} << 20);
+    m.def("stop_trace", &boulderdash::stop_trace);
+    m.def("chrome_trace_json", &boulderdash::chrome_trace_json);
+    m.def("write_chrome_trace", &boulderdash::write_chrome_trace, py::arg("path"));
+    m.def("trace_dropped_events", &boulderdash::trace_dropped_events);
+
+    m.def(
+        "render_batch",
+        [](const std::vector<const T *> &states, int sprite_size, int num_threads) {
+            if (!boulderdash::SpriteAtlas::is_valid_sprite_size(sprite_size)) {
+                throw std::invalid_argument("Sprite size must evenly divide 32.");
+            }
+            if (states.empty()) {
+                return py::array_t<uint8_t>({0, 0, 0, boulderdash::SPRITE_CHANNELS});
+            }
+            const auto shape = boulderdash::batch_image_shape(states.size(), *states[0], sprite_size);
+            py::array_t<uint8_t> out({shape[0], shape[1], shape[2], shape[3]});
+            uint8_t *out_ptr = out.mutable_data();
+            {
+                const py::gil_scoped_release release;
+                boulderdash::render_batch(std::span<const T *const>(states), out_ptr, sprite_size, num_threads);
+            }
+            return out;
+        },
+        py::arg("states"), py::arg("sprite_size") = boulderdash::SPRITE_WIDTH, py::arg("num_threads") = 0);
 }
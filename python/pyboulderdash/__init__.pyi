@@ -1,4 +1,5 @@
-from typing import ClassVar
+from collections.abc import Callable
+from typing import ClassVar, overload
 
 import numpy
 from numpy.typing import NDArray
@@ -103,10 +104,15 @@ class GameParameters:
     disable_explosions: bool
     butterfly_explosion_ver: int
     butterfly_move_ver: int
+    chunk_size: int
+    step_threads: int
+    sim_radius: int
 
 class BoulderDashGameState:
     name: ClassVar[str] = ...  # read-only
     num_actions: ClassVar[int] = ...  # read-only
+    num_entity_fields: ClassVar[int] = ...  # read-only
+    grid: NDArray[numpy.int8]  # read-only
     def __init__(self, board_str: str) -> None: ...
     def __copy__(self) -> BoulderDashGameState: ...
     def __deepcopy__(self, arg0: dict) -> BoulderDashGameState: ...
@@ -115,12 +121,198 @@ class BoulderDashGameState:
     def __ne__(self, other: object) -> bool: ...
     def apply_action(self, int: int) -> None: ...
     def is_solution(self) -> bool: ...
+    def is_approximate(self) -> bool: ...
     def observation_shape(self) -> tuple[int, int, int]: ...
     def get_observation(self) -> NDArray[numpy.float32]: ...
+    def get_observation_compact(self) -> NDArray[numpy.int8]: ...
+    def get_entities(
+        self, capacity: int, skip_empty: bool = True, skip_dirt: bool = True, skip_walls: bool = True
+    ) -> tuple[NDArray[numpy.int16], int]: ...
     def image_shape(self) -> tuple[int, int, int]: ...
     def to_image(self) -> NDArray[numpy.uint8]: ...
+    def get_changed_cells(self) -> NDArray[numpy.int32]: ...
     def get_reward_signal(self) -> int: ...
     def get_agent_index(self) -> int: ...
     def agent_alive(self) -> bool: ...
     def agent_in_exit(self) -> bool: ...
     def get_hidden_item(self, idx: int) -> HiddenCellType: ...
+    @overload
+    def get_indices(self, element: HiddenCellType) -> NDArray[numpy.int32]: ...
+    @overload
+    def get_indices(self, elements: list[HiddenCellType]) -> NDArray[numpy.int32]: ...
+    def count_elements(self, elements: list[HiddenCellType]) -> int: ...
+    def has_elements(self, elements: list[HiddenCellType]) -> bool: ...
+    def get_positions(self, element: HiddenCellType) -> NDArray[numpy.int32]: ...
+    def get_agent_position(self) -> NDArray[numpy.int32]: ...
+    def get_element_counts(self) -> NDArray[numpy.int32]: ...
+    def grid_view(self) -> memoryview: ...
+    def __buffer__(self, flags: int) -> memoryview: ...
+
+def grid_query_isa() -> str: ...
+def make_states(
+    levels: list[str], params: GameParameters = ..., num_threads: int = 0
+) -> list[BoulderDashGameState]: ...
+def load_level_file(path: str, params: GameParameters = ..., num_threads: int = 0) -> list[BoulderDashGameState]: ...
+
+class LevelScenario:
+    __members__: ClassVar[dict] = ...  # read-only
+    __entries: ClassVar[dict] = ...
+    kHard: ClassVar[LevelScenario] = ...
+    kOneKey: ClassVar[LevelScenario] = ...
+    kThreeKeys: ClassVar[LevelScenario] = ...
+    def __init__(self, value: int) -> None: ...
+    def __eq__(self, other: object) -> bool: ...
+    def __hash__(self) -> int: ...
+    def __index__(self) -> int: ...
+    def __int__(self) -> int: ...
+    def __ne__(self, other: object) -> bool: ...
+    @property
+    def name(self) -> str: ...
+    @property
+    def value(self) -> int: ...
+
+def generate_level(scenario: LevelScenario, seed: int) -> str: ...
+def goals_reachable(state: BoulderDashGameState) -> bool: ...
+
+class LevelStream:
+    ready: int  # read-only
+    waits: int  # read-only
+    rejected: int  # read-only
+    def __init__(
+        self,
+        scenario: LevelScenario = ...,
+        seed: int = 0,
+        capacity: int = 1024,
+        num_threads: int = 1,
+        require_reachable: bool = True,
+        params: GameParameters = ...,
+    ) -> None: ...
+    def next(self) -> tuple[int, str, BoulderDashGameState]: ...
+    def try_next(self) -> tuple[int, str, BoulderDashGameState] | None: ...
+
+class ObservationCache:
+    capacity: int  # read-only
+    hits: int  # read-only
+    misses: int  # read-only
+    def __init__(self, capacity: int, num_shards: int = ...) -> None: ...
+    def get(self, state: BoulderDashGameState) -> NDArray[numpy.int8]: ...
+    def clear(self) -> None: ...
+    def size(self) -> int: ...
+
+class ObservationEncoder:
+    num_frames: int  # read-only
+    encoded_size: int  # read-only
+    def __init__(self, rows: int, cols: int, keyframe_interval: int = 64) -> None: ...
+    def append(self, frame: NDArray[numpy.int8]) -> None: ...
+    def finish(self) -> bytes: ...
+
+class ObservationDecoder:
+    rows: int  # read-only
+    cols: int  # read-only
+    num_frames: int  # read-only
+    def __init__(self, data: bytes) -> None: ...
+    def get(self, frame: int) -> NDArray[numpy.int8]: ...
+    def __len__(self) -> int: ...
+
+class Solution:
+    actions: list[int]  # read-only
+    solver: str  # read-only
+    expansions: int  # read-only
+    seconds: float  # read-only
+    optimal: bool  # read-only
+
+class SolutionStore:
+    capacity: int  # read-only
+    def __init__(self, path: str, writable: bool = False, capacity: int = ...) -> None: ...
+    def put(
+        self,
+        hash: int,
+        actions: list[int],
+        solver: str = "",
+        expansions: int = 0,
+        seconds: float = 0.0,
+        optimal: bool = False,
+    ) -> bool: ...
+    def find(self, hash: int) -> Solution | None: ...
+    def solution_length(self, hash: int) -> int | None: ...
+    def sync(self) -> None: ...
+    def __contains__(self, hash: int) -> bool: ...
+    def __len__(self) -> int: ...
+
+class VisitedSet:
+    memory_bytes: int  # read-only
+    def __init__(self, memory_bytes: int) -> None: ...
+    @overload
+    def insert(self, state: BoulderDashGameState) -> bool: ...
+    @overload
+    def insert(self, hash: int) -> bool: ...
+    @overload
+    def contains(self, state: BoulderDashGameState) -> bool: ...
+    @overload
+    def contains(self, hash: int) -> bool: ...
+    def estimated_false_positive_rate(self) -> float: ...
+    def stats(self) -> dict[str, int | float]: ...
+    def clear(self) -> None: ...
+
+class SearchResult:
+    solved: bool  # read-only
+    exhausted: bool  # read-only
+    solution: list[int]  # read-only
+    expanded: int  # read-only
+    generated: int  # read-only
+
+class BreadthFirstSearch:
+    resumed: bool  # read-only
+    expanded: int  # read-only
+    generated: int  # read-only
+    def __init__(
+        self, root: BoulderDashGameState, checkpoint_dir: str = "", checkpoint_interval: int = 100000
+    ) -> None: ...
+    def run(self, max_expansions: int = 0) -> SearchResult: ...
+    def checkpoint(self) -> None: ...
+    def wait_for_checkpoint(self) -> None: ...
+
+class BestFirstSearch:
+    resumed: bool  # read-only
+    expanded: int  # read-only
+    generated: int  # read-only
+    def __init__(
+        self,
+        root: BoulderDashGameState,
+        heuristic: Callable[[BoulderDashGameState], int],
+        cost_weight: int = 1,
+        checkpoint_dir: str = "",
+        checkpoint_interval: int = 100000,
+    ) -> None: ...
+    def run(self, max_expansions: int = 0) -> SearchResult: ...
+    def checkpoint(self) -> None: ...
+    def wait_for_checkpoint(self) -> None: ...
+
+class BeamSearchResult:
+    solved: bool  # read-only
+    timed_out: bool  # read-only
+    exhausted: bool  # read-only
+    plan: list[int]  # read-only
+    score: int  # read-only
+    depth: int  # read-only
+    expanded: int  # read-only
+    generated: int  # read-only
+
+def gem_distance_heuristic(state: BoulderDashGameState) -> int: ...
+def beam_search(
+    root: BoulderDashGameState,
+    scorer: Callable[[list[BoulderDashGameState]], list[int] | NDArray[numpy.int64]] | None = None,
+    width: int = 1000,
+    time_limit: float = 0.0,
+    max_depth: int = 0,
+    num_threads: int = 0,
+) -> BeamSearchResult: ...
+
+def start_trace(events_per_thread: int = 1048576) -> None: ...
+def stop_trace() -> None: ...
+def chrome_trace_json() -> str: ...
+def write_chrome_trace(path: str) -> None: ...
+def trace_dropped_events() -> int: ...
+def render_batch(
+    states: list[BoulderDashGameState], sprite_size: int = 32, num_threads: int = 0
+) -> NDArray[numpy.uint8]: ...
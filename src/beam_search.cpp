@@ -0,0 +1,251 @@
+#include "beam_search.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "boulderdash_base.h"
+#include "definitions.h"
+#include "grid_query.h"
+#include "thread_pool.h"
+
+namespace boulderdash {
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+constexpr int64_t kDiamondWeight = 16;
+constexpr uint64_t kNoParent = ~uint64_t{0};
+const ElementSet kDiamonds{HiddenCellType::kDiamond, HiddenCellType::kDiamondFalling};
+const ElementSet kOpenExits{HiddenCellType::kExitOpen};
+
+struct BeamNode {
+    uint64_t parent;
+    Action action;
+};
+
+// Scores children[i] into scores[i], returning false if the deadline passed first
+using ScoreLayerFn = std::function<bool(const std::vector<BoulderDashGameState> &children, std::vector<int64_t> &scores,
+                                        Clock::time_point deadline)>;
+
+// Record the exception of the lowest index, so the error does not depend on the thread count
+class FirstError {
+public:
+    void set(std::size_t index, std::exception_ptr error) {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        if (!error_ || index < index_) {
+            index_ = index;
+            error_ = std::move(error);
+        }
+    }
+    void rethrow() const {
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+    }
+
+private:
+    std::mutex mutex_;
+    std::size_t index_ = 0;
+    std::exception_ptr error_;
+};
+
+auto Plan(const std::vector<BeamNode> &nodes, uint64_t id) -> std::vector<Action> {
+    std::vector<Action> plan;
+    for (; nodes[id].parent != kNoParent; id = nodes[id].parent) {
+        plan.push_back(nodes[id].action);
+    }
+    std::ranges::reverse(plan);
+    return plan;
+}
+
+auto RunBeamSearch(const BoulderDashGameState &root, const ScoreLayerFn &score_layer,
+                   const BeamSearchOptions &options) -> BeamSearchResult {
+    if (options.width == 0) {
+        throw std::invalid_argument("Beam width must be positive");
+    }
+    const auto deadline = options.time_limit.count() > 0 ? Clock::now() + options.time_limit : Clock::time_point::max();
+
+    BeamSearchResult result;
+    std::vector<BeamNode> nodes{{kNoParent, Action::kUp}};    // Root action is unused
+    std::unordered_set<uint64_t> visited{root.get_hash()};
+    std::vector<BoulderDashGameState> beam{root};
+    std::vector<uint64_t> beam_ids{0};
+    uint64_t best_id = 0;
+    result.generated = 1;
+    const auto finish = [&](uint64_t id, int64_t score) {
+        result.plan = Plan(nodes, id);
+        result.score = score;
+        return result;
+    };
+
+    // Solutions are returned before scoring, as they need no score
+    if (root.is_solution()) {
+        result.solved = true;
+        return finish(0, 0);
+    }
+    std::vector<int64_t> scores;
+    if (!score_layer(beam, scores, deadline)) {
+        result.timed_out = true;
+        return finish(0, 0);
+    }
+    int64_t best_score = scores[0];
+
+    std::vector<std::optional<BoulderDashGameState>> expansions;
+    std::vector<BoulderDashGameState> children;
+    std::vector<uint64_t> child_ids;
+    std::vector<std::size_t> order;
+    while (options.max_depth == 0 || result.depth < options.max_depth) {
+        // Expand the beam in parallel, each parent into its own slots
+        expansions.assign(beam.size() * ALL_ACTIONS.size(), std::nullopt);
+        std::atomic<bool> out_of_time = false;
+        ThreadPool::global().parallel_for(
+            beam.size(),
+            [&](std::size_t i) {
+                if (out_of_time.load(std::memory_order_relaxed) || Clock::now() > deadline) {
+                    out_of_time.store(true, std::memory_order_relaxed);
+                    return;
+                }
+                for (std::size_t a = 0; a < ALL_ACTIONS.size(); ++a) {
+                    BoulderDashGameState child = beam[i];
+                    child.apply_action(ALL_ACTIONS[a]);
+                    if (!child.is_terminal() || child.is_solution()) {
+                        expansions[(i * ALL_ACTIONS.size()) + a].emplace(std::move(child));
+                    }
+                }
+            },
+            options.num_threads);
+        if (out_of_time) {
+            result.timed_out = true;
+            break;
+        }
+        result.expanded += beam.size();
+
+        // Deduplicate in generation order, so the layer is the same whatever the thread count
+        children.clear();
+        child_ids.clear();
+        for (std::size_t slot = 0; slot < expansions.size(); ++slot) {
+            auto &child = expansions[slot];
+            if (!child || !visited.insert(child->get_hash()).second) {
+                continue;
+            }
+            const std::size_t parent = slot / ALL_ACTIONS.size();
+            nodes.push_back({beam_ids[parent], ALL_ACTIONS[slot % ALL_ACTIONS.size()]});
+            child_ids.push_back(nodes.size() - 1);
+            children.push_back(std::move(*child));
+        }
+        if (children.empty()) {
+            result.exhausted = true;
+            break;
+        }
+        for (std::size_t i = 0; i < children.size(); ++i) {
+            if (children[i].is_solution()) {
+                result.solved = true;
+                ++result.depth;
+                return finish(child_ids[i], 0);
+            }
+        }
+        if (!score_layer(children, scores, deadline)) {
+            result.timed_out = true;
+            break;
+        }
+        result.generated += children.size();
+        ++result.depth;
+
+        order.resize(children.size());
+        std::iota(order.begin(), order.end(), std::size_t{0});
+        const auto key = [&](std::size_t i) { return std::pair(scores[i], i); };
+        const std::size_t keep = std::min(options.width, children.size());
+        std::ranges::partial_sort(order, order.begin() + static_cast<std::ptrdiff_t>(keep), {}, key);
+        order.resize(keep);
+        if (scores[order[0]] < best_score) {
+            best_score = scores[order[0]];
+            best_id = child_ids[order[0]];
+        }
+
+        beam.clear();
+        beam_ids.clear();
+        for (const std::size_t i : order) {
+            beam.push_back(std::move(children[i]));
+            beam_ids.push_back(child_ids[i]);
+        }
+    }
+    return finish(best_id, best_score);
+}
+}    // namespace
+
+auto gem_distance_heuristic(const BoulderDashGameState &state) -> int64_t {
+    const auto [agent_row, agent_col] = state.index_to_position(state.get_agent_index());
+    const auto nearest = [&](const std::vector<int> &indices) {
+        int64_t distance = 0;
+        for (std::size_t i = 0; i < indices.size(); ++i) {
+            const auto [row, col] = state.index_to_position(indices[i]);
+            const int64_t d = std::abs(agent_row - row) + std::abs(agent_col - col);
+            distance = i == 0 ? d : std::min(distance, d);
+        }
+        return distance;
+    };
+    if (const auto exits = state.get_indices(kOpenExits); !exits.empty()) {
+        return nearest(exits);
+    }
+    const auto diamonds = state.get_indices(kDiamonds);
+    return (kDiamondWeight * static_cast<int64_t>(diamonds.size())) + nearest(diamonds);
+}
+
+auto beam_search(const BoulderDashGameState &root, const BeamHeuristic &heuristic, const BeamSearchOptions &options)
+    -> BeamSearchResult {
+    const auto score_layer = [&](const std::vector<BoulderDashGameState> &children, std::vector<int64_t> &scores,
+                                 Clock::time_point deadline) {
+        scores.resize(children.size());
+        std::atomic<bool> out_of_time = false;
+        FirstError error;
+        ThreadPool::global().parallel_for(
+            children.size(),
+            [&](std::size_t i) {
+                if (out_of_time.load(std::memory_order_relaxed) || Clock::now() > deadline) {
+                    out_of_time.store(true, std::memory_order_relaxed);
+                    return;
+                }
+                try {
+                    scores[i] = heuristic(children[i]);
+                } catch (...) {
+                    error.set(i, std::current_exception());
+                }
+            },
+            options.num_threads);
+        error.rethrow();
+        return !out_of_time;
+    };
+    return RunBeamSearch(root, score_layer, options);
+}
+
+auto beam_search(const BoulderDashGameState &root, const BeamBatchScorer &scorer, const BeamSearchOptions &options)
+    -> BeamSearchResult {
+    std::vector<const BoulderDashGameState *> pointers;
+    const auto score_layer = [&](const std::vector<BoulderDashGameState> &children, std::vector<int64_t> &scores,
+                                 Clock::time_point deadline) {
+        pointers.clear();
+        for (const auto &child : children) {
+            pointers.push_back(&child);
+        }
+        scores.assign(children.size(), 0);
+        scorer(pointers, scores);
+        return Clock::now() <= deadline;
+    };
+    return RunBeamSearch(root, score_layer, options);
+}
+
+}    // namespace boulderdash
@@ -0,0 +1,79 @@
+#ifndef BOULDERDASH_BEAM_SEARCH_H_
+#define BOULDERDASH_BEAM_SEARCH_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+
+#include "boulderdash_base.h"
+#include "definitions.h"
+
+namespace boulderdash {
+
+struct BeamSearchOptions {
+    std::size_t width = 1000;                   // States kept in each layer
+    std::chrono::milliseconds time_limit{0};    // Wall clock budget, 0 for no limit
+    uint32_t max_depth = 0;                     // Layers after which to stop, 0 for no limit
+    int num_threads = 0;                        // Threads expanding each layer, including the caller, 0 for all
+};
+
+struct BeamSearchResult {
+    bool solved = false;
+    bool timed_out = false;      // The time limit ran out before a solution was found
+    bool exhausted = false;      // The beam ran out of new states
+    std::vector<Action> plan;    // Actions to the solution, or to the best scored state found if not solved
+    int64_t score = 0;           // Score of the state the plan leads to, 0 for a solution as it is not scored
+    uint32_t depth = 0;          // Layers fully expanded
+    uint64_t expanded = 0;
+    uint64_t generated = 0;      // Distinct states scored, including the root
+};
+
+// Scores a state, lower is better. Called from several threads at once, so it must be thread safe.
+using BeamHeuristic = std::function<int64_t(const BoulderDashGameState &)>;
+// Scores a whole layer at once, writing scores[i] for states[i], lower is better. Called on the calling thread only,
+// for scorers with a high per call cost such as a neural network.
+using BeamBatchScorer =
+    std::function<void(std::span<const BoulderDashGameState *const> states, std::span<int64_t> scores)>;
+
+/**
+ * Heuristic for reaching the exit: while the exit is closed, 16 per diamond left on the board plus the Manhattan
+ * distance from the agent to the nearest diamond, then the distance to the nearest open exit.
+ * @param state The state to score
+ */
+[[nodiscard]] auto gem_distance_heuristic(const BoulderDashGameState &state) -> int64_t;
+
+// Anytime beam search.
+// Each layer expands every state of the beam in parallel, drops dead states and states with a hash seen in this or
+// an earlier layer, and keeps the width best scored children, ties broken by generation order so the result does
+// not depend on the thread count. The search stops at the first layer holding a solution, before scoring that layer.
+// If the time limit runs out first, the layer being built is dropped and the plan to the best scored state found so
+// far is returned.
+
+/**
+ * Beam search with a per state heuristic, scored in parallel with the expansion.
+ * @param root The state to search from
+ * @param heuristic State score, lower is better
+ * @param options Beam width and limits
+ * @throw std::invalid_argument if the width is zero
+ * @throw Any exception thrown by the heuristic
+ */
+[[nodiscard]] auto beam_search(const BoulderDashGameState &root, const BeamHeuristic &heuristic,
+                               const BeamSearchOptions &options = {}) -> BeamSearchResult;
+
+/**
+ * Beam search with a batched scorer, called once per layer.
+ * @param root The state to search from
+ * @param scorer Layer scorer, lower is better
+ * @param options Beam width and limits
+ * @throw std::invalid_argument if the width is zero
+ * @throw Any exception thrown by the scorer
+ */
+[[nodiscard]] auto beam_search(const BoulderDashGameState &root, const BeamBatchScorer &scorer,
+                               const BeamSearchOptions &options = {}) -> BeamSearchResult;
+
+}    // namespace boulderdash
+
+#endif    // BOULDERDASH_BEAM_SEARCH_H_
@@ -2,19 +2,27 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <format>
 #include <iostream>
+#include <limits>
 #include <ranges>
+#include <span>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
 #include "definitions.h"
+#include "render.h"
+#include "thread_pool.h"
+#include "trace.h"
 #include "util.h"
 
 namespace boulderdash {
@@ -69,6 +77,92 @@ auto to_local_hash(int flat_size, HiddenCellType el, int offset) noexcept -> uin
     result = (result ^ (result >> SPLIT64_S2)) * SPLIT64_C3;
     return result ^ (result >> SPLIT64_S3);
 }
+
+// Salt mixed into the hash of approximate (sim_radius) states, so they never match exact states
+auto window_hash_salt(int sim_radius) noexcept -> uint64_t {
+    return splitmix64(~static_cast<uint64_t>(sim_radius));
+}
+
+// Direction encoded in the hidden type for compound elements, -1 if none
+auto entity_direction(HiddenCellType el) noexcept -> int16_t {
+    const Element &element = kCellTypeToElement[static_cast<std::size_t>(el) + 1];    // NOLINT(*-array-index)
+    if (IsFirefly(element)) {
+        return static_cast<int16_t>(kFireflyToDirection.at(element));
+    } else if (IsButterfly(element)) {
+        return static_cast<int16_t>(kButterflyToDirection.at(element));
+    } else if (IsOrange(element)) {
+        return static_cast<int16_t>(kOrangeToDirection.at(element));
+    }
+    return -1;
+}
+
+auto entity_is_falling(HiddenCellType el) noexcept -> bool {
+    return el == HiddenCellType::kStoneFalling || el == HiddenCellType::kDiamondFalling ||
+           el == HiddenCellType::kNutFalling || el == HiddenCellType::kBombFalling;
+}
+
+// Elements whose update depends on more than their neighbouring cells, so their chunk can never be skipped
+auto is_always_updated(HiddenCellType el) noexcept -> bool {
+    switch (el) {
+        case HiddenCellType::kStoneFalling:
+        case HiddenCellType::kDiamondFalling:
+        case HiddenCellType::kNutFalling:
+        case HiddenCellType::kBombFalling:
+        case HiddenCellType::kExitClosed:
+        case HiddenCellType::kBlob:
+        case HiddenCellType::kExplosionDiamond:
+        case HiddenCellType::kExplosionBoulder:
+        case HiddenCellType::kExplosionEmpty:
+            return true;
+        default:
+            return false;
+    }
+}
+
+auto is_magic_wall(HiddenCellType el) noexcept -> bool {
+    return el == HiddenCellType::kWallMagicDormant || el == HiddenCellType::kWallMagicOn ||
+           el == HiddenCellType::kWallMagicExpired;
+}
+
+// Elements which consume the rng or read flags other cells set during the scan, so the scan must stay sequential.
+// Magic walls are included as an element falling into one can switch the state of every wall mid scan.
+auto requires_sequential_scan(HiddenCellType el) noexcept -> bool {
+    switch (el) {
+        case HiddenCellType::kWallMagicDormant:
+        case HiddenCellType::kWallMagicOn:
+        case HiddenCellType::kWallMagicExpired:
+        case HiddenCellType::kBlob:
+        case HiddenCellType::kOrangeUp:
+        case HiddenCellType::kOrangeLeft:
+        case HiddenCellType::kOrangeDown:
+        case HiddenCellType::kOrangeRight:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Columns a wavefront row stays behind the row above it.
+// A cell update reads and writes at most one column either side of the cell (chains aside), so rows this far
+// apart never touch the same cells and the result matches the row-major scan.
+constexpr int kWavefrontLag = 3;
+// Columns a wavefront row completes between progress updates
+constexpr int kWavefrontProgressStride = 16;
+
+// Results of a row stepped by a wavefront worker, merged in row order once every row is done
+struct WavefrontRow {
+    uint64_t hash = 0;
+    uint64_t reward_signal = 0;
+    bool agent_died = false;
+    std::vector<BoulderDashGameState::CellChange> changed_cells;
+    std::atomic<bool> *chain_found = nullptr;
+};
+
+// Row the current thread is stepping, nullptr outside of a wavefront scan
+thread_local WavefrontRow *wavefront_row = nullptr;
+
+// Largest number of rows or columns, and sim radius, which fit the 16 bit fields of StateCore
+constexpr int kMaxBoardSide = std::numeric_limits<int16_t>::max();
 }    // namespace
 
 void BoulderDashGameState::parse_board_str(const std::string &board_str) {
@@ -80,12 +174,23 @@ void BoulderDashGameState::parse_board_str(const std::string &board_str) {
         seglist.push_back(segment);
     }
 
-    assert(seglist.size() >= 4);
+    if (seglist.size() < 4) {
+        throw std::invalid_argument("Board string is missing the size, gems required or cells");
+    }
 
     // Get general info
-    rows = std::stoi(seglist[0]);
-    cols = std::stoi(seglist[1]);
-    assert(seglist.size() == static_cast<std::size_t>(rows * cols) + 3);
+    const int num_rows = std::stoi(seglist[0]);
+    const int num_cols = std::stoi(seglist[1]);
+    if (num_rows <= 0 || num_cols <= 0 || num_rows > kMaxBoardSide || num_cols > kMaxBoardSide) {
+        throw std::invalid_argument(std::format("Invalid board size ({:d}, {:d}), expected 1 to {:d} rows and columns",
+                                                num_rows, num_cols, kMaxBoardSide));
+    }
+    rows = static_cast<int16_t>(num_rows);
+    cols = static_cast<int16_t>(num_cols);
+    if (seglist.size() != static_cast<std::size_t>(rows * cols) + 3) {
+        throw std::invalid_argument(std::format("Board string has {:d} cells, expected {:d} for size ({:d}, {:d})",
+                                                seglist.size() - 3, rows * cols, num_rows, num_cols));
+    }
     gems_required = std::stoi(seglist[2]);
 
     // Parse grid
@@ -97,7 +202,7 @@ void BoulderDashGameState::parse_board_str(const std::string &board_str) {
         }
         const auto el = static_cast<HiddenCellType>(hidden_type);
         grid.push_back(el);
-        has_updated.push_back(false);
+        updated_epoch.push_back(0);
         // Really shouldn't be creating a state with the agent in the exit
         if (el == HiddenCellType::kAgent || el == HiddenCellType::kAgentInExit) {
             agent_idx = static_cast<int>(i) - 3;
@@ -115,13 +220,16 @@ void BoulderDashGameState::parse_board_str(const std::string &board_str) {
 }
 
 BoulderDashGameState::BoulderDashGameState(const std::string &board_str, const GameParameters &params)
-    : magic_wall_steps(params.magic_wall_steps),
-      butterfly_explosion_ver(params.butterfly_explosion_ver),
-      butterfly_move_ver(params.butterfly_move_ver),
-      random_state(splitmix64(0)),
-      blob_chance(params.blob_chance),
-      gravity(params.gravity),
-      disable_explosions(params.disable_explosions) {
+    : StateCore{
+          .random_state = splitmix64(0),
+          .magic_wall_steps = params.magic_wall_steps,
+          .butterfly_explosion_ver = static_cast<int8_t>(params.butterfly_explosion_ver),
+          .butterfly_move_ver = static_cast<int8_t>(params.butterfly_move_ver),
+          .blob_chance = static_cast<uint8_t>(params.blob_chance),
+          .gravity = params.gravity,
+          .disable_explosions = params.disable_explosions,
+      },
+      step_threads(params.step_threads) {
     parse_board_str(board_str);
 
     blob_max_size = static_cast<int>(static_cast<float>(cols * rows) * params.blob_max_percentage);
@@ -131,107 +239,313 @@ BoulderDashGameState::BoulderDashGameState(const std::string &board_str, const G
     for (int i : std::views::iota(0, flat_size)) {
         hash ^= to_local_hash(flat_size, grid[static_cast<std::size_t>(i)], i);
     }
+
+    chunk_size = params.chunk_size;
+    InitChunks();
+    num_sequential_only = static_cast<int>(std::ranges::count_if(grid, requires_sequential_scan));
+    InitWindow(params.sim_radius);
+    if (sim_radius > 0) {
+        hash ^= window_hash_salt(sim_radius);
+    }
 }
 
 BoulderDashGameState::BoulderDashGameState(InternalState &&internal_state)
-    : magic_wall_steps(internal_state.magic_wall_steps),
-      blob_max_size(internal_state.blob_max_size),
-      butterfly_explosion_ver(internal_state.butterfly_explosion_ver),
-      butterfly_move_ver(internal_state.butterfly_move_ver),
-      gems_collected(internal_state.gems_collected),
-      magic_wall_steps_remaining(internal_state.magic_wall_steps_remaining),
-      blob_size(internal_state.blob_size),
-      rows(internal_state.rows),
-      cols(internal_state.cols),
-      agent_idx(internal_state.agent_idx),
-      gems_required(internal_state.gems_required),
-      random_state(internal_state.random_state),
-      reward_signal(internal_state.reward_signal),
-      hash(internal_state.hash),
-      blob_chance(internal_state.blob_chance),
-      gravity(internal_state.gravity),
-      disable_explosions(internal_state.disable_explosions),
-      magic_active(internal_state.magic_active),
-      blob_enclosed(internal_state.blob_enclosed),
-      is_agent_alive(internal_state.is_agent_alive),
-      is_agent_in_exit(internal_state.is_agent_in_exit),
-      blob_swap(static_cast<HiddenCellType>(internal_state.blob_swap)),
-      has_updated(std::move(internal_state).has_updated) {
+    : StateCore{
+          .random_state = internal_state.random_state,
+          .reward_signal = internal_state.reward_signal,
+          .hash = internal_state.hash,
+          .magic_wall_steps = internal_state.magic_wall_steps,
+          .magic_wall_steps_remaining = internal_state.magic_wall_steps_remaining,
+          .blob_max_size = internal_state.blob_max_size,
+          .blob_size = internal_state.blob_size,
+          .gems_collected = internal_state.gems_collected,
+          .gems_required = internal_state.gems_required,
+          .agent_idx = internal_state.agent_idx,
+          .rows = static_cast<int16_t>(internal_state.rows),
+          .cols = static_cast<int16_t>(internal_state.cols),
+          .butterfly_explosion_ver = static_cast<int8_t>(internal_state.butterfly_explosion_ver),
+          .butterfly_move_ver = static_cast<int8_t>(internal_state.butterfly_move_ver),
+          .blob_chance = internal_state.blob_chance,
+          .blob_swap = static_cast<HiddenCellType>(internal_state.blob_swap),
+          .gravity = internal_state.gravity,
+          .disable_explosions = internal_state.disable_explosions,
+          .magic_active = internal_state.magic_active,
+          .blob_enclosed = internal_state.blob_enclosed,
+          .is_agent_alive = internal_state.is_agent_alive,
+          .is_agent_in_exit = internal_state.is_agent_in_exit,
+      },
+      step_threads(internal_state.step_threads) {
     grid.clear();
     grid.reserve(internal_state.grid.size());
     for (const auto &el : internal_state.grid) {
         grid.push_back(static_cast<HiddenCellType>(el));
     }
+    updated_epoch.reserve(internal_state.has_updated.size());
+    for (const bool marked : internal_state.has_updated) {
+        updated_epoch.push_back(marked ? scan_epoch : 0);
+    }
+    chunk_size = internal_state.chunk_size;
+    InitChunks();
+    num_sequential_only = static_cast<int>(std::ranges::count_if(grid, requires_sequential_scan));
+    InitWindow(internal_state.sim_radius);
+}
+
+auto BoulderDashGameState::operator==(const BoulderDashGameState &other) const -> bool {
+    // changed_cells, the chunks and step_threads only describe how the state is stepped, so they are not compared
+    return std::memcmp(static_cast<const StateCore *>(this), static_cast<const StateCore *>(&other),
+                       sizeof(StateCore)) == 0 &&
+           SameBoard(other);
 }
 
 // ---------------------------------------------------------------------------
 
 void BoulderDashGameState::apply_action(Action action) {
     assert(is_valid_action(action));
-    StartScan();
+    const TraceSpan step_span(TracePhase::kStep);
+    {
+        const TraceSpan span(TracePhase::kStartScan);
+        StartScan();
+    }
 
     // Handle agent first
     const Direction action_direction = action_to_direction(action);
-    UpdateAgent(agent_idx, action_direction);
+    {
+        const TraceSpan span(TracePhase::kAgentUpdate);
+        UpdateAgent(agent_idx, action_direction);
+    }
 
     // Handle all other items
-    for (int i : std::views::iota(0, rows * cols)) {
-        if (has_updated[static_cast<std::size_t>(i)]) {    // Item already updated
-            continue;
+    {
+        const TraceSpan span(TracePhase::kElementScan);
+        if (sim_radius > 0) {
+            ScanWindow();
+        } else if (step_threads <= 1 || !ScanWavefront()) {
+            ScanSequential();
         }
-        const auto &hidden_el = grid[static_cast<std::size_t>(i)];
-        switch (hidden_el) {
-            // Handle non-compound types
-            case HiddenCellType::kStone:
-                UpdateStone(i);
-                break;
-            case HiddenCellType::kStoneFalling:
-                UpdateStoneFalling(i);
-                break;
-            case HiddenCellType::kDiamond:
-                UpdateDiamond(i);
-                break;
-            case HiddenCellType::kDiamondFalling:
-                UpdateDiamondFalling(i);
-                break;
-            case HiddenCellType::kNut:
-                UpdateNut(i);
-                break;
-            case HiddenCellType::kNutFalling:
-                UpdateNutFalling(i);
-                break;
-            case HiddenCellType::kBomb:
-                UpdateBomb(i);
-                break;
-            case HiddenCellType::kBombFalling:
-                UpdateBombFalling(i);
-                break;
-            case HiddenCellType::kExitClosed:
-                UpdateExit(i);
-                break;
-            case HiddenCellType::kBlob:
-                UpdateBlob(i);
-                break;
-            default:
-                // Handle compound types
-                // NOLINTNEXTLINE(*-bounds-constant-array-index)
-                const Element &element = kCellTypeToElement[static_cast<std::size_t>(hidden_el) + 1];
-                if (IsButterfly(element)) {
-                    UpdateButterfly(i, kButterflyToDirection.at(element));
-                } else if (IsFirefly(element)) {
-                    UpdateFirefly(i, kFireflyToDirection.at(element));
-                } else if (IsOrange(element)) {
-                    UpdateOrange(i, kOrangeToDirection.at(element));
-                } else if (IsMagicWall(element)) {
-                    UpdateMagicWall(i);
-                } else if (IsExplosion(element)) {
-                    UpdateExplosions(i);
+    }
+
+    const TraceSpan span(TracePhase::kEndScan);
+    EndScan();
+}
+
+consteval auto BoulderDashGameState::MakeCellBehaviours() -> std::array<CellBehaviour, kNumHiddenCellType + 1> {
+    std::array<CellBehaviour, kNumHiddenCellType + 1> behaviours{};
+    const auto set = [&behaviours](HiddenCellType el, UpdateHandler update, Direction direction = Direction::kNoop) {
+        behaviours[static_cast<std::size_t>(el) + 1] = {.update = update, .direction = direction};
+    };
+    using T = BoulderDashGameState;
+    using H = HiddenCellType;
+    // The agent is updated before the scan, so it is not listed
+    set(H::kStone, &T::UpdateUndirected<&T::UpdateStone>);
+    set(H::kStoneFalling, &T::UpdateUndirected<&T::UpdateStoneFalling>);
+    set(H::kDiamond, &T::UpdateUndirected<&T::UpdateDiamond>);
+    set(H::kDiamondFalling, &T::UpdateUndirected<&T::UpdateDiamondFalling>);
+    set(H::kNut, &T::UpdateUndirected<&T::UpdateNut>);
+    set(H::kNutFalling, &T::UpdateUndirected<&T::UpdateNutFalling>);
+    set(H::kBomb, &T::UpdateUndirected<&T::UpdateBomb>);
+    set(H::kBombFalling, &T::UpdateUndirected<&T::UpdateBombFalling>);
+    set(H::kExitClosed, &T::UpdateUndirected<&T::UpdateExit>);
+    set(H::kBlob, &T::UpdateUndirected<&T::UpdateBlob>);
+    set(H::kExplosionDiamond, &T::UpdateUndirected<&T::UpdateExplosions>);
+    set(H::kExplosionBoulder, &T::UpdateUndirected<&T::UpdateExplosions>);
+    set(H::kExplosionEmpty, &T::UpdateUndirected<&T::UpdateExplosions>);
+    set(H::kWallMagicDormant, &T::UpdateUndirected<&T::UpdateMagicWall>);
+    set(H::kWallMagicOn, &T::UpdateUndirected<&T::UpdateMagicWall>);
+    set(H::kWallMagicExpired, &T::UpdateUndirected<&T::UpdateMagicWall>);
+    set(H::kFireflyUp, &T::UpdateFirefly, Direction::kUp);
+    set(H::kFireflyLeft, &T::UpdateFirefly, Direction::kLeft);
+    set(H::kFireflyDown, &T::UpdateFirefly, Direction::kDown);
+    set(H::kFireflyRight, &T::UpdateFirefly, Direction::kRight);
+    set(H::kButterflyUp, &T::UpdateButterfly, Direction::kUp);
+    set(H::kButterflyLeft, &T::UpdateButterfly, Direction::kLeft);
+    set(H::kButterflyDown, &T::UpdateButterfly, Direction::kDown);
+    set(H::kButterflyRight, &T::UpdateButterfly, Direction::kRight);
+    set(H::kOrangeUp, &T::UpdateOrange, Direction::kUp);
+    set(H::kOrangeLeft, &T::UpdateOrange, Direction::kLeft);
+    set(H::kOrangeDown, &T::UpdateOrange, Direction::kDown);
+    set(H::kOrangeRight, &T::UpdateOrange, Direction::kRight);
+    return behaviours;
+}
+
+constinit const std::array<BoulderDashGameState::CellBehaviour, kNumHiddenCellType + 1>
+    BoulderDashGameState::kCellBehaviours = MakeCellBehaviours();
+
+void BoulderDashGameState::UpdateCell(int index) noexcept {
+    if (updated_epoch[static_cast<std::size_t>(index)] == scan_epoch) {    // Item already updated
+        return;
+    }
+    // NOLINTNEXTLINE(*-bounds-constant-array-index)
+    const CellBehaviour &behaviour =
+        kCellBehaviours[static_cast<std::size_t>(grid[static_cast<std::size_t>(index)]) + 1];
+    if (behaviour.update != nullptr) {
+        (this->*behaviour.update)(index, behaviour.direction);
+    }
+}
+
+void BoulderDashGameState::ScanSequential() noexcept {
+    if (chunk_size > 0) {
+        // Same row-major order, but row segments inside dormant chunks are skipped
+        for (int row : std::views::iota(0, rows)) {
+            const int chunk_row = row / chunk_size;
+            for (int chunk_col : std::views::iota(0, chunk_cols)) {
+                if (!IsChunkActive(chunk_row * chunk_cols + chunk_col)) {
+                    continue;
                 }
-                break;
+                const int col_end = std::min<int>(cols, (chunk_col + 1) * chunk_size);
+                for (int col : std::views::iota(chunk_col * chunk_size, col_end)) {
+                    UpdateCell(row * cols + col);
+                }
+            }
+        }
+    } else {
+        for (int i : std::views::iota(0, rows * cols)) {
+            UpdateCell(i);
         }
     }
+}
 
-    EndScan();
+void BoulderDashGameState::ScanWindow() noexcept {
+    // Window around the agent, everything else stays frozen apart from explosions which always finish
+    const int agent_row = agent_idx / cols;
+    const int agent_col = agent_idx % cols;
+    const int row_begin = std::max(agent_row - sim_radius, 0);
+    const int row_end = std::min<int>(agent_row + sim_radius + 1, rows);
+    const int col_begin = std::max(agent_col - sim_radius, 0);
+    const int col_end = std::min<int>(agent_col + sim_radius + 1, cols);
+    const auto in_window = [&](int index) {
+        const int row = index / cols;
+        const int col = index % cols;
+        return row >= row_begin && row < row_end && col >= col_begin && col < col_end;
+    };
+
+    // Step explosions outside of the window at their place in the row-major order
+    std::erase_if(window_explosions, in_window);
+    auto next_explosion = window_explosions.begin();
+    const auto update_explosions_before = [&](int index) {
+        for (; next_explosion != window_explosions.end() && *next_explosion < index; ++next_explosion) {
+            if (IsExplosion(GetItem(*next_explosion))) {
+                UpdateCell(*next_explosion);
+            }
+        }
+    };
+    for (int row : std::views::iota(row_begin, row_end)) {
+        for (int col : std::views::iota(col_begin, col_end)) {
+            update_explosions_before(row * cols + col);
+            UpdateCell(row * cols + col);
+        }
+    }
+    update_explosions_before(rows * cols);
+
+    // Explosions only last a step, so the ones left on the board were all written during this step
+    window_explosions.clear();
+    for (const auto &change : changed_cells) {
+        if (IsExplosion(GetItem(change.index))) {
+            window_explosions.push_back(change.index);
+        }
+    }
+    std::ranges::sort(window_explosions);
+    const auto duplicates = std::ranges::unique(window_explosions);
+    window_explosions.erase(duplicates.begin(), duplicates.end());
+}
+
+auto BoulderDashGameState::ScanWavefront() -> bool {
+    if (rows < 2 || num_sequential_only > 0) {
+        return false;
+    }
+
+    // Row r may update column c once row r - 1 is done with column c + kWavefrontLag - 1
+    struct alignas(64) RowProgress {
+        std::atomic<int> done = 0;
+    };
+    std::vector<RowProgress> progress(static_cast<std::size_t>(rows));
+    std::vector<WavefrontRow> row_results(static_cast<std::size_t>(rows));
+    std::atomic<bool> chain_found = false;
+
+    // Cells marked by the agent update, restored if the scan has to be undone
+    std::vector<int> agent_marked;
+    for (const auto &change : changed_cells) {
+        if (updated_epoch[static_cast<std::size_t>(change.index)] == scan_epoch) {
+            agent_marked.push_back(change.index);
+        }
+    }
+
+    const int segment_size = (chunk_size > 0) ? chunk_size : cols;
+    ThreadPool::global().parallel_for(
+        static_cast<std::size_t>(rows),
+        [&](std::size_t row) {
+            WavefrontRow &result = row_results[row];
+            result.chain_found = &chain_found;
+            wavefront_row = &result;
+            int above_done = (row == 0) ? cols : 0;
+            // Wait for the row above to finish up to col, false if the scan is being abandoned
+            const auto wait_above = [&](int col) -> bool {
+                const int needed = std::min<int>(col, cols);
+                while (above_done < needed) {
+                    above_done = progress[row - 1].done.load(std::memory_order_acquire);
+                    if (above_done < needed) {
+                        if (chain_found.load(std::memory_order_relaxed)) {
+                            return false;
+                        }
+                        std::this_thread::yield();
+                    }
+                }
+                return true;
+            };
+            for (int begin = 0; begin < cols; begin += segment_size) {
+                const int end = std::min<int>(begin + segment_size, cols);
+                if (chunk_size > 0) {
+                    // Every write the sequential scan makes before reaching this chunk must have landed first
+                    if (!wait_above(end + kWavefrontLag - 1)) {
+                        break;
+                    }
+                    if (!IsChunkActive((static_cast<int>(row) / chunk_size) * chunk_cols + begin / chunk_size)) {
+                        progress[row].done.store(end, std::memory_order_release);
+                        continue;
+                    }
+                }
+                for (int col = begin; col < end; ++col) {
+                    if (!wait_above(col + kWavefrontLag)) {
+                        break;
+                    }
+                    UpdateCell(static_cast<int>(row) * cols + col);
+                    if ((col + 1) % kWavefrontProgressStride == 0 || col + 1 == end) {
+                        progress[row].done.store(col + 1, std::memory_order_release);
+                    }
+                }
+                if (chain_found.load(std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            wavefront_row = nullptr;
+        },
+        step_threads);
+
+    if (chain_found.load(std::memory_order_relaxed)) {
+        // Undo the rows newest write first, then restore the marks the agent update made
+        for (const auto &result : std::views::reverse(row_results)) {
+            for (const auto &change : std::views::reverse(result.changed_cells)) {
+                grid[static_cast<std::size_t>(change.index)] = change.old_type;
+                updated_epoch[static_cast<std::size_t>(change.index)] = 0;
+                if (chunk_size > 0) {
+                    TouchChunks(change.index, change.new_type, change.old_type);
+                }
+            }
+        }
+        for (int index : agent_marked) {
+            updated_epoch[static_cast<std::size_t>(index)] = scan_epoch;
+        }
+        return false;
+    }
+
+    for (const auto &result : row_results) {
+        hash ^= result.hash;
+        reward_signal |= result.reward_signal;
+        if (result.agent_died) {
+            is_agent_alive = false;
+        }
+        changed_cells.insert(changed_cells.end(), result.changed_cells.begin(), result.changed_cells.end());
+    }
+    return true;
 }
 
 auto BoulderDashGameState::is_terminal() const noexcept -> bool {
@@ -239,6 +553,10 @@ auto BoulderDashGameState::is_terminal() const noexcept -> bool {
     return !is_agent_alive || is_agent_in_exit;
 }
 
+auto BoulderDashGameState::is_approximate() const noexcept -> bool {
+    return sim_radius > 0;
+}
+
 auto BoulderDashGameState::is_solution() const noexcept -> bool {
     // Solution if agent is in exit
     return is_agent_in_exit;
@@ -249,6 +567,7 @@ auto BoulderDashGameState::observation_shape() const noexcept -> std::array<int,
 }
 
 auto BoulderDashGameState::get_observation() const noexcept -> std::vector<float> {
+    const TraceSpan span(TracePhase::kObservation);
     auto channel_length = cols * rows;
     std::vector<float> obs(kNumVisibleCellType * channel_length, 0);
     for (int i : std::views::iota(0, channel_length)) {
@@ -257,8 +576,38 @@ auto BoulderDashGameState::get_observation() const noexcept -> std::vector<float
     return obs;
 }
 
-// VisibleCellType to image binary data
-#include "assets_all.inc"
+auto BoulderDashGameState::get_observation_compact() const noexcept -> std::vector<int8_t> {
+    const TraceSpan span(TracePhase::kObservation);
+    std::vector<int8_t> obs;
+    obs.reserve(grid.size());
+    for (int i : std::views::iota(0, cols * rows)) {
+        obs.push_back(to_underlying(GetItem(i).visible_type));
+    }
+    return obs;
+}
+
+auto BoulderDashGameState::get_entities(std::span<int16_t> out, const EntityFilter &filter) const noexcept -> int {
+    const TraceSpan span(TracePhase::kObservation);
+    const std::size_t capacity = out.size() / kNumEntityFields;
+    std::size_t count = 0;
+    for (int i = 0; i < rows * cols && count < capacity; ++i) {
+        const HiddenCellType el = grid[static_cast<std::size_t>(i)];
+        if ((filter.skip_empty && el == HiddenCellType::kEmpty) || (filter.skip_dirt && el == HiddenCellType::kDirt) ||
+            (filter.skip_walls && (el == HiddenCellType::kWallBrick || el == HiddenCellType::kWallSteel))) {
+            continue;
+        }
+        auto entity = out.subspan(count * kNumEntityFields, kNumEntityFields);
+        entity[kEntityVisibleType] = to_underlying(GetItem(i).visible_type);
+        entity[kEntityRow] = static_cast<int16_t>(i / cols);
+        entity[kEntityCol] = static_cast<int16_t>(i % cols);
+        entity[kEntityHiddenType] = to_underlying(el);
+        entity[kEntityFalling] = entity_is_falling(el) ? 1 : 0;
+        entity[kEntityDirection] = entity_direction(el);
+        ++count;
+    }
+    std::ranges::fill(out.subspan(count * kNumEntityFields), -1);
+    return static_cast<int>(count);
+}
 
 auto BoulderDashGameState::image_shape() const noexcept -> std::array<int, 3> {
     return {rows * SPRITE_HEIGHT, cols * SPRITE_WIDTH, SPRITE_CHANNELS};
@@ -267,22 +616,7 @@ auto BoulderDashGameState::image_shape() const noexcept -> std::array<int, 3> {
 auto BoulderDashGameState::to_image() const noexcept -> std::vector<uint8_t> {
     const std::size_t flat_size = cols * rows;
     std::vector<uint8_t> img(flat_size * SPRITE_DATA_LEN, 0);
-    for (int h : std::views::iota(0, rows)) {
-        for (int w : std::views::iota(0, cols)) {
-            const std::size_t img_idx_top_left = h * (SPRITE_DATA_LEN * cols) + (w * SPRITE_DATA_LEN_PER_ROW);
-            const std::vector<uint8_t> &data = img_asset_map.at(GetItem(h * cols + w).visible_type);
-            for (int r : std::views::iota(0, SPRITE_HEIGHT)) {
-                for (int c : std::views::iota(0, SPRITE_WIDTH)) {
-                    const std::size_t data_idx = (r * SPRITE_DATA_LEN_PER_ROW) + (3 * c);
-                    const std::size_t img_idx =
-                        (r * SPRITE_DATA_LEN_PER_ROW * cols) + (SPRITE_CHANNELS * c) + img_idx_top_left;
-                    img[img_idx + 0] = data[data_idx + 0];
-                    img[img_idx + 1] = data[data_idx + 1];
-                    img[img_idx + 2] = data[data_idx + 2];
-                }
-            }
-        }
-    }
+    render_observation(get_observation_compact(), rows, cols, SpriteAtlas::get(), img.data());
     return img;
 }
 
@@ -294,13 +628,14 @@ auto BoulderDashGameState::get_hash() const noexcept -> uint64_t {
     return hash;
 }
 
+auto BoulderDashGameState::get_changed_cells() const noexcept -> const std::vector<CellChange> & {
+    return changed_cells;
+}
+
 auto BoulderDashGameState::get_positions(HiddenCellType element) const noexcept -> std::vector<Position> {
-    assert(is_valid_hidden_element(element));
     std::vector<Position> positions;
-    for (int idx : std::views::iota(0, rows * cols)) {
-        if (grid[static_cast<std::size_t>(idx)] == element) {
-            positions.emplace_back(idx / cols, idx % cols);
-        }
+    for (const int idx : get_indices(element)) {
+        positions.emplace_back(idx / cols, idx % cols);
     }
     return positions;
 }
@@ -322,15 +657,23 @@ auto BoulderDashGameState::index_to_position(int index) const -> Position {
 
 auto BoulderDashGameState::get_indices(HiddenCellType element) const noexcept -> std::vector<int> {
     assert(is_valid_hidden_element(element));
+    return get_indices(ElementSet{element});
+}
+
+auto BoulderDashGameState::get_indices(ElementSet elements) const noexcept -> std::vector<int> {
     std::vector<int> indices;
-    for (int idx : std::views::iota(0, rows * cols)) {
-        if (grid[static_cast<std::size_t>(idx)] == element) {
-            indices.push_back(idx);
-        }
-    }
+    find_cells(grid, elements, indices);
     return indices;
 }
 
+auto BoulderDashGameState::count_elements(ElementSet elements) const noexcept -> int {
+    return static_cast<int>(count_cells(grid, elements));
+}
+
+auto BoulderDashGameState::has_elements(ElementSet elements) const noexcept -> bool {
+    return any_cells(grid, elements);
+}
+
 auto BoulderDashGameState::is_pos_in_bounds(const Position &position) const noexcept -> bool {
     return position.first >= 0 && position.first < rows && position.second >= 0 && position.second < cols;
 }
@@ -354,6 +697,31 @@ auto BoulderDashGameState::get_hidden_item(int index) const -> HiddenCellType {
     return grid[static_cast<std::size_t>(index)];
 }
 
+void BoulderDashGameState::get_hidden_grid(std::span<int8_t> out) const {
+    if (out.size() != static_cast<std::size_t>(rows * cols)) {
+        throw std::invalid_argument(
+            std::format("Grid buffer of size {:d} does not match map size ({:d}, {:d})", out.size(), rows, cols));
+    }
+    for (int idx = 0; idx < rows * cols; ++idx) {
+        out[static_cast<std::size_t>(idx)] = to_underlying(grid[static_cast<std::size_t>(idx)]);
+    }
+}
+
+void BoulderDashGameState::get_element_counts(std::span<int32_t> out) const {
+    if (out.size() != static_cast<std::size_t>(kNumHiddenCellType)) {
+        throw std::invalid_argument(std::format("Count buffer of size {:d} does not match the {:d} element types",
+                                                out.size(), kNumHiddenCellType));
+    }
+    std::ranges::fill(out, 0);
+    for (int idx = 0; idx < rows * cols; ++idx) {
+        ++out[static_cast<std::size_t>(to_underlying(grid[static_cast<std::size_t>(idx)]))];
+    }
+}
+
+auto BoulderDashGameState::get_grid_storage() const noexcept -> std::span<const HiddenCellType> {
+    return grid;
+}
+
 auto operator<<(std::ostream &os, const GameParameters &params) -> std::ostream & {
     os << "{\n";
     os << std::format("  gravity: {}\n", params.gravity);
@@ -363,6 +731,9 @@ auto operator<<(std::ostream &os, const GameParameters &params) -> std::ostream
     os << std::format("  disable_explosions: {}\n", params.disable_explosions);
     os << std::format("  butterfly_explosion_ver: {:d}\n", params.butterfly_explosion_ver);
     os << std::format("  butterfly_move_ver: {:d}\n", params.butterfly_move_ver);
+    os << std::format("  chunk_size: {:d}\n", params.chunk_size);
+    os << std::format("  step_threads: {:d}\n", params.step_threads);
+    os << std::format("  sim_radius: {:d}\n", params.sim_radius);
     os << "}";
     return os;
 }
@@ -378,8 +749,7 @@ auto operator<<(std::ostream &os, const BoulderDashGameState &state) -> std::ost
     for (int h : std::views::iota(0, state.rows)) {
         os << "|";
         for (int w : std::views::iota(0, state.cols)) {
-            // NOLINTNEXTLINE(*-bounds-constant-array-index)
-            os << kCellTypeToElement[static_cast<std::size_t>(state.grid[h * state.cols + w]) + 1].id;
+            os << state.GetItem(h * state.cols + w).id;
         }
         os << "|" << std::endl;
     }
@@ -434,33 +804,59 @@ auto BoulderDashGameState::HasProperty(int index, int property, Direction direct
     return InBounds(index, direction) && ((GetItem(new_index).properties & property) > 0);
 }
 
-void BoulderDashGameState::MoveItem(int index, Direction direction) noexcept {
-    auto new_index = IndexFromDirection(index, direction);
-    auto flat_size = rows * cols;
-    hash ^= to_local_hash(flat_size, grid[static_cast<std::size_t>(new_index)], new_index);
-    grid[static_cast<std::size_t>(new_index)] = grid[static_cast<std::size_t>(index)];
-    hash ^= to_local_hash(flat_size, grid[static_cast<std::size_t>(new_index)], new_index);
+void BoulderDashGameState::WriteCell(int index, HiddenCellType element) noexcept {
+    const auto flat_size = rows * cols;
+    const HiddenCellType old_el = grid[static_cast<std::size_t>(index)];
+    if (wavefront_row != nullptr) {
+        // Elements which keep the scan sequential, magic walls included, are never on the board during a wavefront
+        // scan
+        wavefront_row->hash ^= to_local_hash(flat_size, old_el, index) ^ to_local_hash(flat_size, element, index);
+        wavefront_row->changed_cells.push_back({index, old_el, element});
+    } else {
+        hash ^= to_local_hash(flat_size, old_el, index) ^ to_local_hash(flat_size, element, index);
+        changed_cells.push_back({index, old_el, element});
+        num_sequential_only +=
+            static_cast<int>(requires_sequential_scan(element)) - static_cast<int>(requires_sequential_scan(old_el));
+    }
+    if (chunk_size > 0) {
+        TouchChunks(index, old_el, element);
+    }
+    grid[static_cast<std::size_t>(index)] = element;
+}
 
-    hash ^= to_local_hash(flat_size, grid[static_cast<std::size_t>(index)], index);
-    grid[static_cast<std::size_t>(index)] = kElEmpty.cell_type;
-    hash ^= to_local_hash(flat_size, kElEmpty.cell_type, index);
+void BoulderDashGameState::SignalReward(uint64_t reward) noexcept {
+    if (wavefront_row != nullptr) {
+        wavefront_row->reward_signal |= reward;
+    } else {
+        reward_signal |= reward;
+    }
+}
+
+void BoulderDashGameState::MarkAgentDead() noexcept {
+    if (wavefront_row != nullptr) {
+        wavefront_row->agent_died = true;
+    } else {
+        is_agent_alive = false;
+    }
+}
 
-    has_updated[new_index] = true;
+void BoulderDashGameState::MoveItem(int index, Direction direction) noexcept {
+    auto new_index = IndexFromDirection(index, direction);
+    WriteCell(new_index, grid[static_cast<std::size_t>(index)]);
+    WriteCell(index, kElEmpty.cell_type);
+    updated_epoch[static_cast<std::size_t>(new_index)] = scan_epoch;
 }
 
 void BoulderDashGameState::SetItem(int index, const Element &element, Direction direction) noexcept {
     auto new_index = IndexFromDirection(index, direction);
-    auto flat_size = rows * cols;
-    hash ^= to_local_hash(flat_size, grid[static_cast<std::size_t>(new_index)], new_index);
-    grid[static_cast<std::size_t>(new_index)] = element.cell_type;
-    hash ^= to_local_hash(flat_size, element.cell_type, new_index);
-    has_updated[new_index] = true;
+    WriteCell(new_index, element.cell_type);
+    updated_epoch[static_cast<std::size_t>(new_index)] = scan_epoch;
 }
 
 auto BoulderDashGameState::GetItem(int index, Direction direction) const noexcept -> const Element & {
     auto new_index = static_cast<std::size_t>(IndexFromDirection(index, direction));
     // NOLINTNEXTLINE(*-bounds-constant-array-index)
-    return kCellTypeToElement[static_cast<std::size_t>(grid[new_index]) + 1];
+    return kCellTypeToElement[static_cast<std::size_t>(grid[static_cast<std::size_t>(new_index)]) + 1];
 }
 
 auto BoulderDashGameState::IsTypeAdjacent(int index, const Element &element) const noexcept -> bool {
@@ -512,7 +908,10 @@ void BoulderDashGameState::MoveThroughMagic(int index, const Element &element) n
     if (magic_wall_steps <= 0) {
         return;
     }
-    magic_active = true;
+    if (!magic_active) {
+        magic_active = true;
+        WakeMagicWalls();
+    }
     auto index_wall = IndexFromDirection(index, Direction::kDown);
     auto index_under_wall = IndexFromDirection(index_wall, Direction::kDown);
     // Need to ensure cell below magic wall is empty (so item can pass through)
@@ -524,11 +923,23 @@ void BoulderDashGameState::MoveThroughMagic(int index, const Element &element) n
 
 // NOLINTNEXTLINE (mi-no-recursion)
 void BoulderDashGameState::Explode(int index, const Element &element, Direction direction) noexcept {
+    const TraceSpan span(TracePhase::kExplosion);
     auto new_index = IndexFromDirection(index, direction);
+    if (wavefront_row != nullptr) {
+        // Chains can reach rows other wavefront workers are stepping, leave the step to the sequential scan
+        for (int dir_index : std::views::iota(0, kNumDirections)) {
+            auto dir = static_cast<Direction>(dir_index);
+            if (dir != Direction::kNoop && InBounds(new_index, dir) &&
+                HasProperty(new_index, ElementProperties::kCanExplode, dir)) {
+                wavefront_row->chain_found->store(true, std::memory_order_relaxed);
+                return;
+            }
+        }
+    }
     const auto &it = kElementToExplosion.find(GetItem(new_index));
     const Element &ex = (it == kElementToExplosion.end()) ? kElExplosionEmpty : it->second;
     if (GetItem(new_index) == kElAgent) {
-        is_agent_alive = false;
+        MarkAgentDead();
     }
     SetItem(new_index, element);
     // Recursively check all directions for chain explosions
@@ -542,7 +953,7 @@ void BoulderDashGameState::Explode(int index, const Element &element, Direction
         } else if (HasProperty(new_index, ElementProperties::kConsumable, dir)) {
             SetItem(new_index, ex, dir);
             if (GetItem(new_index, dir) == kElAgent) {
-                is_agent_alive = false;
+                MarkAgentDead();
             }
         }
     }
@@ -576,7 +987,7 @@ void BoulderDashGameState::UpdateStoneFalling(int index) noexcept {
         // Falling on a butterfly, destroy it open to reveal a diamond!
         SetItem(index, kElEmpty);
         SetItem(index, kElDiamond, Direction::kDown);
-        reward_signal |= RewardCodes::kRewardButterflyToDiamond;
+        SignalReward(RewardCodes::kRewardButterflyToDiamond);
     } else if (HasProperty(index, ElementProperties::kCanExplode, Direction::kDown)) {
         // Falling stones can cause elements to explode
         const auto it = kElementToExplosion.find(GetItem(index, Direction::kDown));
@@ -587,7 +998,7 @@ void BoulderDashGameState::UpdateStoneFalling(int index) noexcept {
     } else if (IsType(index, kElNut, Direction::kDown)) {
         // Falling on a nut, crack it open to reveal a diamond!
         SetItem(index, kElDiamond, Direction::kDown);
-        reward_signal |= RewardCodes::kRewardNutToDiamond;
+        SignalReward(RewardCodes::kRewardNutToDiamond);
     } else if (IsType(index, kElBomb, Direction::kDown)) {
         // Falling on a bomb, explode!
         const auto it = kElementToExplosion.find(GetItem(index));
@@ -844,14 +1255,35 @@ void BoulderDashGameState::UpdateOrange(int index, Direction direction) noexcept
     }
 }
 
-void BoulderDashGameState::UpdateMagicWall(int index) noexcept {
+auto BoulderDashGameState::CurrentMagicWall() const noexcept -> const Element & {
     // Dorminant, active, then expired once time runs out
     if (magic_active) {
-        SetItem(index, kElWallMagicOn);
+        return kElWallMagicOn;
     } else if (magic_wall_steps > 0) {
-        SetItem(index, kElWallMagicDormant);
-    } else {
-        SetItem(index, kElWallMagicExpired);
+        return kElWallMagicDormant;
+    }
+    return kElWallMagicExpired;
+}
+
+void BoulderDashGameState::UpdateMagicWall(int index) noexcept {
+    // Each wall takes the current state when scanned, and is only written if that changed it
+    const Element &wall = CurrentMagicWall();
+    if (grid[static_cast<std::size_t>(index)] != wall.cell_type) {
+        SetItem(index, wall);
+    }
+}
+
+void BoulderDashGameState::WakeMagicWalls() noexcept {
+    // The state switches at most twice a game, when first activated and when expired, and every wall has to be
+    // scanned after, so the chunks holding walls are woken even if nothing near them was written
+    if (chunk_size == 0) {
+        return;
+    }
+    for (int i : std::views::iota(0, rows * cols)) {
+        const HiddenCellType el = grid[static_cast<std::size_t>(i)];
+        if (is_magic_wall(el)) {
+            TouchChunks(i, el, el);
+        }
     }
 }
 
@@ -865,8 +1297,9 @@ void BoulderDashGameState::UpdateBlob(int index) noexcept {
         return;
     }
     ++blob_size;
-    // Check if at least one tile blob can grow to
-    if (IsTypeAdjacent(index, kElEmpty) || IsTypeAdjacent(index, kElDirt)) {
+    // Check if at least one tile blob can grow to.
+    // One such cell is enough, so once it is found the rest of the blob skips the neighbour checks.
+    if (blob_enclosed && (IsTypeAdjacent(index, kElEmpty) || IsTypeAdjacent(index, kElDirt))) {
         blob_enclosed = false;
     }
     // Roll if to grow and direction
@@ -878,15 +1311,13 @@ void BoulderDashGameState::UpdateBlob(int index) noexcept {
 }
 
 void BoulderDashGameState::UpdateExplosions(int index) noexcept {
-    reward_signal |= kExplosionToReward.at(GetItem(index));
+    SignalReward(kExplosionToReward.at(GetItem(index)));
     SetItem(index, kExplosionToElement.at(GetItem(index)));
 }
 
 void BoulderDashGameState::OpenGate(const Element &element) noexcept {
-    for (int index : std::views::iota(0, rows * cols)) {
-        if (grid[static_cast<std::size_t>(index)] == element.cell_type) {
-            SetItem(index, kGateOpenMap.at(GetItem(index)));
-        }
+    for (const int index : get_indices(ElementSet{element.cell_type})) {
+        SetItem(index, kGateOpenMap.at(GetItem(index)));
     }
 }
 
@@ -896,13 +1327,20 @@ void BoulderDashGameState::StartScan() noexcept {
     blob_size = 0;
     blob_enclosed = true;
     reward_signal = 0;
-    for (int i : std::views::iota(0, rows * cols)) {
-        has_updated[static_cast<std::size_t>(i)] = false;
+    // A new epoch leaves every stamp from the last step stale, the stamps only need clearing once the epoch wraps
+    if (++scan_epoch == 0) {
+        std::ranges::fill(updated_epoch, 0);
+        scan_epoch = 1;
+    }
+    changed_cells.clear();
+    if (chunk_size > 0) {
+        ++chunk_tick;
     }
 }
 
 void BoulderDashGameState::EndScan() noexcept {
-    if (blob_swap == kNullElement.cell_type) {
+    // A window without blobs says nothing about the blobs outside of it, unless there is no outside
+    if (blob_swap == kNullElement.cell_type && (blob_size > 0 || WindowCoversBoard())) {
         if (blob_enclosed) {
             blob_swap = kElDiamond.cell_type;
         }
@@ -912,8 +1350,111 @@ void BoulderDashGameState::EndScan() noexcept {
     }
     if (magic_active) {
         magic_wall_steps = static_cast<decltype(magic_wall_steps)>(std::max(magic_wall_steps - 1, 0));
+        if (magic_wall_steps == 0) {
+            magic_active = false;
+            WakeMagicWalls();
+        }
+    }
+}
+
+auto BoulderDashGameState::WindowCoversBoard() const noexcept -> bool {
+    const int agent_row = agent_idx / cols;
+    const int agent_col = agent_idx % cols;
+    return sim_radius == 0 || (agent_row - sim_radius <= 0 && agent_row + sim_radius >= rows - 1 &&
+                               agent_col - sim_radius <= 0 && agent_col + sim_radius >= cols - 1);
+}
+
+void BoulderDashGameState::InitWindow(int radius) {
+    if (radius < 0 || radius > kMaxBoardSide) {
+        throw std::invalid_argument(
+            std::format("Invalid sim radius {:d}, expected 0 or a positive radius up to {:d}", radius, kMaxBoardSide));
+    }
+    sim_radius = static_cast<int16_t>(radius);
+    window_explosions.clear();
+    if (sim_radius > 0) {
+        for (int i : std::views::iota(0, rows * cols)) {
+            if (IsExplosion(GetItem(i))) {
+                window_explosions.push_back(i);
+            }
+        }
     }
-    magic_active = magic_active && (magic_wall_steps > 0);
+}
+
+// ---------------------------------------------------------------------------
+
+auto BoulderDashGameState::SameBoard(const BoulderDashGameState &other) const noexcept -> bool {
+    // Stale stamps differ between equal states, so only whether each cell was updated in the last step is compared
+    if (grid != other.grid) {
+        return false;
+    }
+    // Copies share their stamps, which is the common case
+    if (scan_epoch == other.scan_epoch && updated_epoch == other.updated_epoch) {
+        return true;
+    }
+    const uint8_t *stamps = updated_epoch.data();
+    const uint8_t *other_stamps = other.updated_epoch.data();
+    int different_marks = 0;
+    for (std::size_t i = 0; i < updated_epoch.size(); ++i) {
+        different_marks |=
+            static_cast<int>(stamps[i] == scan_epoch) ^ static_cast<int>(other_stamps[i] == other.scan_epoch);
+    }
+    return different_marks == 0;
+}
+
+// ---------------------------------------------------------------------------
+
+// A cell which is not always updated can only act differently than on the previous step if a cell within one
+// cell of it was written since, so a chunk is dormant if nothing was written in or next to it during the last
+// step or so far during this one. Every chunk starts out active so the first step scans the full board.
+
+void BoulderDashGameState::InitChunks() {
+    if (chunk_size < 0) {
+        throw std::invalid_argument(std::format("Invalid chunk size {:d}, expected 0 or a positive size", chunk_size));
+    }
+    chunk_tick = 0;
+    if (chunk_size == 0) {
+        chunk_cols = 0;
+        chunk_dynamic_count.clear();
+        chunk_touched.clear();
+        return;
+    }
+    chunk_cols = (cols + chunk_size - 1) / chunk_size;
+    const int chunk_rows = (rows + chunk_size - 1) / chunk_size;
+    chunk_dynamic_count.assign(static_cast<std::size_t>(chunk_rows * chunk_cols), 0);
+    chunk_touched.assign(static_cast<std::size_t>(chunk_rows * chunk_cols), 0);
+    for (int i : std::views::iota(0, rows * cols)) {
+        const int chunk = ((i / cols) / chunk_size) * chunk_cols + (i % cols) / chunk_size;
+        if (is_always_updated(grid[static_cast<std::size_t>(i)])) {
+            ++chunk_dynamic_count[static_cast<std::size_t>(chunk)];
+        }
+    }
+}
+
+void BoulderDashGameState::TouchChunks(int index, HiddenCellType old_el, HiddenCellType new_el) noexcept {
+    const int row = index / cols;
+    const int col = index % cols;
+    const int chunk = (row / chunk_size) * chunk_cols + col / chunk_size;
+    // Atomic as wavefront rows can write cells in the same chunk
+    const int count_delta = static_cast<int>(is_always_updated(new_el)) - static_cast<int>(is_always_updated(old_el));
+    if (count_delta != 0) {
+        std::atomic_ref(chunk_dynamic_count[static_cast<std::size_t>(chunk)])
+            .fetch_add(count_delta, std::memory_order_relaxed);
+    }
+    // Wake every chunk holding a neighbour which may now act differently
+    const int chunk_row_end = std::min(row + 1, rows - 1) / chunk_size;
+    const int chunk_col_end = std::min(col + 1, cols - 1) / chunk_size;
+    for (int chunk_row = std::max(row - 1, 0) / chunk_size; chunk_row <= chunk_row_end; ++chunk_row) {
+        for (int chunk_col = std::max(col - 1, 0) / chunk_size; chunk_col <= chunk_col_end; ++chunk_col) {
+            std::atomic_ref(chunk_touched[static_cast<std::size_t>(chunk_row * chunk_cols + chunk_col)])
+                .store(chunk_tick, std::memory_order_relaxed);
+        }
+    }
+}
+
+auto BoulderDashGameState::IsChunkActive(int chunk) noexcept -> bool {
+    return std::atomic_ref(chunk_dynamic_count[static_cast<std::size_t>(chunk)]).load(std::memory_order_relaxed) > 0 ||
+           std::atomic_ref(chunk_touched[static_cast<std::size_t>(chunk)]).load(std::memory_order_relaxed) + 1 >=
+               chunk_tick;
 }
 
 }    // namespace boulderdash
@@ -2,14 +2,17 @@
 #define BOULDERDASH_BASE_H_
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
 #include <iostream>
+#include <span>
 #include <string>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
 #include "definitions.h"
+#include "grid_query.h"
 
 namespace boulderdash {
 
@@ -27,6 +30,9 @@ constexpr bool DEFAULT_GRAVITY = false;
 constexpr bool DEFAULT_DISABLE_EXPLOSIONS = false;
 constexpr int DEFAULT_BUTTERFLY_EXPLOSION_VER = ButterflyExplosionVersion::kExplode;
 constexpr int DEFAULT_BUTTERFLY_MOVE_VER = ButterflyMoveVersion::kDelay;
+constexpr int DEFAULT_CHUNK_SIZE = 0;
+constexpr int DEFAULT_STEP_THREADS = 0;
+constexpr int DEFAULT_SIM_RADIUS = 0;
 
 struct GameParameters {
     bool gravity = DEFAULT_GRAVITY;
@@ -36,11 +42,63 @@ struct GameParameters {
     bool disable_explosions = DEFAULT_DISABLE_EXPLOSIONS;
     int butterfly_explosion_ver = DEFAULT_BUTTERFLY_EXPLOSION_VER;
     int butterfly_move_ver = DEFAULT_BUTTERFLY_MOVE_VER;
+    int chunk_size = DEFAULT_CHUNK_SIZE;    // Side of the chunks dormant regions are skipped in, 0 scans every cell
+    int step_threads = DEFAULT_STEP_THREADS;    // Threads stepping a single board as a row wavefront, 0 or 1 for none
+    int sim_radius = DEFAULT_SIM_RADIUS;    // Approximate: only step elements this close to the agent, 0 for all
     friend auto operator<<(std::ostream &os, const GameParameters &params) -> std::ostream &;
 };
 
+// Columns of each row written by get_entities()
+enum EntityField : int {
+    kEntityVisibleType = 0,
+    kEntityRow = 1,
+    kEntityCol = 2,
+    kEntityHiddenType = 3,
+    kEntityFalling = 4,      // 1 if the element is falling, 0 otherwise
+    kEntityDirection = 5,    // Direction for fireflies, butterflies and oranges, -1 otherwise
+};
+constexpr int kNumEntityFields = 6;
+
+// Background cells left out of the entity list
+struct EntityFilter {
+    bool skip_empty = true;
+    bool skip_dirt = true;
+    bool skip_walls = true;    // Brick and steel walls
+};
+
+// Scalar part of the game state, laid out without padding so states can be compared with a single memcmp.
+// Internal to BoulderDashGameState.
+struct StateCore {
+    uint64_t random_state = 0;     // State of Xorshift rng
+    uint64_t reward_signal = 0;    // Signal for external information about events
+    uint64_t hash = 0;
+    int32_t magic_wall_steps = 0;              // params: Number of steps the magic wall stays active for
+    int32_t magic_wall_steps_remaining = 0;    // Number of steps remaining for the magic wall
+    int32_t blob_max_size = 0;                 // Max blob size in terms of grid spaces
+    int32_t blob_size = 0;                     // Current size of the blob
+    int32_t gems_collected = 0;                // Number of gems collected
+    int32_t gems_required = 0;
+    int32_t agent_idx = -1;
+    int16_t rows = -1;
+    int16_t cols = -1;
+    int16_t sim_radius = 0;    // params: Radius around the agent which is stepped, 0 for the whole board
+    int8_t butterfly_explosion_ver = 0;    // params:
+    int8_t butterfly_move_ver = 0;         // params:
+    uint8_t blob_chance = 0;               // Chance (out of 256) for blob to spawn
+    HiddenCellType blob_swap = HiddenCellType::kNull;
+    uint8_t reserved = 0;    // Always zero, so the core has no padding bytes
+    bool gravity : 1 = false;               // Flag if gravity is on, affects stones/gems
+    bool disable_explosions : 1 = false;    // Flag if explosions are disabled, affects bombs
+    bool magic_active : 1 = false;          // Flag if magic wall is currently active
+    bool blob_enclosed : 1 = true;          // Flag if blob is enclosed
+    bool is_agent_alive : 1 = false;
+    bool is_agent_in_exit : 1 = false;
+    uint8_t reserved_flags : 2 = 0;    // Always zero, so the flag byte has no indeterminate bits
+};
+static_assert(std::has_unique_object_representations_v<StateCore>, "StateCore must be comparable with memcmp");
+
 // Game state
-class BoulderDashGameState {
+class BoulderDashGameState : private StateCore {
 public:
     // Internal use for packing/unpacking with pybind11 pickle
     struct InternalState {
@@ -48,6 +106,9 @@ public:
         int blob_max_size;
         int butterfly_explosion_ver;
         int butterfly_move_ver;
+        int sim_radius;
+        int chunk_size;
+        int step_threads;
         int gems_collected;
         int magic_wall_steps_remaining;
         int blob_size;
@@ -72,11 +133,19 @@ public:
 
     using Position = std::pair<int, int>;
 
+    // A single cell write made during the last apply_action
+    struct CellChange {
+        int index;
+        HiddenCellType old_type;
+        HiddenCellType new_type;
+        auto operator==(const CellChange &other) const -> bool = default;
+    };
+
     BoulderDashGameState() = delete;
     BoulderDashGameState(const std::string &board_str, const GameParameters &params = {});
     BoulderDashGameState(InternalState &&internal_state);
 
-    auto operator==(const BoulderDashGameState &other) const -> bool = default;
+    auto operator==(const BoulderDashGameState &other) const -> bool;
     auto operator!=(const BoulderDashGameState &other) const -> bool = default;
 
     static inline std::string name = "boulderdash";
@@ -96,7 +165,7 @@ public:
      * @return True if element is valid, false otherwise
      */
     [[nodiscard]] constexpr static auto is_valid_hidden_element(HiddenCellType element) -> bool {
-        return static_cast<int>(element) >= 0 && static_cast<int>(element) < static_cast<int>(kNumVisibleCellType);
+        return static_cast<int>(element) >= 0 && static_cast<int>(element) < static_cast<int>(kNumHiddenCellType);
     }
 
     /**
@@ -128,6 +197,13 @@ public:
      */
     [[nodiscard]] auto is_terminal() const noexcept -> bool;
 
+    /**
+     * Check if the state uses approximate dynamics, i.e. only elements within sim_radius of the agent are stepped.
+     * The hash of approximate states is salted so they never collide with exact states of the same board.
+     * @return True if approximate, false otherwise
+     */
+    [[nodiscard]] auto is_approximate() const noexcept -> bool;
+
     /**
      * Check if the state is in the solution state (agent inside exit).
      * @return True if terminal, false otherwise
@@ -147,6 +223,24 @@ public:
      */
     [[nodiscard]] auto get_observation() const noexcept -> std::vector<float>;
 
+    /**
+     * Get a compact representation of the current state observation.
+     * Each cell holds its VisibleCellType, which is the channel set in get_observation().
+     * The observation should be viewed as the shape {rows, cols}.
+     * @return vector of visible cell types in row-major order
+     */
+    [[nodiscard]] auto get_observation_compact() const noexcept -> std::vector<int8_t>;
+
+    /**
+     * Write the list of non-background elements into caller memory, in row-major order.
+     * Each entity is a row of kNumEntityFields values (see EntityField), and rows past the returned count
+     * are padded with -1. Entities past the capacity of out are dropped.
+     * @param out Buffer of capacity * kNumEntityFields values
+     * @param filter Background cells to skip
+     * @return Number of entities written
+     */
+    auto get_entities(std::span<int16_t> out, const EntityFilter &filter = {}) const noexcept -> int;
+
     /**
      * Get the index corresponding to the given position
      * @return the flat index
@@ -183,6 +277,13 @@ public:
      */
     [[nodiscard]] auto get_hash() const noexcept -> uint64_t;
 
+    /**
+     * Get the cell writes made during the last apply_action, in the order they were made.
+     * A cell can appear more than once if it was written multiple times during the step.
+     * @return vector of (index, old hidden type, new hidden type) changes
+     */
+    [[nodiscard]] auto get_changed_cells() const noexcept -> const std::vector<CellChange> &;
+
     /**
      * Get all positions for a given element type
      * @param element The hidden cell type of the element to search for
@@ -197,6 +298,25 @@ public:
      */
     [[nodiscard]] auto get_indices(HiddenCellType element) const noexcept -> std::vector<int>;
 
+    /**
+     * Get all indices of cells of any of the given types
+     * @param elements The hidden cell types of the elements to search for
+     * @return flat indices in increasing order
+     */
+    [[nodiscard]] auto get_indices(ElementSet elements) const noexcept -> std::vector<int>;
+
+    /**
+     * Count the cells of any of the given types, using the vectorized grid queries (see count_cells()).
+     * @param elements The hidden cell types to count
+     */
+    [[nodiscard]] auto count_elements(ElementSet elements) const noexcept -> int;
+
+    /**
+     * Check if any cell is of one of the given types, e.g. whether any falling objects are left
+     * @param elements The hidden cell types to look for
+     */
+    [[nodiscard]] auto has_elements(ElementSet elements) const noexcept -> bool;
+
     /**
      * Check if a given position is in bounds
      * @param position The position to check
@@ -225,19 +345,44 @@ public:
      */
     [[nodiscard]] auto get_hidden_item(int index) const -> HiddenCellType;
 
+    /**
+     * Write the hidden cell type of every cell in row-major order.
+     * @param out Destination of rows * cols values
+     */
+    void get_hidden_grid(std::span<int8_t> out) const;
+
+    /**
+     * Count the cells of each hidden cell type.
+     * @param out Destination of kNumHiddenCellType counts, indexed by HiddenCellType
+     */
+    void get_element_counts(std::span<int32_t> out) const;
+
+    /**
+     * Get the grid storage itself, to read the board without copying it.
+     * Cells are in row-major order, and hold the same types as get_hidden_grid().
+     * The span is valid for the lifetime of the state and reflects later actions.
+     */
+    [[nodiscard]] auto get_grid_storage() const noexcept -> std::span<const HiddenCellType>;
+
     friend auto operator<<(std::ostream &os, const BoulderDashGameState &state) -> std::ostream &;
 
     [[nodiscard]] auto pack() const -> InternalState {
         std::vector<decltype(to_underlying(grid[0]))> _grid;
-        _grid.reserve(grid.size());
-        for (const auto &el : grid) {
-            _grid.push_back(to_underlying(el));
+        std::vector<bool> _has_updated;
+        _grid.reserve(static_cast<std::size_t>(rows * cols));
+        _has_updated.reserve(static_cast<std::size_t>(rows * cols));
+        for (int i = 0; i < rows * cols; ++i) {
+            _grid.push_back(to_underlying(grid[static_cast<std::size_t>(i)]));
+            _has_updated.push_back(updated_epoch[static_cast<std::size_t>(i)] == scan_epoch);
         }
         return {
             .magic_wall_steps = magic_wall_steps,
             .blob_max_size = blob_max_size,
             .butterfly_explosion_ver = butterfly_explosion_ver,
             .butterfly_move_ver = butterfly_move_ver,
+            .sim_radius = sim_radius,
+            .chunk_size = chunk_size,
+            .step_threads = step_threads,
             .gems_collected = gems_collected,
             .magic_wall_steps_remaining = magic_wall_steps_remaining,
             .blob_size = blob_size,
@@ -257,17 +402,21 @@ public:
             .is_agent_in_exit = is_agent_in_exit,
             .blob_swap = to_underlying(blob_swap),
             .grid = std::move(_grid),
-            .has_updated = has_updated,
+            .has_updated = std::move(_has_updated),
         };
     }
 
 private:
+    [[nodiscard]] auto SameBoard(const BoulderDashGameState &other) const noexcept -> bool;
     [[nodiscard]] auto IndexFromDirection(int index, Direction direction) const noexcept -> int;
     [[nodiscard]] auto InBounds(int index, Direction direction = Direction::kNoop) const noexcept -> bool;
     [[nodiscard]] auto IsType(int index, const Element &element, Direction direction = Direction::kNoop) const noexcept
         -> bool;
     [[nodiscard]] auto HasProperty(int index, int property, Direction direction = Direction::kNoop) const noexcept
         -> bool;
+    void WriteCell(int index, HiddenCellType element) noexcept;
+    void SignalReward(uint64_t reward) noexcept;
+    void MarkAgentDead() noexcept;
     void MoveItem(int index, Direction direction) noexcept;
     void SetItem(int index, const Element &element, Direction direction = Direction::kNoop) noexcept;
     [[nodiscard]] auto GetItem(int index, Direction direction = Direction::kNoop) const noexcept -> const Element &;
@@ -294,42 +443,65 @@ private:
     void UpdateFirefly(int index, Direction direction) noexcept;
     void UpdateButterfly(int index, Direction direction) noexcept;
     void UpdateOrange(int index, Direction direction) noexcept;
+    [[nodiscard]] auto CurrentMagicWall() const noexcept -> const Element &;
     void UpdateMagicWall(int index) noexcept;
+    void WakeMagicWalls() noexcept;
     void UpdateBlob(int index) noexcept;
     void UpdateExplosions(int index) noexcept;
     void OpenGate(const Element &element) noexcept;
 
+    // Scan behaviour of a hidden cell type, the direction is decoded from the type ahead of time
+    using UpdateHandler = void (BoulderDashGameState::*)(int index, Direction direction) noexcept;
+    struct CellBehaviour {
+        UpdateHandler update = nullptr;    // nullptr for types which never change on their own
+        Direction direction = Direction::kNoop;
+    };
+    template <void (BoulderDashGameState::*Update)(int) noexcept>
+    void UpdateUndirected(int index, [[maybe_unused]] Direction direction) noexcept {
+        (this->*Update)(index);
+    }
+    static consteval auto MakeCellBehaviours() -> std::array<CellBehaviour, kNumHiddenCellType + 1>;
+    static const std::array<CellBehaviour, kNumHiddenCellType + 1> kCellBehaviours;    // Indexed by type + 1
+
+    void UpdateCell(int index) noexcept;
+    void ScanSequential() noexcept;
+    void ScanWindow() noexcept;
+    [[nodiscard]] auto ScanWavefront() -> bool;
     void StartScan() noexcept;
     void EndScan() noexcept;
 
+    void InitChunks();
+    void InitWindow(int radius);
+    [[nodiscard]] auto WindowCoversBoard() const noexcept -> bool;
+    void TouchChunks(int index, HiddenCellType old_el, HiddenCellType new_el) noexcept;
+    [[nodiscard]] auto IsChunkActive(int chunk) noexcept -> bool;
+
     void parse_board_str(const std::string &board_str);
 
-    int magic_wall_steps;                  // params: Number of steps the magic wall stays active for
-    int blob_max_size;                     // Max blob size in terms of grid spaces
-    int butterfly_explosion_ver;           // params:
-    int butterfly_move_ver;                // params:
-    int gems_collected = 0;                // Number of gems collected
-    int magic_wall_steps_remaining = 0;    // Number of steps remaining for the magic wall
-    int blob_size = 0;                     // Current size of the blob
-    int rows = -1;
-    int cols = -1;
-    int agent_idx = -1;
-    int gems_required = 0;
-    uint64_t random_state;         // State of Xorshift rng
-    uint64_t reward_signal = 0;    // Signal for external information about events
-    uint64_t hash = 0;
-    uint8_t blob_chance{};              // Chance (out of 256) for blob to spawn
-    bool gravity{};                     // Flag if gravity is on, affects stones/gems
-    bool disable_explosions = false;    // Flag if explosions are disabled, affects bombs
-    bool magic_active = false;          // Flag if magic wall is currently active
-    bool blob_enclosed = true;          // Flag if blob is enclosed
-    bool is_agent_alive = false;
-    bool is_agent_in_exit = false;
-    HiddenCellType blob_swap = HiddenCellType::kNull;
+    // Scalar state is in StateCore
 
     // Board
     std::vector<HiddenCellType> grid;
-    std::vector<bool> has_updated;
+    // Scan each cell was last updated in, the cell was updated during the last step if it equals scan_epoch.
+    // Stamps rather than flags so they need no clearing between steps, and bytes so wavefront rows can stamp cells
+    // concurrently.
+    std::vector<uint8_t> updated_epoch;
+    uint8_t scan_epoch = 1;
+    std::vector<int> window_explosions;    // Explosions outside of the sim_radius window, which are still stepped
+
+    // Cell writes from the last step, not part of the state identity
+    std::vector<CellChange> changed_cells;
+
+    // Chunked stepping, not part of the state identity
+    int chunk_size = 0;
+    int chunk_cols = 0;
+    uint64_t chunk_tick = 0;                  // Number of steps taken since the chunks were built
+    std::vector<int> chunk_dynamic_count;     // Elements in each chunk which must be updated every step
+    std::vector<uint64_t> chunk_touched;      // Last step a cell in or next to each chunk was written
+
+    // Wavefront stepping, not part of the state identity
+    int step_threads = 0;
+    int num_sequential_only = 0;    // Elements on the board which keep the scan sequential
 };
 
 }    // namespace boulderdash
@@ -0,0 +1,223 @@
+#include "grid_query.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+#include "definitions.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define BOULDERDASH_GRID_QUERY_SSE2 1
+#endif
+#if defined(BOULDERDASH_GRID_QUERY_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define BOULDERDASH_GRID_QUERY_AVX2 1
+#endif
+
+namespace boulderdash {
+
+namespace {
+constexpr std::size_t kBlockCells = 64;
+constexpr std::size_t kWordsPerChunk = 64;    // Mask words produced per kernel call by the counting queries
+
+// The types of a set as bytes, to compare cells against
+struct Needles {
+    std::array<int8_t, kNumHiddenCellType> values{};
+    int count = 0;
+    uint64_t bits;
+
+    explicit Needles(ElementSet elements) noexcept : bits(elements.bits()) {
+        for (uint64_t bits = elements.bits(); bits != 0; bits &= bits - 1) {
+            values[static_cast<std::size_t>(count++)] = static_cast<int8_t>(std::countr_zero(bits));
+        }
+    }
+};
+
+// Writes one mask word per 64 cell block, for num_blocks whole blocks
+using MaskBlocksFn = void (*)(const int8_t *cells, std::size_t num_blocks, const Needles &needles, uint64_t *out);
+
+[[maybe_unused]] void MaskBlocksScalar(const int8_t *cells, std::size_t num_blocks, const Needles &needles,
+                                       uint64_t *out) {
+    // One bit test per cell whatever the set size, kNull and other negative values never match
+    for (std::size_t block = 0; block < num_blocks; ++block) {
+        const int8_t *block_cells = cells + (block * kBlockCells);    // NOLINT(*-pointer-arithmetic)
+        uint64_t mask = 0;
+        for (std::size_t i = 0; i < kBlockCells; ++i) {
+            const auto cell = static_cast<uint8_t>(block_cells[i]);    // NOLINT(*-pointer-arithmetic)
+            mask |= static_cast<uint64_t>(cell < 64U && ((needles.bits >> (cell & 63U)) & 1) != 0) << i;
+        }
+        out[block] = mask;    // NOLINT(*-pointer-arithmetic)
+    }
+}
+
+#ifdef BOULDERDASH_GRID_QUERY_SSE2
+void MaskBlocksSse2(const int8_t *cells, std::size_t num_blocks, const Needles &needles, uint64_t *out) {
+    constexpr std::size_t kLanes = 16;
+    const auto load = [](const int8_t *p) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));    // NOLINT(*-reinterpret-cast)
+    };
+    const auto movemask = [](__m128i v, std::size_t part) {
+        return static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(v))) << (part * kLanes);
+    };
+    for (std::size_t block = 0; block < num_blocks; ++block) {
+        const int8_t *block_cells = cells + (block * kBlockCells);    // NOLINT(*-pointer-arithmetic)
+        const __m128i cells0 = load(block_cells);
+        const __m128i cells1 = load(block_cells + kLanes);          // NOLINT(*-pointer-arithmetic)
+        const __m128i cells2 = load(block_cells + (2 * kLanes));    // NOLINT(*-pointer-arithmetic)
+        const __m128i cells3 = load(block_cells + (3 * kLanes));    // NOLINT(*-pointer-arithmetic)
+        __m128i matched0 = _mm_setzero_si128();
+        __m128i matched1 = _mm_setzero_si128();
+        __m128i matched2 = _mm_setzero_si128();
+        __m128i matched3 = _mm_setzero_si128();
+        for (int n = 0; n < needles.count; ++n) {
+            const __m128i needle = _mm_set1_epi8(needles.values[static_cast<std::size_t>(n)]);
+            matched0 = _mm_or_si128(matched0, _mm_cmpeq_epi8(cells0, needle));
+            matched1 = _mm_or_si128(matched1, _mm_cmpeq_epi8(cells1, needle));
+            matched2 = _mm_or_si128(matched2, _mm_cmpeq_epi8(cells2, needle));
+            matched3 = _mm_or_si128(matched3, _mm_cmpeq_epi8(cells3, needle));
+        }
+        out[block] = movemask(matched0, 0) | movemask(matched1, 1) | movemask(matched2, 2) |    // NOLINT
+                     movemask(matched3, 3);
+    }
+}
+#endif
+
+#ifdef BOULDERDASH_GRID_QUERY_AVX2
+__attribute__((target("avx2"))) void MaskBlocksAvx2(const int8_t *cells, std::size_t num_blocks,
+                                                    const Needles &needles, uint64_t *out) {
+    constexpr std::size_t kLanes = 32;
+    for (std::size_t block = 0; block < num_blocks; ++block) {
+        const int8_t *block_cells = cells + (block * kBlockCells);    // NOLINT(*-pointer-arithmetic)
+        const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block_cells));    // NOLINT
+        const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block_cells + kLanes));    // NOLINT
+        __m256i matched_low = _mm256_setzero_si256();
+        __m256i matched_high = _mm256_setzero_si256();
+        for (int n = 0; n < needles.count; ++n) {
+            const __m256i needle = _mm256_set1_epi8(needles.values[static_cast<std::size_t>(n)]);
+            matched_low = _mm256_or_si256(matched_low, _mm256_cmpeq_epi8(low, needle));
+            matched_high = _mm256_or_si256(matched_high, _mm256_cmpeq_epi8(high, needle));
+        }
+        out[block] = static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(matched_low))) |    // NOLINT
+                     (static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(matched_high))) << kLanes);
+    }
+}
+#endif
+
+struct Kernel {
+    MaskBlocksFn mask_blocks;
+    const char *isa;
+};
+
+auto SelectKernel() noexcept -> Kernel {
+#ifdef BOULDERDASH_GRID_QUERY_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return {&MaskBlocksAvx2, "avx2"};
+    }
+#endif
+#ifdef BOULDERDASH_GRID_QUERY_SSE2
+    return {&MaskBlocksSse2, "sse2"};
+#else
+    return {&MaskBlocksScalar, "scalar"};
+#endif
+}
+
+auto GetKernel() noexcept -> const Kernel & {
+    static const Kernel kernel = SelectKernel();
+    return kernel;
+}
+
+// Mask the trailing partial block, padding with kNull which is never in a set
+auto MaskTail(const int8_t *cells, std::size_t num_cells, const Needles &needles) noexcept -> uint64_t {
+    std::array<int8_t, kBlockCells> padded{};
+    padded.fill(static_cast<int8_t>(HiddenCellType::kNull));
+    std::memcpy(padded.data(), cells, num_cells);
+    uint64_t mask = 0;
+    GetKernel().mask_blocks(padded.data(), 1, needles, &mask);
+    return mask;
+}
+
+// Call fn(first_word_index, words) for chunks of mask words covering all cells, stopping early if fn returns true
+template <typename F>
+auto ForEachMaskChunk(std::span<const HiddenCellType> cells, ElementSet elements, F &&fn) -> bool {
+    const Needles needles(elements);
+    const auto *data = reinterpret_cast<const int8_t *>(cells.data());    // NOLINT(*-reinterpret-cast)
+    const std::size_t num_blocks = cells.size() / kBlockCells;
+    std::array<uint64_t, kWordsPerChunk> words{};
+    for (std::size_t block = 0; block < num_blocks; block += kWordsPerChunk) {
+        const std::size_t count = std::min(kWordsPerChunk, num_blocks - block);
+        GetKernel().mask_blocks(data + (block * kBlockCells), count, needles, words.data());    // NOLINT
+        if (fn(block, std::span<const uint64_t>(words.data(), count))) {
+            return true;
+        }
+    }
+    if (const std::size_t tail = cells.size() % kBlockCells; tail > 0) {
+        words[0] = MaskTail(data + (num_blocks * kBlockCells), tail, needles);    // NOLINT(*-pointer-arithmetic)
+        return fn(num_blocks, std::span<const uint64_t>(words.data(), 1));
+    }
+    return false;
+}
+}    // namespace
+
+auto count_cells(std::span<const HiddenCellType> cells, ElementSet elements) noexcept -> std::size_t {
+    std::size_t count = 0;
+    if (elements.empty()) {
+        return count;
+    }
+    ForEachMaskChunk(cells, elements, [&](std::size_t, std::span<const uint64_t> words) {
+        for (const uint64_t word : words) {
+            count += static_cast<std::size_t>(std::popcount(word));
+        }
+        return false;
+    });
+    return count;
+}
+
+auto any_cells(std::span<const HiddenCellType> cells, ElementSet elements) noexcept -> bool {
+    if (elements.empty()) {
+        return false;
+    }
+    return ForEachMaskChunk(cells, elements, [](std::size_t, std::span<const uint64_t> words) {
+        return std::ranges::any_of(words, [](uint64_t word) { return word != 0; });
+    });
+}
+
+void match_cells(std::span<const HiddenCellType> cells, ElementSet elements, std::span<uint64_t> out) noexcept {
+    const std::size_t num_words = (cells.size() + kBlockCells - 1) / kBlockCells;
+    assert(out.size() >= num_words);
+    std::fill_n(out.begin(), num_words, 0);
+    if (elements.empty()) {
+        return;
+    }
+    ForEachMaskChunk(cells, elements, [&](std::size_t first, std::span<const uint64_t> words) {
+        std::ranges::copy(words, out.begin() + static_cast<std::ptrdiff_t>(first));
+        return false;
+    });
+}
+
+void find_cells(std::span<const HiddenCellType> cells, ElementSet elements, std::vector<int> &out) {
+    if (elements.empty()) {
+        return;
+    }
+    ForEachMaskChunk(cells, elements, [&](std::size_t first, std::span<const uint64_t> words) {
+        for (std::size_t i = 0; i < words.size(); ++i) {
+            const auto base = static_cast<int>((first + i) * kBlockCells);
+            for (uint64_t word = words[i]; word != 0; word &= word - 1) {
+                out.push_back(base + std::countr_zero(word));
+            }
+        }
+        return false;
+    });
+}
+
+auto grid_query_isa() noexcept -> const char * {
+    return GetKernel().isa;
+}
+
+}    // namespace boulderdash
@@ -0,0 +1,85 @@
+#ifndef BOULDERDASH_GRID_QUERY_H_
+#define BOULDERDASH_GRID_QUERY_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <span>
+#include <vector>
+
+#include "definitions.h"
+
+namespace boulderdash {
+
+static_assert(kNumHiddenCellType <= 64, "ElementSet holds one bit per hidden cell type");
+
+// Set of hidden cell types, for queries matching any of several types at once
+class ElementSet {
+public:
+    constexpr ElementSet() noexcept = default;
+    constexpr ElementSet(std::initializer_list<HiddenCellType> elements) noexcept {
+        for (const auto element : elements) {
+            insert(element);
+        }
+    }
+
+    constexpr auto insert(HiddenCellType element) noexcept -> ElementSet & {
+        assert(static_cast<int>(element) >= 0 && static_cast<int>(element) < kNumHiddenCellType);
+        bits_ |= uint64_t{1} << static_cast<int>(element);
+        return *this;
+    }
+    constexpr auto erase(HiddenCellType element) noexcept -> ElementSet & {
+        bits_ &= ~(uint64_t{1} << static_cast<int>(element));
+        return *this;
+    }
+    [[nodiscard]] constexpr auto contains(HiddenCellType element) const noexcept -> bool {
+        return static_cast<int>(element) >= 0 && ((bits_ >> static_cast<int>(element)) & 1) != 0;
+    }
+    [[nodiscard]] constexpr auto empty() const noexcept -> bool {
+        return bits_ == 0;
+    }
+    [[nodiscard]] constexpr auto bits() const noexcept -> uint64_t {
+        return bits_;
+    }
+    constexpr auto operator==(const ElementSet &other) const noexcept -> bool = default;
+
+private:
+    uint64_t bits_ = 0;
+};
+
+// Vectorized scans of a grid of hidden cell types, comparing 64 cells per step.
+// The widest instruction set supported by the running CPU is picked once, on first use.
+
+/**
+ * Count the cells matching any type in the set.
+ * The cost grows with the number of types in the set, a handful is cheap.
+ * @param cells The cells to scan
+ * @param elements The types to match
+ */
+[[nodiscard]] auto count_cells(std::span<const HiddenCellType> cells, ElementSet elements) noexcept -> std::size_t;
+
+/**
+ * Check if any cell matches a type in the set, stopping at the first block containing a match
+ */
+[[nodiscard]] auto any_cells(std::span<const HiddenCellType> cells, ElementSet elements) noexcept -> bool;
+
+/**
+ * Build a bitmask of the cells matching any type in the set: bit (i % 64) of out[i / 64] is set if cells[i] matches.
+ * @param out Destination of at least (cells.size() + 63) / 64 words, bits past the last cell are cleared
+ */
+void match_cells(std::span<const HiddenCellType> cells, ElementSet elements, std::span<uint64_t> out) noexcept;
+
+/**
+ * Append the indices of the cells matching any type in the set, in increasing order
+ */
+void find_cells(std::span<const HiddenCellType> cells, ElementSet elements, std::vector<int> &out);
+
+/**
+ * Name of the instruction set used by the grid queries: "avx2", "sse2" or "scalar"
+ */
+[[nodiscard]] auto grid_query_isa() noexcept -> const char *;
+
+}    // namespace boulderdash
+
+#endif    // BOULDERDASH_GRID_QUERY_H_
@@ -0,0 +1,521 @@
+#include "level_generator.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <format>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "boulderdash_base.h"
+#include "definitions.h"
+
+namespace boulderdash {
+
+namespace {
+using H = HiddenCellType;
+
+constexpr int kSide = 14;
+constexpr int kNumCells = kSide * kSide;
+constexpr double kDirtPercentage = 0.1;
+constexpr double kOpenGateChance = 0.75;    // Chance of an unlocked room getting an open gate rather than a gap
+constexpr int kHardDiamonds = 4;
+constexpr std::array<H, 4> kKeys = {H::kKeyRed, H::kKeyBlue, H::kKeyGreen, H::kKeyYellow};
+constexpr std::array<H, 4> kGatesOpen = {H::kGateRedOpen, H::kGateBlueOpen, H::kGateGreenOpen, H::kGateYellowOpen};
+constexpr std::array<H, 4> kGatesClosed = {H::kGateRedClosed, H::kGateBlueClosed, H::kGateGreenClosed,
+                                           H::kGateYellowClosed};
+
+// A door is a wall cell which can be opened, with the two cells either side of it which must then be kept clear
+struct Door {
+    int wall;
+    std::array<int, 2> sides;
+};
+
+struct Room {
+    std::vector<int> walls;
+    std::vector<int> inner;
+    std::vector<Door> doors;
+};
+
+// Room layout of scripts/scenario_create.py, in the same order
+const std::array<Room, 5> kRooms = {{
+    // Upper left
+    {{4, 18, 32, 45, 56, 57, 58},
+     {0, 1, 2, 14, 15, 16, 28, 29, 30, 31, 44},
+     {{4, {3, 5}}, {18, {17, 19}}, {56, {42, 70}}, {57, {43, 71}}}},
+    // Upper right
+    {{9, 23, 37, 52, 67, 68, 69},
+     {11, 12, 13, 25, 26, 27, 38, 39, 40, 41, 53},
+     {{9, {8, 10}}, {23, {22, 24}}, {68, {54, 82}}, {69, {55, 83}}}},
+    // Lower left
+    {{126, 127, 128, 143, 158, 172, 186},
+     {142, 154, 155, 156, 157, 168, 169, 170, 182, 183, 184},
+     {{126, {112, 140}}, {127, {113, 141}}, {172, {171, 173}}, {186, {185, 187}}}},
+    // Lower right
+    {{137, 138, 139, 150, 163, 177, 191},
+     {151, 164, 165, 166, 167, 179, 180, 181, 193, 194, 195},
+     {{138, {124, 152}}, {139, {125, 153}}, {177, {176, 178}}, {191, {190, 192}}}},
+    // Middle
+    {{62, 63, 75, 78, 88, 93, 102, 107, 117, 120, 132, 133},
+     {90, 91, 104, 105},
+     {{62, {48, 76}},
+      {63, {49, 77}},
+      {88, {87, 89}},
+      {93, {92, 94}},
+      {102, {101, 103}},
+      {107, {106, 108}},
+      {132, {118, 146}},
+      {133, {119, 147}}}},
+}};
+
+// Cells kept clear so the rooms stay connected
+constexpr std::array<int, 28> kCorridors = {46,  47,  59,  60,  61,  73,  74,  50,  51,  64,  65,  66,  79,  80,
+                                            115, 116, 129, 130, 131, 144, 145, 121, 122, 134, 135, 136, 148, 149};
+
+// Random choices built only on the raw engine output, which the standard fixes, so levels are the same on every
+// platform (the standard distributions and std::shuffle are implementation defined)
+class Random {
+public:
+    explicit Random(uint64_t seed) : engine_(seed) {}
+
+    // Uniform integer in [0, n)
+    auto below(std::size_t n) -> std::size_t {
+        // Reject the lowest 2^64 mod n values so every remainder is equally likely
+        const auto bound = static_cast<uint64_t>(n);
+        const uint64_t threshold = (0 - bound) % bound;
+        while (true) {
+            const uint64_t value = engine_();
+            if (value >= threshold) {
+                return static_cast<std::size_t>(value % bound);
+            }
+        }
+    }
+
+    // True with the given probability
+    auto chance(double p) -> bool {
+        constexpr double kScale = 1.0 / static_cast<double>(uint64_t{1} << 53);
+        return static_cast<double>(engine_() >> 11) * kScale < p;
+    }
+
+    template <typename T>
+    auto choice(const std::vector<T> &values) -> T {
+        return values[below(values.size())];
+    }
+
+    template <typename T>
+    void shuffle(std::vector<T> &values) {
+        for (std::size_t i = values.size(); i > 1; --i) {
+            std::swap(values[i - 1], values[below(i)]);
+        }
+    }
+
+    // Pick count distinct values
+    template <typename T>
+    auto sample(std::vector<T> values, std::size_t count) -> std::vector<T> {
+        for (std::size_t i = 0; i < count; ++i) {
+            std::swap(values[i], values[i + below(values.size() - i)]);
+        }
+        values.resize(count);
+        return values;
+    }
+
+private:
+    std::mt19937_64 engine_;
+};
+
+class Generator {
+public:
+    explicit Generator(uint64_t seed) : random_(seed), blocked_(kNumCells, false) {
+        for (const auto &room : kRooms) {
+            for (const int idx : room.walls) {
+                map_[static_cast<std::size_t>(idx)] = H::kWallBrick;
+                Block(idx);
+            }
+        }
+        for (const int idx : kCorridors) {
+            Block(idx);
+        }
+        for (auto &cell : map_) {
+            if (cell != H::kWallBrick) {
+                cell = random_.chance(kDirtPercentage) ? H::kDirt : H::kEmpty;
+            }
+        }
+        room_order_ = {0, 1, 2, 3, 4};
+        random_.shuffle(room_order_);
+        key_order_ = {0, 1, 2, 3};
+        random_.shuffle(key_order_);
+    }
+
+    // Diamond in a locked room, its key in another room, other rooms open, and possibly a decoy key
+    void one_key(int num_diamonds) {
+        const std::size_t diamond_room = room_order_[0];
+        const std::size_t key = PopKey();
+        BlockRoom(diamond_room);
+        LockRoom(diamond_room, key);
+        Set(random_.choice(kRooms[diamond_room].inner), H::kDiamond);
+        PlaceKey(room_order_[1], key);
+        OpenRooms({diamond_room});
+
+        if (num_diamonds > 1) {
+            for (const int idx : random_.sample(FreeCells(), static_cast<std::size_t>(num_diamonds - 1))) {
+                Set(idx, H::kDiamond);
+                Block(idx);
+            }
+        }
+        const auto cells = random_.sample(FreeCells(), 3);
+        Set(cells[0], H::kAgent);
+        Set(cells[1], H::kExitClosed);
+        if (random_.below(2) == 0) {
+            std::vector<std::size_t> decoys;
+            for (std::size_t i = 0; i < kKeys.size(); ++i) {
+                if (i != key) {
+                    decoys.push_back(i);
+                }
+            }
+            Set(cells[2], kKeys[random_.choice(decoys)]);
+        }
+    }
+
+    // Diamond behind a chain of three locked rooms, each key in the next room
+    void three_keys() {
+        const std::size_t diamond_room = room_order_[0];
+        std::array<std::size_t, 3> keys{};
+        for (auto &key : keys) {
+            key = PopKey();
+        }
+        BlockRoom(diamond_room);
+        LockRoom(diamond_room, keys[0]);
+        Set(random_.choice(kRooms[diamond_room].inner), H::kDiamond);
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            const std::size_t key_room = room_order_[i + 1];
+            PlaceKey(key_room, keys[i]);
+            if (i + 1 < keys.size()) {
+                BlockRoom(key_room);
+                LockRoom(key_room, keys[i + 1]);
+            }
+        }
+        OpenRooms({diamond_room, room_order_[1], room_order_[2]});
+
+        const auto cells = random_.sample(FreeCells(), 2);
+        Set(cells[0], H::kAgent);
+        Set(cells[1], H::kExitClosed);
+    }
+
+    [[nodiscard]] auto to_string(int num_diamonds) const -> std::string {
+        std::string out = std::format("{:d}|{:d}|{:d}", kSide, kSide, num_diamonds);
+        for (const auto cell : map_) {
+            out += std::format("|{:02d}", static_cast<int>(cell));
+        }
+        return out;
+    }
+
+private:
+    void Set(int idx, H element) {
+        map_[static_cast<std::size_t>(idx)] = element;
+    }
+    void Block(int idx) {
+        blocked_[static_cast<std::size_t>(idx)] = true;
+    }
+
+    auto PopKey() -> std::size_t {
+        const std::size_t key = key_order_.back();
+        key_order_.pop_back();
+        return key;
+    }
+
+    // Keep the agent and exit out of a room
+    void BlockRoom(std::size_t room) {
+        for (const int idx : kRooms[room].inner) {
+            Block(idx);
+        }
+        for (const auto &door : kRooms[room].doors) {
+            Block(door.sides[0]);
+            Block(door.sides[1]);
+        }
+    }
+
+    // Put a closed gate of the key's colour on one of the room's doors
+    void LockRoom(std::size_t room, std::size_t key) {
+        const Door &door = random_.choice(kRooms[room].doors);
+        Set(door.wall, kGatesClosed[key]);
+        Set(door.sides[0], H::kEmpty);
+        Set(door.sides[1], H::kEmpty);
+    }
+
+    void PlaceKey(std::size_t room, std::size_t key) {
+        const int idx = random_.choice(kRooms[room].inner);
+        Set(idx, kKeys[key]);
+        Block(idx);
+    }
+
+    // Open a door of every room not excluded, as a gap or an open gate of a spare colour
+    void OpenRooms(const std::vector<std::size_t> &excluded) {
+        for (std::size_t room = 0; room < kRooms.size(); ++room) {
+            if (std::ranges::find(excluded, room) != excluded.end()) {
+                continue;
+            }
+            const Door &door = random_.choice(kRooms[room].doors);
+            for (const int idx : door.sides) {
+                Set(idx, H::kEmpty);
+                Block(idx);
+            }
+            if (!random_.chance(kOpenGateChance) || key_order_.empty()) {
+                Set(door.wall, H::kEmpty);
+            } else {
+                Set(door.wall, kGatesOpen[PopKey()]);
+            }
+        }
+    }
+
+    [[nodiscard]] auto FreeCells() const -> std::vector<int> {
+        std::vector<int> cells;
+        for (int idx = 0; idx < kNumCells; ++idx) {
+            if (!blocked_[static_cast<std::size_t>(idx)]) {
+                cells.push_back(idx);
+            }
+        }
+        return cells;
+    }
+
+    Random random_;
+    std::array<H, kNumCells> map_{};
+    std::vector<bool> blocked_;
+    std::vector<std::size_t> room_order_;
+    std::vector<std::size_t> key_order_;
+};
+
+auto key_bit(H element) noexcept -> int {
+    switch (element) {
+        case H::kKeyRed:
+        case H::kGateRedClosed:
+            return 1;
+        case H::kKeyBlue:
+        case H::kGateBlueClosed:
+            return 2;
+        case H::kKeyGreen:
+        case H::kGateGreenClosed:
+            return 4;
+        case H::kKeyYellow:
+        case H::kGateYellowClosed:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+auto is_key(H element) noexcept -> bool {
+    return std::ranges::find(kKeys, element) != kKeys.end();
+}
+}    // namespace
+
+auto generate_level(LevelScenario scenario, uint64_t seed) -> std::string {
+    Generator generator(seed);
+    switch (scenario) {
+        case LevelScenario::kOneKey:
+            generator.one_key(1);
+            return generator.to_string(1);
+        case LevelScenario::kThreeKeys:
+            generator.three_keys();
+            return generator.to_string(1);
+        case LevelScenario::kHard:
+            generator.one_key(kHardDiamonds);
+            return generator.to_string(kHardDiamonds);
+    }
+    throw std::invalid_argument(std::format("Unknown level scenario {:d}", static_cast<int>(scenario)));
+}
+
+auto goals_reachable(const BoulderDashGameState &state) -> bool {
+    const auto shape = state.observation_shape();
+    const int rows = shape[1];
+    const int cols = shape[2];
+    const int num_cells = rows * cols;
+    std::vector<int8_t> grid(static_cast<std::size_t>(num_cells));
+    state.get_hidden_grid(grid);
+    const auto cell = [&](int idx) { return static_cast<H>(grid[static_cast<std::size_t>(idx)]); };
+    const auto passable = [](H element) {
+        return element != H::kWallBrick && element != H::kWallSteel && element != H::kWallMagicDormant &&
+               element != H::kWallMagicOn && element != H::kWallMagicExpired;
+    };
+
+    // Breadth first search over (cell, keys held), closed gates passable once their key is held
+    constexpr int kKeyMasks = 16;
+    std::vector<bool> seen(static_cast<std::size_t>(num_cells * kKeyMasks), false);
+    std::vector<bool> reached(static_cast<std::size_t>(num_cells), false);
+    std::deque<std::pair<int, int>> open;
+    const int start = state.get_agent_index();
+    open.emplace_back(start, key_bit(cell(start)));
+    seen[static_cast<std::size_t>(start * kKeyMasks)] = true;
+    while (!open.empty()) {
+        const auto [idx, keys] = open.front();
+        open.pop_front();
+        reached[static_cast<std::size_t>(idx)] = true;
+        const int row = idx / cols;
+        const int col = idx % cols;
+        for (const auto &[dr, dc] : {std::pair(-1, 0), std::pair(0, 1), std::pair(1, 0), std::pair(0, -1)}) {
+            const int r = row + dr;
+            const int c = col + dc;
+            if (r < 0 || r >= rows || c < 0 || c >= cols) {
+                continue;
+            }
+            const int next = (r * cols) + c;
+            const H element = cell(next);
+            const int gate = std::ranges::find(kGatesClosed, element) != kGatesClosed.end() ? key_bit(element) : 0;
+            if (!passable(element) || (gate & keys) != gate) {
+                continue;
+            }
+            const int next_keys = keys | (is_key(element) ? key_bit(element) : 0);
+            const auto slot = static_cast<std::size_t>((next * kKeyMasks) + next_keys);
+            if (!seen[slot]) {
+                seen[slot] = true;
+                open.emplace_back(next, next_keys);
+            }
+        }
+    }
+
+    for (int idx = 0; idx < num_cells; ++idx) {
+        const H element = cell(idx);
+        const bool goal = element == H::kDiamond || element == H::kExitClosed || element == H::kExitOpen;
+        if (goal && !reached[static_cast<std::size_t>(idx)]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+LevelStream::LevelStream(LevelStreamOptions options) : options_(std::move(options)) {
+    if (options_.capacity == 0 || options_.num_threads <= 0) {
+        throw std::invalid_argument(std::format("Level stream needs a positive capacity and thread count, got {:d} "
+                                                "and {:d}",
+                                                options_.capacity, options_.num_threads));
+    }
+    slots_.resize(options_.capacity);
+    workers_.reserve(static_cast<std::size_t>(options_.num_threads));
+    for (int i = 0; i < options_.num_threads; ++i) {
+        workers_.emplace_back([this]() { Generate(); });
+    }
+}
+
+LevelStream::~LevelStream() {
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    slot_free_.notify_all();
+    for (auto &worker : workers_) {
+        worker.join();
+    }
+}
+
+void LevelStream::Generate() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        slot_free_.wait(lock, [this]() { return stopping_ || next_attempt_ < consumed_ + slots_.size(); });
+        if (stopping_) {
+            return;
+        }
+        const uint64_t attempt = next_attempt_++;
+        lock.unlock();
+
+        Slot result;
+        try {
+            const uint64_t seed = options_.seed + attempt;
+            std::string board_str = generate_level(options_.scenario, seed);
+            BoulderDashGameState state(board_str, options_.params);
+            if ((options_.require_reachable && !goals_reachable(state)) ||
+                (options_.filter && !options_.filter(state))) {
+                result.status = SlotState::kRejected;
+            } else {
+                result.status = SlotState::kAccepted;
+                result.level.emplace(Level{seed, std::move(board_str), std::move(state)});
+            }
+        } catch (...) {
+            result.status = SlotState::kFailed;
+            result.error = std::current_exception();
+        }
+
+        lock.lock();
+        rejected_ += result.status == SlotState::kRejected ? 1 : 0;
+        const bool is_next = attempt == consumed_;
+        slots_[attempt % slots_.size()] = std::move(result);
+        if (is_next) {
+            level_ready_.notify_all();
+        }
+    }
+}
+
+auto LevelStream::TakeReady() -> std::optional<Level> {
+    while (true) {
+        Slot &slot = slots_[consumed_ % slots_.size()];
+        switch (slot.status) {
+            case SlotState::kPending:
+                return std::nullopt;
+            case SlotState::kRejected:
+                slot = Slot{};
+                ++consumed_;
+                slot_free_.notify_one();
+                continue;
+            case SlotState::kFailed: {
+                const std::exception_ptr error = slot.error;
+                slot = Slot{};
+                ++consumed_;
+                slot_free_.notify_one();
+                std::rethrow_exception(error);
+            }
+            case SlotState::kAccepted: {
+                std::optional<Level> level = std::move(slot.level);
+                slot = Slot{};
+                ++consumed_;
+                slot_free_.notify_one();
+                return level;
+            }
+        }
+    }
+}
+
+auto LevelStream::next() -> Level {
+    std::unique_lock<std::mutex> lock(mutex_);
+    bool waited = false;
+    while (true) {
+        if (auto level = TakeReady()) {
+            waits_ += waited ? 1 : 0;
+            return std::move(*level);
+        }
+        waited = true;
+        level_ready_.wait(lock, [this]() { return slots_[consumed_ % slots_.size()].status != SlotState::kPending; });
+    }
+}
+
+auto LevelStream::try_next() -> std::optional<Level> {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return TakeReady();
+}
+
+auto LevelStream::ready() const -> std::size_t {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t count = 0;
+    for (uint64_t attempt = consumed_; attempt < next_attempt_; ++attempt) {
+        count += slots_[attempt % slots_.size()].status == SlotState::kAccepted ? 1 : 0;
+    }
+    return count;
+}
+
+auto LevelStream::waits() const -> uint64_t {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return waits_;
+}
+
+auto LevelStream::rejected() const -> uint64_t {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return rejected_;
+}
+
+}    // namespace boulderdash
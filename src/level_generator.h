@@ -0,0 +1,138 @@
+#ifndef BOULDERDASH_LEVEL_GENERATOR_H_
+#define BOULDERDASH_LEVEL_GENERATOR_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "boulderdash_base.h"
+
+namespace boulderdash {
+
+// Level layouts of scripts/scenario_create.py, all 14x14 boards with five rooms
+enum class LevelScenario {
+    kOneKey = 0,       // Diamond in a room locked by one key, found in another room, plus a possible decoy key
+    kThreeKeys = 1,    // Diamond behind a chain of three locked rooms
+    kHard = 2,         // As kOneKey, with three more diamonds in the open
+};
+
+/**
+ * Generate a level string, a native port of the generators in scripts/scenario_create.py.
+ * Levels depend only on the scenario and seed, on every platform, but are not the same levels as the script's
+ * numpy generator gives for the seed.
+ * @param scenario The layout to generate
+ * @param seed Seed of the level
+ * @return The level string, see BoulderDashGameState(const std::string &, const GameParameters &)
+ */
+[[nodiscard]] auto generate_level(LevelScenario scenario, uint64_t seed) -> std::string;
+
+/**
+ * Fast necessary condition for a level to be solvable, ignoring physics: every diamond and the exit can be reached
+ * from the agent by walking through anything but walls, with closed gates passable once their key is reached.
+ * @param state The state to check
+ */
+[[nodiscard]] auto goals_reachable(const BoulderDashGameState &state) -> bool;
+
+struct LevelStreamOptions {
+    LevelScenario scenario = LevelScenario::kOneKey;
+    uint64_t seed = 0;                // Seed of the first level, each attempt uses the next seed
+    std::size_t capacity = 1024;      // Seeds generated ahead of the consumer
+    int num_threads = 1;              // Background generator threads
+    bool require_reachable = true;    // Drop levels failing goals_reachable()
+    GameParameters params = {};       // Parameters of the generated states
+    // Extra check run on the generator threads, levels it returns false for are dropped
+    std::function<bool(const BoulderDashGameState &)> filter = nullptr;
+};
+
+// Endless stream of generated levels for environment resets.
+// Background threads generate levels for increasing seeds up to capacity seeds ahead of the consumer, so once the
+// stream is warm next() only takes a level which is already built. Levels come out in seed order, skipping those
+// which were filtered out, so a stream with the same options always gives the same levels whatever the number of
+// threads. Filtered seeds still take a place in the window, so a strict filter shrinks the effective capacity.
+class LevelStream {
+public:
+    struct Level {
+        uint64_t seed;
+        std::string board_str;
+        BoulderDashGameState state;
+    };
+
+    /**
+     * Start the generator threads.
+     * @param options Stream options
+     * @throw std::invalid_argument if the capacity or number of threads is zero
+     */
+    explicit LevelStream(LevelStreamOptions options = {});
+    ~LevelStream();
+
+    LevelStream(const LevelStream &) = delete;
+    LevelStream(LevelStream &&) = delete;
+    auto operator=(const LevelStream &) -> LevelStream & = delete;
+    auto operator=(LevelStream &&) -> LevelStream & = delete;
+
+    /**
+     * Take the next level, waiting only if it is not generated yet.
+     * @throw Any exception thrown while generating or filtering the level
+     */
+    [[nodiscard]] auto next() -> Level;
+
+    /**
+     * Take the next level if it is already generated, without waiting
+     */
+    [[nodiscard]] auto try_next() -> std::optional<Level>;
+
+    /**
+     * Number of levels ready to be taken without waiting
+     */
+    [[nodiscard]] auto ready() const -> std::size_t;
+
+    /**
+     * Number of calls to next() which had to wait for generation, a sign the capacity or thread count is too low
+     */
+    [[nodiscard]] auto waits() const -> uint64_t;
+
+    /**
+     * Number of generated levels dropped by the filters
+     */
+    [[nodiscard]] auto rejected() const -> uint64_t;
+
+private:
+    enum class SlotState {
+        kPending,
+        kAccepted,
+        kRejected,
+        kFailed,
+    };
+    struct Slot {
+        SlotState status = SlotState::kPending;
+        std::optional<Level> level;
+        std::exception_ptr error;
+    };
+
+    void Generate();
+    // Take the level at the consumer's seed if ready, skipping rejected seeds. Requires mutex_ to be held.
+    auto TakeReady() -> std::optional<Level>;
+
+    LevelStreamOptions options_;
+    mutable std::mutex mutex_;
+    std::condition_variable level_ready_;
+    std::condition_variable slot_free_;
+    std::vector<Slot> slots_;      // Ring indexed by seed offset modulo capacity
+    uint64_t next_attempt_ = 0;    // Seed offset of the next level to generate
+    uint64_t consumed_ = 0;        // Seed offset of the next level to take
+    uint64_t waits_ = 0;
+    uint64_t rejected_ = 0;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+};
+
+}    // namespace boulderdash
+
+#endif    // BOULDERDASH_LEVEL_GENERATOR_H_
@@ -0,0 +1,72 @@
+#include "level_loader.h"
+
+#include <cstddef>
+#include <format>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "boulderdash_base.h"
+#include "thread_pool.h"
+
+namespace boulderdash {
+
+auto read_level_file(const std::string &path) -> std::vector<std::string> {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error(std::format("Unable to open level file {:s}", path));
+    }
+    std::vector<std::string> levels;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (!line.empty() && line.front() != ';') {
+            levels.push_back(std::move(line));
+        }
+    }
+    if (file.bad()) {
+        throw std::runtime_error(std::format("Unable to read level file {:s}", path));
+    }
+    return levels;
+}
+
+auto make_states(std::span<const std::string> levels, const GameParameters &params, int num_threads)
+    -> std::vector<BoulderDashGameState> {
+    std::vector<std::optional<BoulderDashGameState>> built(levels.size());
+    // Exceptions must not escape the pool, so keep the lowest failing level and report it afterwards
+    std::mutex error_mutex;
+    std::size_t error_index = levels.size();
+    std::string error_message;
+    ThreadPool::global().parallel_for(
+        levels.size(),
+        [&](std::size_t i) {
+            try {
+                built[i].emplace(levels[i], params);
+            } catch (const std::exception &e) {
+                const std::lock_guard<std::mutex> lock(error_mutex);
+                if (i < error_index) {
+                    error_index = i;
+                    error_message = e.what();
+                }
+            }
+        },
+        num_threads);
+    if (error_index < levels.size()) {
+        throw std::invalid_argument(std::format("Invalid level {:d}: {:s}", error_index, error_message));
+    }
+    std::vector<BoulderDashGameState> states;
+    states.reserve(levels.size());
+    for (auto &state : built) {
+        states.push_back(std::move(*state));
+    }
+    return states;
+}
+
+}    // namespace boulderdash
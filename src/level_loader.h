@@ -0,0 +1,34 @@
+#ifndef BOULDERDASH_LEVEL_LOADER_H_
+#define BOULDERDASH_LEVEL_LOADER_H_
+
+#include <span>
+#include <string>
+#include <vector>
+
+#include "boulderdash_base.h"
+
+namespace boulderdash {
+
+/**
+ * Read the levels of a level file, one level string per line.
+ * Blank lines and lines starting with ';' are skipped, and trailing carriage returns are removed.
+ * @param path Path of the level file
+ * @return The level strings in file order
+ * @throw std::runtime_error if the file cannot be read
+ */
+[[nodiscard]] auto read_level_file(const std::string &path) -> std::vector<std::string>;
+
+/**
+ * Construct a state for each level string, in parallel across levels.
+ * @param levels Level strings, see BoulderDashGameState(const std::string &, const GameParameters &)
+ * @param params Parameters shared by every state
+ * @param num_threads Maximum number of threads to use, 0 to use the global pool
+ * @return The states in level order
+ * @throw std::invalid_argument naming the first invalid level if any level fails to parse
+ */
+[[nodiscard]] auto make_states(std::span<const std::string> levels, const GameParameters &params = {},
+                               int num_threads = 0) -> std::vector<BoulderDashGameState>;
+
+}    // namespace boulderdash
+
+#endif    // BOULDERDASH_LEVEL_LOADER_H_
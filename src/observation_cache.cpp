@@ -0,0 +1,115 @@
+#include "observation_cache.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "boulderdash_base.h"
+
+namespace boulderdash {
+
+ObservationCache::ObservationCache(std::size_t capacity, std::size_t num_shards)
+    : capacity_(capacity) {
+    if (capacity == 0 || num_shards == 0) {
+        throw std::invalid_argument("Cache capacity and number of shards must be positive");
+    }
+    num_shards = std::min(num_shards, capacity);
+    shards_.reserve(num_shards);
+    for (std::size_t i = 0; i < num_shards; ++i) {
+        auto shard = std::make_unique<Shard>();
+        // Spread the remainder so shard capacities sum exactly to the total capacity
+        shard->capacity = (capacity / num_shards) + (i < capacity % num_shards ? 1 : 0);
+        shard->entries.reserve(shard->capacity);
+        shard->insertion_order.reserve(shard->capacity);
+        shards_.push_back(std::move(shard));
+    }
+}
+
+auto ObservationCache::get(const BoulderDashGameState &state) -> Observation {
+    const uint64_t hash = state.get_hash();
+    const auto [channels, rows, cols] = state.observation_shape();
+    const auto num_cells = static_cast<std::size_t>(rows) * static_cast<std::size_t>(cols);
+    Shard &shard = GetShard(hash);
+    {
+        const std::lock_guard<std::mutex> lock(shard.mutex);
+        const auto it = shard.entries.find(hash);
+        // A hash collision with a board of another size is treated as a miss, never returned
+        if (it != shard.entries.end() && it->second->size() == num_cells) {
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            return it->second;
+        }
+    }
+    // Encode outside the lock so other threads can use the shard meanwhile
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    auto observation = std::make_shared<const std::vector<int8_t>>(state.get_observation_compact());
+    const std::lock_guard<std::mutex> lock(shard.mutex);
+    Insert(shard, hash, observation);
+    return observation;
+}
+
+auto ObservationCache::find(uint64_t hash) const -> Observation {
+    Shard &shard = GetShard(hash);
+    const std::lock_guard<std::mutex> lock(shard.mutex);
+    const auto it = shard.entries.find(hash);
+    return it == shard.entries.end() ? nullptr : it->second;
+}
+
+void ObservationCache::clear() {
+    for (auto &shard : shards_) {
+        const std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->entries.clear();
+        shard->insertion_order.clear();
+        shard->next_evict = 0;
+    }
+    hits_ = 0;
+    misses_ = 0;
+}
+
+auto ObservationCache::hits() const noexcept -> uint64_t {
+    return hits_.load(std::memory_order_relaxed);
+}
+
+auto ObservationCache::misses() const noexcept -> uint64_t {
+    return misses_.load(std::memory_order_relaxed);
+}
+
+auto ObservationCache::size() const -> std::size_t {
+    std::size_t total = 0;
+    for (const auto &shard : shards_) {
+        const std::lock_guard<std::mutex> lock(shard->mutex);
+        total += shard->entries.size();
+    }
+    return total;
+}
+
+auto ObservationCache::capacity() const noexcept -> std::size_t {
+    return capacity_;
+}
+
+auto ObservationCache::GetShard(uint64_t hash) const noexcept -> Shard & {
+    // State hashes are already well mixed, so the upper bits pick the shard
+    constexpr int SHARD_SHIFT = 32;
+    return *shards_[static_cast<std::size_t>(hash >> SHARD_SHIFT) % shards_.size()];
+}
+
+void ObservationCache::Insert(Shard &shard, uint64_t hash, Observation observation) {
+    // Another thread may have inserted while we were encoding
+    if (!shard.entries.try_emplace(hash, std::move(observation)).second) {
+        return;
+    }
+    if (shard.insertion_order.size() < shard.capacity) {
+        shard.insertion_order.push_back(hash);
+        return;
+    }
+    // Full, evict the oldest entry and reuse its slot
+    shard.entries.erase(shard.insertion_order[shard.next_evict]);
+    shard.insertion_order[shard.next_evict] = hash;
+    shard.next_evict = (shard.next_evict + 1) % shard.capacity;
+}
+
+}    // namespace boulderdash
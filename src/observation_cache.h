@@ -0,0 +1,76 @@
+#ifndef BOULDERDASH_OBSERVATION_CACHE_H_
+#define BOULDERDASH_OBSERVATION_CACHE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "boulderdash_base.h"
+
+namespace boulderdash {
+
+// Bounded, thread-safe cache from state hash to compact observation (see get_observation_compact()).
+// The cache is split into independently locked shards, each evicting its oldest entry once full.
+class ObservationCache {
+public:
+    using Observation = std::shared_ptr<const std::vector<int8_t>>;
+
+    /**
+     * @param capacity Maximum number of observations held across all shards
+     * @param num_shards Number of independently locked shards
+     */
+    explicit ObservationCache(std::size_t capacity, std::size_t num_shards = DEFAULT_NUM_SHARDS);
+
+    /**
+     * Get the compact observation for the given state, computing and inserting it on a miss.
+     * An entry of the same hash but another board size is a miss, and the computed observation is not cached.
+     * @param state The state to get the observation for
+     * @return shared compact observation, which stays valid after eviction
+     */
+    [[nodiscard]] auto get(const BoulderDashGameState &state) -> Observation;
+
+    /**
+     * Lookup a cached observation by state hash without computing it.
+     * Does not count towards hits or misses.
+     * @param hash The state hash, as given by get_hash()
+     * @return the cached observation, or nullptr if not present
+     */
+    [[nodiscard]] auto find(uint64_t hash) const -> Observation;
+
+    /**
+     * Remove all entries and reset the hit/miss counters
+     */
+    void clear();
+
+    [[nodiscard]] auto hits() const noexcept -> uint64_t;
+    [[nodiscard]] auto misses() const noexcept -> uint64_t;
+    [[nodiscard]] auto size() const -> std::size_t;
+    [[nodiscard]] auto capacity() const noexcept -> std::size_t;
+
+    static constexpr std::size_t DEFAULT_NUM_SHARDS = 16;
+
+private:
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<uint64_t, Observation> entries;
+        std::vector<uint64_t> insertion_order;    // Ring of keys, oldest at next_evict
+        std::size_t next_evict = 0;
+        std::size_t capacity = 0;
+    };
+
+    [[nodiscard]] auto GetShard(uint64_t hash) const noexcept -> Shard &;
+    void Insert(Shard &shard, uint64_t hash, Observation observation);
+
+    std::size_t capacity_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<uint64_t> hits_ = 0;
+    std::atomic<uint64_t> misses_ = 0;
+};
+
+}    // namespace boulderdash
+
+#endif    // BOULDERDASH_OBSERVATION_CACHE_H_
@@ -0,0 +1,243 @@
+#include "observation_codec.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace boulderdash {
+
+namespace {
+struct Header {
+    std::array<char, 4> magic;
+    uint32_t version;
+    uint32_t rows;
+    uint32_t cols;
+    uint32_t keyframe_interval;
+    uint32_t reserved;
+    uint64_t num_frames;
+    uint64_t index_offset;    // Start of the keyframe index
+};
+
+constexpr std::array<char, 4> kMagic = {'B', 'D', 'O', 'C'};
+constexpr uint32_t kVersion = 1;
+constexpr uint64_t kNoFrame = ~uint64_t{0};
+constexpr int kMaxSide = 32767;    // Same bound as the level parser, so rows * cols cannot overflow
+
+void WriteVarint(std::vector<uint8_t> &out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+[[noreturn]] void ThrowCorrupt() {
+    throw std::invalid_argument("Observation stream is truncated or corrupt");
+}
+}    // namespace
+
+ObservationEncoder::ObservationEncoder(int rows, int cols, uint32_t keyframe_interval)
+    : rows_(static_cast<uint32_t>(rows)), cols_(static_cast<uint32_t>(cols)), keyframe_interval_(keyframe_interval) {
+    if (rows <= 0 || cols <= 0 || rows > kMaxSide || cols > kMaxSide) {
+        throw std::invalid_argument(std::format("Invalid observation dimensions {:d}x{:d}", rows, cols));
+    }
+    if (keyframe_interval == 0) {
+        throw std::invalid_argument("Keyframe interval must be positive");
+    }
+    data_.resize(sizeof(Header));
+}
+
+void ObservationEncoder::append(std::span<const int8_t> frame) {
+    const std::size_t size = std::size_t{rows_} * cols_;
+    if (frame.size() != size) {
+        throw std::invalid_argument(std::format("Expected a frame of {:d} cells, got {:d}", size, frame.size()));
+    }
+
+    if (num_frames_ % keyframe_interval_ == 0) {
+        keyframe_offsets_.push_back(data_.size());
+        for (std::size_t i = 0; i < size;) {
+            std::size_t run = 1;
+            while (i + run < size && frame[i + run] == frame[i]) {
+                ++run;
+            }
+            WriteVarint(data_, run);
+            data_.push_back(static_cast<uint8_t>(frame[i]));
+            i += run;
+        }
+    } else {
+        // Runs of changed cells, with short gaps merged into the run as literals since a gap costs at least 2 bytes
+        constexpr std::size_t kMaxMergedGap = 2;
+        runs_.clear();
+        for (std::size_t i = 0; i < size; ++i) {
+            if (frame[i] == previous_[i]) {
+                continue;
+            }
+            if (!runs_.empty() && i - runs_.back().second <= kMaxMergedGap) {
+                runs_.back().second = i + 1;
+            } else {
+                runs_.emplace_back(i, i + 1);
+            }
+        }
+        WriteVarint(data_, runs_.size());
+        std::size_t cursor = 0;
+        for (const auto &[begin, end] : runs_) {
+            WriteVarint(data_, begin - cursor);
+            WriteVarint(data_, end - begin);
+            for (std::size_t i = begin; i < end; ++i) {
+                data_.push_back(static_cast<uint8_t>(frame[i]));
+            }
+            cursor = end;
+        }
+    }
+    previous_.assign(frame.begin(), frame.end());
+    ++num_frames_;
+}
+
+auto ObservationEncoder::encoded_size() const noexcept -> std::size_t {
+    return data_.size() - sizeof(Header);
+}
+
+auto ObservationEncoder::finish() -> std::vector<uint8_t> {
+    Header header{};
+    header.magic = kMagic;
+    header.version = kVersion;
+    header.rows = rows_;
+    header.cols = cols_;
+    header.keyframe_interval = keyframe_interval_;
+    header.num_frames = num_frames_;
+    header.index_offset = data_.size();
+    std::memcpy(data_.data(), &header, sizeof(Header));
+    const std::size_t index_offset = data_.size();
+    data_.resize(index_offset + (keyframe_offsets_.size() * sizeof(uint64_t)));
+    std::memcpy(data_.data() + index_offset, keyframe_offsets_.data(), keyframe_offsets_.size() * sizeof(uint64_t));
+
+    std::vector<uint8_t> out = std::exchange(data_, std::vector<uint8_t>(sizeof(Header)));
+    keyframe_offsets_.clear();
+    previous_.clear();
+    num_frames_ = 0;
+    return out;
+}
+
+ObservationDecoder::ObservationDecoder(std::vector<uint8_t> data) : data_(std::move(data)) {
+    if (data_.size() < sizeof(Header)) {
+        throw std::invalid_argument("Not an observation stream");
+    }
+    Header header{};
+    std::memcpy(&header, data_.data(), sizeof(Header));
+    if (header.magic != kMagic || header.version != kVersion) {
+        throw std::invalid_argument("Not an observation stream, or written by an unsupported version");
+    }
+    constexpr auto kMaxHeaderSide = static_cast<uint32_t>(kMaxSide);
+    if (header.rows == 0 || header.cols == 0 || header.rows > kMaxHeaderSide || header.cols > kMaxHeaderSide ||
+        header.keyframe_interval == 0) {
+        ThrowCorrupt();
+    }
+    rows_ = header.rows;
+    cols_ = header.cols;
+    keyframe_interval_ = header.keyframe_interval;
+    num_frames_ = header.num_frames;
+
+    // Checked without overflow, as the counts come from untrusted data
+    const uint64_t num_keyframes = (num_frames_ / keyframe_interval_) + (num_frames_ % keyframe_interval_ != 0);
+    if (header.index_offset < sizeof(Header) || header.index_offset > data_.size() ||
+        num_keyframes != (data_.size() - header.index_offset) / sizeof(uint64_t) ||
+        (data_.size() - header.index_offset) % sizeof(uint64_t) != 0) {
+        ThrowCorrupt();
+    }
+    keyframe_offsets_.resize(num_keyframes);
+    std::memcpy(keyframe_offsets_.data(), data_.data() + header.index_offset, num_keyframes * sizeof(uint64_t));
+    for (const uint64_t offset : keyframe_offsets_) {
+        if (offset < sizeof(Header) || offset >= header.index_offset) {
+            ThrowCorrupt();
+        }
+    }
+    // Frames are only read up to the index
+    data_.resize(header.index_offset);
+    current_.resize(std::size_t{rows_} * cols_);
+}
+
+void ObservationDecoder::decode(uint64_t frame, std::span<int8_t> out) {
+    if (frame >= num_frames_) {
+        throw std::invalid_argument(std::format("Frame {:d} out of range, the stream has {:d}", frame, num_frames_));
+    }
+    if (out.size() != current_.size()) {
+        throw std::invalid_argument(std::format("Expected {:d} cells, got {:d}", current_.size(), out.size()));
+    }
+
+    // Continue from the last decoded frame when it is in the same keyframe interval, otherwise seek.
+    // The cached frame is invalid until decoding succeeds.
+    const uint64_t keyframe = frame / keyframe_interval_;
+    uint64_t at = std::exchange(current_frame_, kNoFrame);
+    if (at == kNoFrame || at > frame || at / keyframe_interval_ != keyframe) {
+        pos_ = keyframe_offsets_[keyframe];
+        DecodeKeyframe();
+        at = keyframe * keyframe_interval_;
+    }
+    for (; at < frame; ++at) {
+        DecodeDelta();
+    }
+    current_frame_ = at;
+    std::ranges::copy(current_, out.begin());
+}
+
+auto ObservationDecoder::decode(uint64_t frame) -> std::vector<int8_t> {
+    std::vector<int8_t> out(current_.size());
+    decode(frame, out);
+    return out;
+}
+
+void ObservationDecoder::DecodeKeyframe() {
+    for (std::size_t i = 0; i < current_.size();) {
+        const uint64_t run = ReadVarint();
+        const auto value = static_cast<int8_t>(ReadByte());
+        if (run == 0 || run > current_.size() - i) {
+            ThrowCorrupt();
+        }
+        std::fill_n(current_.begin() + static_cast<std::ptrdiff_t>(i), run, value);
+        i += run;
+    }
+}
+
+void ObservationDecoder::DecodeDelta() {
+    const uint64_t num_runs = ReadVarint();
+    std::size_t cursor = 0;
+    for (uint64_t r = 0; r < num_runs; ++r) {
+        const uint64_t skip = ReadVarint();
+        const uint64_t count = ReadVarint();
+        if (skip > current_.size() - cursor || count > current_.size() - cursor - skip || count > data_.size() - pos_) {
+            ThrowCorrupt();
+        }
+        cursor += skip;
+        std::memcpy(current_.data() + cursor, data_.data() + pos_, count);
+        cursor += count;
+        pos_ += count;
+    }
+}
+
+auto ObservationDecoder::ReadVarint() -> uint64_t {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        const uint8_t byte = ReadByte();
+        value |= uint64_t{byte & 0x7FU} << shift;
+        if ((byte & 0x80U) == 0) {
+            return value;
+        }
+    }
+    ThrowCorrupt();
+}
+
+auto ObservationDecoder::ReadByte() -> uint8_t {
+    if (pos_ >= data_.size()) {
+        ThrowCorrupt();
+    }
+    return data_[pos_++];
+}
+
+}    // namespace boulderdash
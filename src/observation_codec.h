@@ -0,0 +1,127 @@
+#ifndef BOULDERDASH_OBSERVATION_CODEC_H_
+#define BOULDERDASH_OBSERVATION_CODEC_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace boulderdash {
+
+// Compression of episodes of categorical observations, such as get_observation_compact() or get_hidden_grid().
+// Every keyframe_interval frames a keyframe stores the whole frame run-length encoded, and the frames in between only
+// store the cells which changed since the previous frame, as runs of unchanged cells to skip and of new values.
+// An index of keyframe offsets at the end of the stream makes seeking to any keyframe O(1), so decoding any frame
+// replays at most keyframe_interval - 1 deltas.
+//
+// Stream layout, fixed width fields in host byte order, lengths and counts as LEB128 varints:
+//   header: char[4] magic "BDOC", uint32 version (1), uint32 rows, uint32 cols, uint32 keyframe_interval,
+//           uint32 reserved, uint64 num_frames, uint64 index_offset
+//   keyframe: (run_length, int8 value) pairs covering all cells
+//   delta frame: num_runs, then num_runs x (skip, count, int8[count] new values)
+//   index: uint64 offset of each keyframe from the start of the stream
+
+// Streaming encoder, taking one frame at a time
+class ObservationEncoder {
+public:
+    /**
+     * @param rows Rows of each frame
+     * @param cols Columns of each frame
+     * @param keyframe_interval Frames between keyframes, larger compresses better but seeks slower
+     * @throw std::invalid_argument if a dimension is not within 1 to 32767 or the interval is zero
+     */
+    ObservationEncoder(int rows, int cols, uint32_t keyframe_interval = 64);
+
+    /**
+     * Append the next frame.
+     * @param frame rows * cols categorical values in row-major order
+     * @throw std::invalid_argument if the frame has the wrong size
+     */
+    void append(std::span<const int8_t> frame);
+
+    /**
+     * Number of frames appended so far
+     */
+    [[nodiscard]] auto num_frames() const noexcept -> uint64_t {
+        return num_frames_;
+    }
+
+    /**
+     * Size of the encoded frames so far, excluding the header and index added by finish()
+     */
+    [[nodiscard]] auto encoded_size() const noexcept -> std::size_t;
+
+    /**
+     * Complete the stream. The encoder is reset to start a new stream with the same dimensions.
+     * @return The encoded stream
+     */
+    [[nodiscard]] auto finish() -> std::vector<uint8_t>;
+
+private:
+    uint32_t rows_;
+    uint32_t cols_;
+    uint32_t keyframe_interval_;
+    uint64_t num_frames_ = 0;
+    std::vector<uint8_t> data_;    // Header space followed by the encoded frames
+    std::vector<uint64_t> keyframe_offsets_;
+    std::vector<int8_t> previous_;
+    std::vector<std::pair<std::size_t, std::size_t>> runs_;    // Changed cell runs (begin, end) of a delta frame
+};
+
+// Random access decoder of a stream written by ObservationEncoder
+class ObservationDecoder {
+public:
+    /**
+     * @param data The encoded stream
+     * @throw std::invalid_argument if the header or index is malformed, or a dimension is above 32767
+     */
+    explicit ObservationDecoder(std::vector<uint8_t> data);
+
+    [[nodiscard]] auto rows() const noexcept -> int {
+        return static_cast<int>(rows_);
+    }
+    [[nodiscard]] auto cols() const noexcept -> int {
+        return static_cast<int>(cols_);
+    }
+    [[nodiscard]] auto num_frames() const noexcept -> uint64_t {
+        return num_frames_;
+    }
+
+    /**
+     * Decode a frame. Decoding frames in increasing order within a keyframe interval continues from the last
+     * decoded frame, so reading a whole episode costs one delta per frame.
+     * @param frame Index of the frame
+     * @param out Destination of rows * cols values
+     * @throw std::invalid_argument if the frame is out of range, out has the wrong size or the stream is corrupt
+     */
+    void decode(uint64_t frame, std::span<int8_t> out);
+
+    /**
+     * Decode a frame into a new vector
+     */
+    [[nodiscard]] auto decode(uint64_t frame) -> std::vector<int8_t>;
+
+private:
+    // Decode the frame at pos_ into current_, advancing pos_
+    void DecodeKeyframe();
+    void DecodeDelta();
+    auto ReadVarint() -> uint64_t;
+    auto ReadByte() -> uint8_t;
+
+    std::vector<uint8_t> data_;
+    uint32_t rows_ = 0;
+    uint32_t cols_ = 0;
+    uint32_t keyframe_interval_ = 0;
+    uint64_t num_frames_ = 0;
+    std::vector<uint64_t> keyframe_offsets_;
+
+    // Last decoded frame, to continue sequential reads from
+    std::vector<int8_t> current_;
+    uint64_t current_frame_ = ~uint64_t{0};    // All ones when current_ holds no frame
+    std::size_t pos_ = 0;                      // Offset of the frame after current_frame_
+};
+
+}    // namespace boulderdash
+
+#endif    // BOULDERDASH_OBSERVATION_CODEC_H_
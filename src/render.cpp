@@ -0,0 +1,126 @@
+#include "render.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include "boulderdash_base.h"
+#include "definitions.h"
+#include "thread_pool.h"
+#include "trace.h"
+
+namespace boulderdash {
+
+// VisibleCellType to image binary data
+#include "assets_all.inc"
+
+SpriteAtlas::SpriteAtlas(int sprite_size) : sprite_size_(sprite_size) {
+    const int scale = SPRITE_WIDTH / sprite_size;
+    const auto sprite_len = static_cast<std::size_t>(sprite_size * sprite_size * SPRITE_CHANNELS);
+    data_.resize(sprite_len * kNumVisibleCellType, 0);
+    for (int el : std::views::iota(0, kNumVisibleCellType)) {
+        const std::vector<uint8_t> &src = img_asset_map.at(static_cast<VisibleCellType>(el));
+        uint8_t *dst = data_.data() + (static_cast<std::size_t>(el) * sprite_len);
+        // Box filter each scale x scale block down to a single pixel
+        for (int r : std::views::iota(0, sprite_size)) {
+            for (int c : std::views::iota(0, sprite_size)) {
+                for (int ch : std::views::iota(0, SPRITE_CHANNELS)) {
+                    int total = 0;
+                    for (int dr : std::views::iota(0, scale)) {
+                        for (int dc : std::views::iota(0, scale)) {
+                            total += src[static_cast<std::size_t>(((r * scale + dr) * SPRITE_DATA_LEN_PER_ROW) +
+                                                                  ((c * scale + dc) * SPRITE_CHANNELS) + ch)];
+                        }
+                    }
+                    dst[((r * sprite_size + c) * SPRITE_CHANNELS) + ch] =
+                        static_cast<uint8_t>(total / (scale * scale));
+                }
+            }
+        }
+    }
+}
+
+auto SpriteAtlas::get(int sprite_size) -> const SpriteAtlas & {
+    if (!is_valid_sprite_size(sprite_size)) {
+        throw std::invalid_argument(
+            std::format("Invalid sprite size {:d}, must evenly divide {:d}", sprite_size, SPRITE_WIDTH));
+    }
+    static std::mutex mutex;
+    static std::unordered_map<int, std::unique_ptr<SpriteAtlas>> atlases;
+    const std::lock_guard<std::mutex> lock(mutex);
+    auto &atlas = atlases[sprite_size];
+    if (!atlas) {
+        atlas.reset(new SpriteAtlas(sprite_size));
+    }
+    return *atlas;
+}
+
+auto SpriteAtlas::sprite(VisibleCellType element) const noexcept -> const uint8_t * {
+    return data_.data() + (static_cast<std::size_t>(element) * sprite_size_ * sprite_size_ * SPRITE_CHANNELS);
+}
+
+void render_observation(std::span<const int8_t> observation, int rows, int cols, const SpriteAtlas &atlas,
+                        uint8_t *out) noexcept {
+    const TraceSpan span(TracePhase::kRender);
+    const std::size_t sprite_row_len = static_cast<std::size_t>(atlas.sprite_size()) * SPRITE_CHANNELS;
+    const std::size_t img_row_len = sprite_row_len * static_cast<std::size_t>(cols);
+    for (int h : std::views::iota(0, rows)) {
+        for (int w : std::views::iota(0, cols)) {
+            const auto el = static_cast<VisibleCellType>(observation[static_cast<std::size_t>(h * cols + w)]);
+            const uint8_t *data = atlas.sprite(el);
+            uint8_t *img_top_left = out + (static_cast<std::size_t>(h * atlas.sprite_size()) * img_row_len) +
+                                    (static_cast<std::size_t>(w) * sprite_row_len);
+            for (int r : std::views::iota(0, atlas.sprite_size())) {
+                std::copy_n(data + (r * sprite_row_len), sprite_row_len, img_top_left + (r * img_row_len));
+            }
+        }
+    }
+}
+
+auto batch_image_shape(std::size_t num_states, const BoulderDashGameState &state, int sprite_size)
+    -> std::array<int, 4> {
+    const auto obs_shape = state.observation_shape();
+    return {static_cast<int>(num_states), obs_shape[1] * sprite_size, obs_shape[2] * sprite_size, SPRITE_CHANNELS};
+}
+
+void render_batch(std::span<const BoulderDashGameState *const> states, uint8_t *out, int sprite_size,
+                  int num_threads) {
+    if (states.empty()) {
+        return;
+    }
+    const SpriteAtlas &atlas = SpriteAtlas::get(sprite_size);
+    const auto obs_shape = states[0]->observation_shape();
+    for (const auto *state : states) {
+        if (state->observation_shape() != obs_shape) {
+            throw std::invalid_argument("All states in a batch must have the same dimensions");
+        }
+    }
+    const std::size_t image_len = static_cast<std::size_t>(obs_shape[1] * obs_shape[2]) *
+                                  static_cast<std::size_t>(sprite_size * sprite_size * SPRITE_CHANNELS);
+    ThreadPool::global().parallel_for(
+        states.size(),
+        [&](std::size_t i) {
+            render_observation(states[i]->get_observation_compact(), obs_shape[1], obs_shape[2], atlas,
+                               out + (i * image_len));
+        },
+        num_threads);
+}
+
+void render_batch(std::span<const BoulderDashGameState> states, uint8_t *out, int sprite_size, int num_threads) {
+    std::vector<const BoulderDashGameState *> state_ptrs;
+    state_ptrs.reserve(states.size());
+    for (const auto &state : states) {
+        state_ptrs.push_back(&state);
+    }
+    render_batch(state_ptrs, out, sprite_size, num_threads);
+}
+
+}    // namespace boulderdash
@@ -0,0 +1,83 @@
+#ifndef BOULDERDASH_RENDER_H_
+#define BOULDERDASH_RENDER_H_
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "boulderdash_base.h"
+#include "definitions.h"
+
+namespace boulderdash {
+
+// Sprites for every VisibleCellType at a single resolution, stored as HWC RGB bytes
+class SpriteAtlas {
+public:
+    /**
+     * Get the shared atlas for the given sprite size, building it on first use.
+     * Sizes below SPRITE_WIDTH are box-filtered down from the full resolution tiles.
+     * @param sprite_size Width/height of each sprite, must evenly divide SPRITE_WIDTH
+     * @return atlas shared by all callers
+     */
+    [[nodiscard]] static auto get(int sprite_size = SPRITE_WIDTH) -> const SpriteAtlas &;
+
+    /**
+     * Check if the given sprite size can be used to build an atlas
+     */
+    [[nodiscard]] constexpr static auto is_valid_sprite_size(int sprite_size) noexcept -> bool {
+        return sprite_size > 0 && sprite_size <= SPRITE_WIDTH && SPRITE_WIDTH % sprite_size == 0;
+    }
+
+    /**
+     * Get the sprite data for the given element, sprite_size() * sprite_size() * SPRITE_CHANNELS bytes
+     */
+    [[nodiscard]] auto sprite(VisibleCellType element) const noexcept -> const uint8_t *;
+
+    [[nodiscard]] auto sprite_size() const noexcept -> int {
+        return sprite_size_;
+    }
+
+private:
+    explicit SpriteAtlas(int sprite_size);
+
+    int sprite_size_;
+    std::vector<uint8_t> data_;
+};
+
+/**
+ * Render a compact observation (see get_observation_compact()) into an HWC image.
+ * @param observation Visible cell types in row-major order
+ * @param rows Number of rows of the observation
+ * @param cols Number of columns of the observation
+ * @param atlas Sprites to render with
+ * @param out Destination of rows * cols * sprite_size^2 * SPRITE_CHANNELS bytes
+ */
+void render_observation(std::span<const int8_t> observation, int rows, int cols, const SpriteAtlas &atlas,
+                        uint8_t *out) noexcept;
+
+/**
+ * Get the (N, H, W, C) shape of a batch rendered by render_batch.
+ * @param num_states Number of states in the batch
+ * @param state Any state of the batch, all must share its dimensions
+ * @param sprite_size Width/height of each sprite
+ */
+[[nodiscard]] auto batch_image_shape(std::size_t num_states, const BoulderDashGameState &state, int sprite_size)
+    -> std::array<int, 4>;
+
+/**
+ * Render a batch of states into a single (N, H, W, C) image tensor, in parallel across states.
+ * All states must have the same dimensions.
+ * @param states States to render
+ * @param out Destination, sized for batch_image_shape()
+ * @param sprite_size Width/height of each sprite, must evenly divide SPRITE_WIDTH
+ * @param num_threads Maximum number of threads to use, 0 to use the global pool
+ */
+void render_batch(std::span<const BoulderDashGameState *const> states, uint8_t *out, int sprite_size = SPRITE_WIDTH,
+                  int num_threads = 0);
+void render_batch(std::span<const BoulderDashGameState> states, uint8_t *out, int sprite_size = SPRITE_WIDTH,
+                  int num_threads = 0);
+
+}    // namespace boulderdash
+
+#endif    // BOULDERDASH_RENDER_H_
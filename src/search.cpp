@@ -0,0 +1,523 @@
+#include "search.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "boulderdash_base.h"
+#include "definitions.h"
+
+namespace boulderdash {
+
+namespace {
+constexpr std::array<char, 8> kMagic = {'B', 'D', 'S', 'E', 'A', 'R', 'C', 'H'};
+constexpr uint32_t kVersion = 1;
+constexpr const char *kMetaFile = "meta.bin";
+constexpr const char *kMetaTempFile = "meta.tmp";
+constexpr const char *kNodesFile = "nodes.bin";
+constexpr const char *kExpandedFile = "expanded.bin";
+
+// Replaced atomically once the logs it describes are durable
+struct CheckpointMeta {
+    std::array<char, 8> magic;
+    uint32_t version;
+    uint32_t kind;
+    uint64_t root_hash;
+    uint64_t num_nodes;       // Entries of the node log
+    uint64_t num_expanded;    // Expansions, also the length of the expansion log for best-first search
+    uint64_t goal;            // Id of the solution node, SearchDriver::kNoParent if none
+    std::array<uint64_t, 2> reserved;
+};
+static_assert(sizeof(CheckpointMeta) == 64);
+static_assert(sizeof(SearchDriver::Node) == 32);
+
+[[noreturn]] void throw_errno(const std::string &what, const std::filesystem::path &path) {
+    throw std::runtime_error(std::format("{:s} {:s}: {:s}", what, path.string(), std::strerror(errno)));
+}
+
+// Owning file descriptor
+class File {
+public:
+    File(const std::filesystem::path &path, int flags) : path_(path), fd_(::open(path.c_str(), flags, 0644)) {
+        if (fd_ < 0) {
+            throw_errno("Unable to open", path);
+        }
+    }
+    File(const File &) = delete;
+    File(File &&) = delete;
+    auto operator=(const File &) -> File & = delete;
+    auto operator=(File &&) -> File & = delete;
+    ~File() {
+        ::close(fd_);
+    }
+
+    void write_at(const void *data, std::size_t size, uint64_t offset) const {
+        const auto *bytes = static_cast<const char *>(data);
+        while (size > 0) {
+            const ssize_t written = ::pwrite(fd_, bytes, size, static_cast<off_t>(offset));
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw_errno("Unable to write", path_);
+            }
+            bytes += written;    // NOLINT(*-pointer-arithmetic)
+            size -= static_cast<std::size_t>(written);
+            offset += static_cast<uint64_t>(written);
+        }
+    }
+
+    void sync() const {
+        if (::fsync(fd_) != 0) {
+            throw_errno("Unable to sync", path_);
+        }
+    }
+
+    [[nodiscard]] auto size() const -> std::size_t {
+        struct stat info {};
+        if (::fstat(fd_, &info) != 0) {
+            throw_errno("Unable to stat", path_);
+        }
+        return static_cast<std::size_t>(info.st_size);
+    }
+
+    [[nodiscard]] auto fd() const noexcept -> int {
+        return fd_;
+    }
+
+private:
+    std::filesystem::path path_;
+    int fd_;
+};
+
+// Read-only mapping of the first count entries of a log file
+template <typename T>
+class MappedLog {
+public:
+    MappedLog(const std::filesystem::path &path, uint64_t count) : size_(count * sizeof(T)) {
+        if (count == 0) {
+            return;
+        }
+        const File file(path, O_RDONLY);
+        if (file.size() < size_) {
+            throw std::invalid_argument(std::format("Checkpoint file {:s} is truncated", path.string()));
+        }
+        data_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file.fd(), 0);
+        if (data_ == MAP_FAILED) {    // NOLINT(*-cstyle-cast)
+            throw_errno("Unable to map", path);
+        }
+        ::madvise(data_, size_, MADV_SEQUENTIAL);
+    }
+    MappedLog(const MappedLog &) = delete;
+    MappedLog(MappedLog &&) = delete;
+    auto operator=(const MappedLog &) -> MappedLog & = delete;
+    auto operator=(MappedLog &&) -> MappedLog & = delete;
+    ~MappedLog() {
+        if (data_ != nullptr) {
+            ::munmap(data_, size_);
+        }
+    }
+
+    [[nodiscard]] auto entries() const noexcept -> std::span<const T> {
+        return {static_cast<const T *>(data_), size_ / sizeof(T)};
+    }
+
+private:
+    void *data_ = nullptr;
+    std::size_t size_;
+};
+
+// Append the entries [from, to) of a chunked log to its file
+template <typename T>
+void append_entries(const std::filesystem::path &path, const std::vector<const T *> &chunks, uint64_t from,
+                    uint64_t to, std::size_t chunk_shift) {
+    if (from == to) {
+        return;
+    }
+    const File file(path, O_WRONLY | O_CREAT);
+    const uint64_t chunk_size = uint64_t{1} << chunk_shift;
+    for (uint64_t begin = from; begin < to;) {
+        const uint64_t end = std::min(to, ((begin >> chunk_shift) + 1) << chunk_shift);
+        const T *chunk = chunks[begin >> chunk_shift];
+        file.write_at(chunk + (begin & (chunk_size - 1)), (end - begin) * sizeof(T),    // NOLINT(*-pointer-arithmetic)
+                      begin * sizeof(T));
+        begin = end;
+    }
+    file.sync();
+}
+}    // namespace
+
+template <typename T>
+void SearchDriver::ChunkedLog<T>::push_back(const T &value) {
+    if ((size_ & (kChunkSize - 1)) == 0) {
+        chunks_.push_back(std::make_unique_for_overwrite<T[]>(kChunkSize));    // NOLINT(*-avoid-c-arrays)
+    }
+    chunks_.back()[size_ & (kChunkSize - 1)] = value;
+    ++size_;
+}
+
+template <typename T>
+auto SearchDriver::ChunkedLog<T>::chunk_pointers() const -> std::vector<const T *> {
+    std::vector<const T *> pointers;
+    pointers.reserve(chunks_.size());
+    for (const auto &chunk : chunks_) {
+        pointers.push_back(chunk.get());
+    }
+    return pointers;
+}
+
+// Everything the writer thread needs, captured on the search thread
+struct SearchDriver::Snapshot {
+    CheckpointMeta meta;
+    std::vector<const Node *> node_chunks;
+    std::vector<const uint64_t *> expanded_chunks;
+    uint64_t expanded_log_size = 0;
+};
+
+SearchDriver::SearchDriver(const BoulderDashGameState &root, Kind kind, SearchOptions options)
+    : root_(root), kind_(kind), options_(std::move(options)) {
+    if (!options_.checkpoint_dir.empty()) {
+        std::filesystem::create_directories(options_.checkpoint_dir);
+        Load();
+    }
+}
+
+SearchDriver::~SearchDriver() {
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+}
+
+auto SearchDriver::GetNode(uint64_t id) const noexcept -> const Node & {
+    return nodes_[id];
+}
+
+auto SearchDriver::AddNode(const BoulderDashGameState &state, uint64_t parent, Action action, int64_t priority)
+    -> uint64_t {
+    const uint64_t hash = state.get_hash();
+    if (!visited_.insert(hash).second) {
+        return kNoParent;
+    }
+    nodes_.push_back({
+        .hash = hash,
+        .parent = parent,
+        .priority = priority,
+        .cost = parent == kNoParent ? 0 : GetNode(parent).cost + 1,
+        .action = static_cast<uint8_t>(action),
+        .padding = {},
+    });
+    return num_nodes_++;
+}
+
+void SearchDriver::MarkExpanded(uint64_t id) {
+    ++num_expanded_;
+    if (kind_ == Kind::kBestFirst) {
+        expanded_log_.push_back(id);
+    }
+    if (!options_.checkpoint_dir.empty() && options_.checkpoint_interval > 0 &&
+        num_expanded_ - last_checkpoint_ >= options_.checkpoint_interval) {
+        checkpoint();
+    }
+}
+
+void SearchDriver::MarkSolved(uint64_t id) {
+    goal_ = id;
+    if (!options_.checkpoint_dir.empty()) {
+        checkpoint();
+    }
+}
+
+auto SearchDriver::Result(bool exhausted) const -> SearchResult {
+    SearchResult result{
+        .solved = goal_ != kNoParent,
+        .exhausted = exhausted,
+        .solution = {},
+        .expanded = num_expanded_,
+        .generated = num_nodes_,
+    };
+    for (uint64_t id = goal_; id != kNoParent && GetNode(id).parent != kNoParent; id = GetNode(id).parent) {
+        result.solution.push_back(static_cast<Action>(GetNode(id).action));
+    }
+    std::ranges::reverse(result.solution);
+    return result;
+}
+
+void SearchDriver::checkpoint() {
+    if (options_.checkpoint_dir.empty()) {
+        return;
+    }
+    wait_for_checkpoint();
+    // Only the log lengths and chunk addresses are captured here, entries are copied out by the writer thread
+    const uint64_t expanded_log_size = kind_ == Kind::kBestFirst ? num_expanded_ : 0;
+    Snapshot snapshot{
+        .meta =
+            {
+                .magic = kMagic,
+                .version = kVersion,
+                .kind = static_cast<uint32_t>(kind_),
+                .root_hash = root_.get_hash(),
+                .num_nodes = num_nodes_,
+                .num_expanded = num_expanded_,
+                .goal = goal_,
+                .reserved = {},
+            },
+        .node_chunks = nodes_.chunk_pointers(),
+        .expanded_chunks = expanded_log_.chunk_pointers(),
+        .expanded_log_size = expanded_log_size,
+    };
+    last_checkpoint_ = num_expanded_;
+    writer_ = std::thread([this, snapshot = std::move(snapshot)]() {
+        try {
+            WriteSnapshot(snapshot);
+        } catch (...) {
+            writer_error_ = std::current_exception();
+        }
+    });
+}
+
+void SearchDriver::wait_for_checkpoint() {
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+    if (writer_error_) {
+        std::exception_ptr error = std::exchange(writer_error_, nullptr);
+        std::rethrow_exception(error);
+    }
+}
+
+void SearchDriver::WriteSnapshot(const Snapshot &snapshot) {
+    const std::filesystem::path dir(options_.checkpoint_dir);
+    append_entries(dir / kNodesFile, snapshot.node_chunks, nodes_written_, snapshot.meta.num_nodes, kChunkShift);
+    nodes_written_ = snapshot.meta.num_nodes;
+    append_entries(dir / kExpandedFile, snapshot.expanded_chunks, expanded_written_, snapshot.expanded_log_size,
+                   kChunkShift);
+    expanded_written_ = snapshot.expanded_log_size;
+    {
+        const File meta(dir / kMetaTempFile, O_WRONLY | O_CREAT | O_TRUNC);
+        meta.write_at(&snapshot.meta, sizeof(CheckpointMeta), 0);
+        meta.sync();
+    }
+    std::filesystem::rename(dir / kMetaTempFile, dir / kMetaFile);
+}
+
+void SearchDriver::Load() {
+    const std::filesystem::path dir(options_.checkpoint_dir);
+    if (!std::filesystem::exists(dir / kMetaFile)) {
+        return;
+    }
+    CheckpointMeta meta{};
+    {
+        const File file(dir / kMetaFile, O_RDONLY);
+        if (file.size() != sizeof(CheckpointMeta) ||
+            ::pread(file.fd(), &meta, sizeof(CheckpointMeta), 0) != static_cast<ssize_t>(sizeof(CheckpointMeta))) {
+            throw std::invalid_argument(std::format("Checkpoint {:s} is corrupt", dir.string()));
+        }
+    }
+    if (meta.magic != kMagic || meta.version != kVersion) {
+        throw std::invalid_argument(std::format("{:s} does not hold a search checkpoint", dir.string()));
+    }
+    if (meta.kind != static_cast<uint32_t>(kind_) || meta.root_hash != root_.get_hash()) {
+        throw std::invalid_argument(
+            std::format("Checkpoint {:s} belongs to a different search or root state", dir.string()));
+    }
+
+    const MappedLog<Node> nodes(dir / kNodesFile, meta.num_nodes);
+    visited_.reserve(meta.num_nodes);
+    for (const Node &node : nodes.entries()) {
+        nodes_.push_back(node);
+        visited_.insert(node.hash);
+    }
+    if (kind_ == Kind::kBestFirst) {
+        const MappedLog<uint64_t> expanded(dir / kExpandedFile, meta.num_expanded);
+        for (const uint64_t id : expanded.entries()) {
+            expanded_log_.push_back(id);
+        }
+        expanded_written_ = meta.num_expanded;
+    }
+    num_nodes_ = meta.num_nodes;
+    num_expanded_ = meta.num_expanded;
+    nodes_written_ = meta.num_nodes;
+    last_checkpoint_ = meta.num_expanded;
+    goal_ = meta.goal;
+    resumed_ = true;
+}
+
+void SearchDriver::ReplayOpen(const std::function<void(uint64_t, BoulderDashGameState &&)> &on_open) {
+    if (!resumed_ || goal_ != kNoParent || num_nodes_ == 0) {
+        return;
+    }
+    // Open nodes are those not yet expanded. Breadth-first search expands in id order.
+    std::vector<bool> open(num_nodes_, true);
+    if (kind_ == Kind::kBestFirst) {
+        for (uint64_t i = 0; i < num_expanded_; ++i) {
+            open[expanded_log_[i]] = false;
+        }
+    } else {
+        std::fill(open.begin(), open.begin() + static_cast<std::ptrdiff_t>(num_expanded_), false);
+    }
+
+    // Mark the open nodes and their ancestors, then link the marked nodes to their parents
+    std::vector<bool> needed(num_nodes_, false);
+    for (uint64_t id = 0; id < num_nodes_; ++id) {
+        if (!open[id]) {
+            continue;
+        }
+        for (uint64_t node = id; node != kNoParent && !needed[node]; node = GetNode(node).parent) {
+            needed[node] = true;
+        }
+    }
+    std::vector<uint64_t> child_begin(num_nodes_ + 1, 0);
+    for (uint64_t id = 1; id < num_nodes_; ++id) {
+        child_begin[GetNode(id).parent + 1] += needed[id] ? 1 : 0;
+    }
+    std::partial_sum(child_begin.begin(), child_begin.end(), child_begin.begin());
+    std::vector<uint64_t> children(child_begin.back());
+    std::vector<uint64_t> next_child(child_begin.begin(), child_begin.end() - 1);
+    for (uint64_t id = 1; id < num_nodes_; ++id) {
+        if (needed[id]) {
+            children[next_child[GetNode(id).parent]++] = id;
+        }
+    }
+
+    // Replay the actions down the tree of marked nodes, checking each state against its stored hash
+    std::vector<std::pair<uint64_t, BoulderDashGameState>> open_states;
+    std::vector<std::pair<uint64_t, BoulderDashGameState>> stack;
+    stack.emplace_back(0, root_);
+    while (!stack.empty()) {
+        auto [id, state] = std::move(stack.back());
+        stack.pop_back();
+        if (state.get_hash() != GetNode(id).hash) {
+            throw std::runtime_error(std::format("Checkpoint {:s} does not replay to the same states at node {:d}",
+                                                 options_.checkpoint_dir, id));
+        }
+        for (uint64_t i = child_begin[id]; i < child_begin[id + 1]; ++i) {
+            BoulderDashGameState child = state;
+            child.apply_action(static_cast<Action>(GetNode(children[i]).action));
+            stack.emplace_back(children[i], std::move(child));
+        }
+        if (open[id]) {
+            open_states.emplace_back(id, std::move(state));
+        }
+    }
+    std::ranges::sort(open_states, {}, [](const auto &entry) { return entry.first; });
+    for (auto &[id, state] : open_states) {
+        on_open(id, std::move(state));
+    }
+}
+
+BreadthFirstSearch::BreadthFirstSearch(const BoulderDashGameState &root, SearchOptions options)
+    : SearchDriver(root, Kind::kBreadthFirst, std::move(options)) {
+    if (resumed()) {
+        ReplayOpen([this](uint64_t, BoulderDashGameState &&state) { open_.push_back(std::move(state)); });
+        return;
+    }
+    const uint64_t id = AddNode(root_, kNoParent, Action::kUp, 0);
+    if (root_.is_solution()) {
+        MarkSolved(id);
+    } else if (!root_.is_terminal()) {
+        open_.push_back(root_);
+    }
+}
+
+auto BreadthFirstSearch::run(uint64_t max_expansions) -> SearchResult {
+    const uint64_t stop = max_expansions == 0 ? std::numeric_limits<uint64_t>::max() : expanded() + max_expansions;
+    while (goal_ == kNoParent && !open_.empty() && expanded() < stop) {
+        const uint64_t id = expanded();
+        const BoulderDashGameState state = std::move(open_.front());
+        open_.pop_front();
+        const int64_t cost = GetNode(id).cost + 1;
+        for (const auto action : ALL_ACTIONS) {
+            BoulderDashGameState child = state;
+            child.apply_action(action);
+            if (child.is_terminal() && !child.is_solution()) {
+                continue;
+            }
+            const uint64_t child_id = AddNode(child, id, action, cost);
+            if (child_id == kNoParent) {
+                continue;
+            }
+            if (child.is_solution()) {
+                goal_ = child_id;
+                break;
+            }
+            open_.push_back(std::move(child));
+        }
+        MarkExpanded(id);
+        if (goal_ != kNoParent) {
+            MarkSolved(goal_);
+        }
+    }
+    return Result(goal_ == kNoParent && open_.empty());
+}
+
+BestFirstSearch::BestFirstSearch(const BoulderDashGameState &root, Heuristic heuristic, int64_t cost_weight,
+                                 SearchOptions options)
+    : SearchDriver(root, Kind::kBestFirst, std::move(options)),
+      heuristic_(std::move(heuristic)),
+      cost_weight_(cost_weight) {
+    if (resumed()) {
+        ReplayOpen([this](uint64_t id, BoulderDashGameState &&state) { Push(id, std::move(state)); });
+        return;
+    }
+    const uint64_t id = AddNode(root_, kNoParent, Action::kUp, heuristic_(root_));
+    if (root_.is_solution() || !root_.is_terminal()) {
+        Push(id, BoulderDashGameState(root_));
+    }
+}
+
+void BestFirstSearch::Push(uint64_t id, BoulderDashGameState &&state) {
+    open_.push_back({GetNode(id).priority, id, std::make_unique<BoulderDashGameState>(std::move(state))});
+    std::ranges::push_heap(open_, std::greater<>{}, [](const OpenEntry &entry) {
+        return std::pair(entry.priority, entry.id);
+    });
+}
+
+auto BestFirstSearch::run(uint64_t max_expansions) -> SearchResult {
+    const auto key = [](const OpenEntry &entry) { return std::pair(entry.priority, entry.id); };
+    const uint64_t stop = max_expansions == 0 ? std::numeric_limits<uint64_t>::max() : expanded() + max_expansions;
+    while (goal_ == kNoParent && !open_.empty() && expanded() < stop) {
+        std::ranges::pop_heap(open_, std::greater<>{}, key);
+        const OpenEntry entry = std::move(open_.back());
+        open_.pop_back();
+        if (entry.state->is_solution()) {
+            MarkSolved(entry.id);
+            break;
+        }
+        const int64_t cost = GetNode(entry.id).cost + 1;
+        for (const auto action : ALL_ACTIONS) {
+            BoulderDashGameState child = *entry.state;
+            child.apply_action(action);
+            if (child.is_terminal() && !child.is_solution()) {
+                continue;
+            }
+            const int64_t priority = (cost_weight_ * cost) + heuristic_(child);
+            const uint64_t child_id = AddNode(child, entry.id, action, priority);
+            if (child_id != kNoParent) {
+                Push(child_id, std::move(child));
+            }
+        }
+        MarkExpanded(entry.id);
+    }
+    return Result(goal_ == kNoParent && open_.empty());
+}
+
+}    // namespace boulderdash
@@ -0,0 +1,220 @@
+#ifndef BOULDERDASH_SEARCH_H_
+#define BOULDERDASH_SEARCH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "boulderdash_base.h"
+#include "definitions.h"
+
+namespace boulderdash {
+
+struct SearchOptions {
+    std::string checkpoint_dir;                // Directory holding the checkpoint, empty to disable checkpoints
+    uint64_t checkpoint_interval = 100000;    // Expansions between automatic checkpoints, 0 for only on request
+};
+
+struct SearchResult {
+    bool solved = false;
+    bool exhausted = false;          // Every reachable state was expanded without finding a solution
+    std::vector<Action> solution;    // Actions from the root to the solution, if solved
+    uint64_t expanded = 0;
+    uint64_t generated = 0;          // Distinct states added to the search, including the root
+};
+
+// Shared part of the search drivers: node store, visited table and checkpointing.
+// Every distinct state gets a compact node (hash, parent, action, cost and priority) in an append-only store, and
+// the visited table holds the hashes of all nodes. States themselves are only held for the open list.
+//
+// Checkpoints are written to a directory as append-only node and expansion logs plus a small metadata file which
+// is replaced atomically. Since both logs only grow, taking a checkpoint just records their current lengths; the
+// new entries are written by a background thread while the search carries on. Resuming maps the logs, rebuilds
+// the visited table from the node hashes and replays the actions leading to each open node, so the search then
+// continues exactly as if it had never stopped.
+class SearchDriver {
+public:
+    SearchDriver(const SearchDriver &) = delete;
+    SearchDriver(SearchDriver &&) = delete;
+    auto operator=(const SearchDriver &) -> SearchDriver & = delete;
+    auto operator=(SearchDriver &&) -> SearchDriver & = delete;
+
+    /**
+     * Start writing a checkpoint of the current search state, returning once its contents are captured.
+     * Waits for the previous checkpoint to finish writing first.
+     * @throw std::runtime_error if writing the previous checkpoint failed
+     */
+    void checkpoint();
+
+    /**
+     * Block until the last checkpoint is durably written.
+     * @throw std::runtime_error if writing it failed
+     */
+    void wait_for_checkpoint();
+
+    /**
+     * Check if the search continued from a checkpoint rather than starting from the root
+     */
+    [[nodiscard]] auto resumed() const noexcept -> bool {
+        return resumed_;
+    }
+    [[nodiscard]] auto expanded() const noexcept -> uint64_t {
+        return num_expanded_;
+    }
+    [[nodiscard]] auto generated() const noexcept -> uint64_t {
+        return num_nodes_;
+    }
+
+    // Compact search node, as stored in the checkpoint
+    struct Node {
+        uint64_t hash;
+        uint64_t parent;      // kNoParent for the root
+        int64_t priority;     // Open list order, lower first
+        uint32_t cost;        // Number of actions from the root
+        uint8_t action;       // Action taken from the parent
+        uint8_t padding[3];   // NOLINT(*-avoid-c-arrays)
+    };
+    static constexpr uint64_t kNoParent = ~uint64_t{0};
+
+protected:
+    enum class Kind : uint32_t {
+        kBreadthFirst = 1,
+        kBestFirst = 2,
+    };
+
+    /**
+     * @param root The state to search from
+     * @param kind Search kind, checkpoints of a different kind are rejected
+     * @param options Checkpoint options, loading the checkpoint in options.checkpoint_dir if there is one
+     * @throw std::invalid_argument if the checkpoint belongs to a different root or search kind
+     */
+    SearchDriver(const BoulderDashGameState &root, Kind kind, SearchOptions options);
+    ~SearchDriver();
+
+    /**
+     * Add a node for state if it was not visited before.
+     * @return The new node id, or kNoParent if the state was already visited
+     */
+    auto AddNode(const BoulderDashGameState &state, uint64_t parent, Action action, int64_t priority) -> uint64_t;
+
+    // Record an expansion, and checkpoint if the interval has passed
+    void MarkExpanded(uint64_t id);
+    void MarkSolved(uint64_t id);
+    [[nodiscard]] auto Result(bool exhausted) const -> SearchResult;
+    [[nodiscard]] auto GetNode(uint64_t id) const noexcept -> const Node &;
+
+    // Rebuild the states of nodes which were added but not expanded when the checkpoint was taken, calling
+    // on_open(id, state) in increasing id order. Does nothing unless the search was resumed.
+    void ReplayOpen(const std::function<void(uint64_t, BoulderDashGameState &&)> &on_open);
+
+    BoulderDashGameState root_;
+    uint64_t goal_ = kNoParent;
+
+private:
+    static constexpr std::size_t kChunkShift = 16;
+    static constexpr std::size_t kChunkSize = std::size_t{1} << kChunkShift;
+
+    // Append-only array in fixed size chunks, so entries never move and a background thread can read entries
+    // below a recorded size while new ones are appended
+    template <typename T>
+    class ChunkedLog {
+    public:
+        void push_back(const T &value);
+        [[nodiscard]] auto operator[](uint64_t index) const noexcept -> const T & {
+            return chunks_[index >> kChunkShift][index & (kChunkSize - 1)];
+        }
+        [[nodiscard]] auto chunk_pointers() const -> std::vector<const T *>;
+
+    private:
+        std::vector<std::unique_ptr<T[]>> chunks_;    // NOLINT(*-avoid-c-arrays)
+        uint64_t size_ = 0;
+    };
+
+    struct Snapshot;
+    void Load();
+    void WriteSnapshot(const Snapshot &snapshot);
+
+    Kind kind_;
+    SearchOptions options_;
+    bool resumed_ = false;
+    uint64_t num_nodes_ = 0;
+    uint64_t num_expanded_ = 0;
+    uint64_t last_checkpoint_ = 0;    // Expansions at the last checkpoint
+    ChunkedLog<Node> nodes_;
+    ChunkedLog<uint64_t> expanded_log_;    // Best-first only, breadth-first expands in id order
+    std::unordered_set<uint64_t> visited_;
+
+    // Owned by the writer thread while it runs
+    std::thread writer_;
+    std::exception_ptr writer_error_;
+    uint64_t nodes_written_ = 0;
+    uint64_t expanded_written_ = 0;
+};
+
+// Breadth-first search, returning a shortest solution.
+// States are checked for being a solution when generated, and dead states are pruned.
+class BreadthFirstSearch : public SearchDriver {
+public:
+    /**
+     * @param root The state to search from
+     * @param options Checkpoint options, resuming from an existing checkpoint of the same root
+     */
+    explicit BreadthFirstSearch(const BoulderDashGameState &root, SearchOptions options = {});
+
+    /**
+     * Continue the search.
+     * @param max_expansions Number of expansions after which to stop, 0 for no limit
+     * @return The search outcome so far
+     */
+    auto run(uint64_t max_expansions = 0) -> SearchResult;
+
+private:
+    std::deque<BoulderDashGameState> open_;    // States of nodes [expanded(), generated())
+};
+
+// Best-first search ordered by cost_weight * cost + heuristic(state), ties broken by insertion order.
+// A cost weight of 1 with an admissible heuristic gives A*, 0 gives greedy best-first search.
+// States are checked for being a solution when expanded, and dead states are pruned.
+class BestFirstSearch : public SearchDriver {
+public:
+    using Heuristic = std::function<int64_t(const BoulderDashGameState &)>;
+
+    /**
+     * @param root The state to search from
+     * @param heuristic Estimate of the cost to a solution
+     * @param cost_weight Weight of the path cost in the priority
+     * @param options Checkpoint options, resuming from an existing checkpoint of the same root
+     */
+    BestFirstSearch(const BoulderDashGameState &root, Heuristic heuristic, int64_t cost_weight = 1,
+                    SearchOptions options = {});
+
+    /**
+     * Continue the search.
+     * @param max_expansions Number of expansions after which to stop, 0 for no limit
+     * @return The search outcome so far
+     */
+    auto run(uint64_t max_expansions = 0) -> SearchResult;
+
+private:
+    struct OpenEntry {
+        int64_t priority;
+        uint64_t id;
+        std::unique_ptr<BoulderDashGameState> state;
+    };
+    void Push(uint64_t id, BoulderDashGameState &&state);
+
+    Heuristic heuristic_;
+    int64_t cost_weight_;
+    std::vector<OpenEntry> open_;    // Min-heap on (priority, id)
+};
+
+}    // namespace boulderdash
+
+#endif    // BOULDERDASH_SEARCH_H_
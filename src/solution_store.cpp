@@ -0,0 +1,354 @@
+#include "solution_store.h"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "definitions.h"
+
+namespace boulderdash {
+
+// File layout: Header, then num_slots Slots, then the record log.
+// All offsets are from the start of the file, and fields shared with readers are accessed atomically.
+struct SolutionStore::Header {
+    std::array<char, 8> magic;
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t capacity;     // Maximum number of distinct hashes
+    uint64_t num_slots;    // Power of two, at least twice the capacity
+    uint64_t data_end;     // End of the record log
+    uint64_t count;        // Number of occupied slots
+    std::array<uint64_t, 2> padding;
+};
+
+struct SolutionStore::Slot {
+    uint64_t hash;
+    uint64_t record;    // Offset of the record, 0 while the slot is empty
+};
+
+// Followed by solver_size bytes of solver name, then the actions packed 4 to a byte (first action in the low bits)
+struct SolutionStore::Record {
+    uint64_t hash;
+    uint32_t length;
+    uint16_t solver_size;
+    uint16_t flags;
+    uint64_t expansions;
+    double seconds;
+};
+
+namespace {
+constexpr std::array<char, 8> kMagic = {'B', 'D', 'S', 'O', 'L', 'V', 'E', 'S'};
+constexpr uint32_t kVersion = 1;
+constexpr uint16_t kFlagOptimal = 1;
+constexpr std::size_t kActionsPerByte = 4;
+constexpr std::size_t kInitialLogSize = 1 << 20;
+constexpr std::size_t kRecordAlignment = 8;
+constexpr std::size_t kRecordHeaderSize = 32;
+
+static_assert(kNumActions <= 4, "Actions are packed at 2 bits each");
+
+auto atomic_load(uint64_t &field) noexcept -> uint64_t {
+    return std::atomic_ref<uint64_t>(field).load(std::memory_order_acquire);
+}
+
+void atomic_store(uint64_t &field, uint64_t value) noexcept {
+    std::atomic_ref<uint64_t>(field).store(value, std::memory_order_release);
+}
+
+// splitmix64 finalizer, spreads the hash over the table
+constexpr auto mix(uint64_t x) noexcept -> uint64_t {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+auto packed_size(std::size_t length) noexcept -> std::size_t {
+    return (length + kActionsPerByte - 1) / kActionsPerByte;
+}
+
+auto record_size(std::size_t solver_size, std::size_t length) noexcept -> std::size_t {
+    const std::size_t size = kRecordHeaderSize + solver_size + packed_size(length);
+    return (size + kRecordAlignment - 1) / kRecordAlignment * kRecordAlignment;
+}
+
+[[noreturn]] void throw_errno(const std::string &what, const std::string &path) {
+    throw std::runtime_error(std::format("{:s} {:s}: {:s}", what, path, std::strerror(errno)));
+}
+}    // namespace
+
+SolutionStore::SolutionStore(const std::string &path, Mode mode, std::size_t capacity)
+    : path_(path), mode_(mode) {
+    static_assert(sizeof(Header) == 64 && sizeof(Slot) == 16 && sizeof(Record) == kRecordHeaderSize);
+    const bool writable = mode == Mode::kWrite;
+    fd_ = writable ? ::open(path.c_str(), O_RDWR | O_CREAT, 0644) : ::open(path.c_str(), O_RDONLY);    // NOLINT
+    if (fd_ < 0) {
+        throw std::invalid_argument(
+            std::format("Unable to open solution store {:s}: {:s}", path, std::strerror(errno)));
+    }
+    try {
+        if (writable && ::flock(fd_, LOCK_EX | LOCK_NB) != 0) {
+            throw std::invalid_argument(std::format("Solution store {:s} is already open for writing", path));
+        }
+        std::size_t file_size = FileSize();
+        if (writable && file_size == 0) {
+            if (capacity == 0 || capacity > std::numeric_limits<uint32_t>::max()) {
+                throw std::invalid_argument(std::format("Invalid solution store capacity {:d}", capacity));
+            }
+            const std::size_t num_slots = std::bit_ceil(capacity * 2);
+            file_size = sizeof(Header) + (num_slots * sizeof(Slot)) + kInitialLogSize;
+            if (::ftruncate(fd_, static_cast<off_t>(file_size)) != 0) {
+                throw_errno("Unable to size solution store", path);
+            }
+            Map(file_size);
+            Header &header = GetHeader();
+            header.version = kVersion;
+            header.capacity = capacity;
+            header.num_slots = num_slots;
+            header.data_end = sizeof(Header) + (num_slots * sizeof(Slot));
+            header.count = 0;
+            // Readers only accept the file once the magic is in place
+            std::atomic_thread_fence(std::memory_order_release);
+            header.magic = kMagic;
+        } else {
+            if (file_size < sizeof(Header)) {
+                throw std::invalid_argument(std::format("{:s} is not a solution store", path));
+            }
+            Map(file_size);
+        }
+
+        const Header &header = GetHeader();
+        if (header.magic != kMagic || header.version != kVersion) {
+            throw std::invalid_argument(
+                std::format("{:s} is not a solution store, or was written by an unsupported version", path));
+        }
+        capacity_ = header.capacity;
+        num_slots_ = header.num_slots;
+        if (!std::has_single_bit(num_slots_) || file_size < sizeof(Header) + (num_slots_ * sizeof(Slot))) {
+            throw std::invalid_argument(std::format("Solution store {:s} is truncated or corrupt", path));
+        }
+    } catch (...) {
+        Unmap();
+        ::close(fd_);
+        throw;
+    }
+}
+
+SolutionStore::~SolutionStore() {
+    if (mode_ == Mode::kWrite && base_ != nullptr) {
+        ::msync(base_, mapped_, MS_SYNC);
+    }
+    Unmap();
+    ::close(fd_);    // Also releases the writer lock
+}
+
+auto SolutionStore::GetHeader() const noexcept -> Header & {
+    return *reinterpret_cast<Header *>(base_);    // NOLINT(*-reinterpret-cast)
+}
+
+auto SolutionStore::GetSlots() const noexcept -> Slot * {
+    return reinterpret_cast<Slot *>(base_ + sizeof(Header));    // NOLINT(*-reinterpret-cast, *-pointer-arithmetic)
+}
+
+auto SolutionStore::FindSlot(uint64_t hash) const noexcept -> Slot * {
+    // Linear probing, the table is at most half full so probes stay short
+    Slot *slots = GetSlots();
+    const std::size_t mask = num_slots_ - 1;
+    for (std::size_t i = mix(hash) & mask, probes = 0; probes < num_slots_; i = (i + 1) & mask, ++probes) {
+        Slot &slot = slots[i];    // NOLINT(*-pointer-arithmetic)
+        if (atomic_load(slot.record) == 0 || slot.hash == hash) {
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+auto SolutionStore::FindRecord(uint64_t hash) const noexcept -> std::size_t {
+    Slot *slot = FindSlot(hash);
+    return slot == nullptr ? 0 : atomic_load(slot->record);
+}
+
+template <typename F>
+auto SolutionStore::WithRecord(uint64_t hash, F &&fn) const -> std::optional<std::invoke_result_t<F, const Record &>> {
+    while (true) {
+        {
+            const std::shared_lock<std::shared_mutex> lock(mutex_);
+            const std::size_t offset = FindRecord(hash);
+            if (offset == 0) {
+                return std::nullopt;
+            }
+            if (offset + sizeof(Record) <= mapped_) {
+                const auto &record = *reinterpret_cast<const Record *>(base_ + offset);    // NOLINT
+                if (offset + record_size(record.solver_size, record.length) <= mapped_) {
+                    return fn(record);
+                }
+            }
+        }
+        // The writer grew the file past our mapping since it was made
+        const std::unique_lock<std::shared_mutex> lock(mutex_);
+        const std::size_t file_size = FileSize();
+        if (file_size > mapped_) {
+            Map(file_size);
+        }
+    }
+}
+
+auto SolutionStore::put(uint64_t hash, std::span<const Action> actions, const Metadata &metadata) -> bool {
+    if (mode_ != Mode::kWrite) {
+        throw std::runtime_error(std::format("Solution store {:s} is open read-only", path_));
+    }
+    if (actions.size() > std::numeric_limits<uint32_t>::max() ||
+        metadata.solver.size() > std::numeric_limits<uint16_t>::max()) {
+        throw std::invalid_argument("Solution or solver name too long for the solution store");
+    }
+    const std::unique_lock<std::shared_mutex> lock(mutex_);
+    Slot *slot = FindSlot(hash);
+    const uint64_t existing = slot == nullptr ? 0 : slot->record;
+    if (existing != 0) {
+        const auto &record = *reinterpret_cast<const Record *>(base_ + existing);    // NOLINT
+        if (record.length <= actions.size()) {
+            return false;
+        }
+    } else if (slot == nullptr || GetHeader().count >= capacity_) {
+        throw std::runtime_error(std::format("Solution store {:s} is full ({:d} solutions)", path_, capacity_));
+    }
+
+    // Grow the file geometrically, readers remap once they meet a record past their mapping
+    const std::size_t size = record_size(metadata.solver.size(), actions.size());
+    const std::size_t offset = GetHeader().data_end;
+    if (offset + size > mapped_) {
+        const std::size_t file_size = std::max(mapped_ * 2, offset + size);
+        if (::ftruncate(fd_, static_cast<off_t>(file_size)) != 0) {
+            throw_errno("Unable to grow solution store", path_);
+        }
+        const std::size_t slot_index = static_cast<std::size_t>(slot - GetSlots());
+        Map(file_size);
+        slot = GetSlots() + slot_index;    // NOLINT(*-pointer-arithmetic)
+    }
+
+    std::byte *data = base_ + offset;    // NOLINT(*-pointer-arithmetic)
+    std::memset(data, 0, size);
+    const Record record = {
+        .hash = hash,
+        .length = static_cast<uint32_t>(actions.size()),
+        .solver_size = static_cast<uint16_t>(metadata.solver.size()),
+        .flags = metadata.optimal ? kFlagOptimal : uint16_t{0},
+        .expansions = metadata.expansions,
+        .seconds = metadata.seconds,
+    };
+    std::memcpy(data, &record, sizeof(Record));
+    std::memcpy(data + sizeof(Record), metadata.solver.data(), metadata.solver.size());    // NOLINT
+    auto *packed = reinterpret_cast<uint8_t *>(data + sizeof(Record) + metadata.solver.size());    // NOLINT
+    for (std::size_t i = 0; i < actions.size(); ++i) {
+        packed[i / kActionsPerByte] |=    // NOLINT(*-pointer-arithmetic)
+            static_cast<uint8_t>(static_cast<uint8_t>(actions[i]) << (2 * (i % kActionsPerByte)));
+    }
+
+    // Publish the record, then point the slot at it
+    Header &header = GetHeader();
+    atomic_store(header.data_end, offset + size);
+    if (existing == 0) {
+        slot->hash = hash;
+        atomic_store(slot->record, offset);
+        atomic_store(header.count, header.count + 1);
+    } else {
+        atomic_store(slot->record, offset);
+    }
+    return true;
+}
+
+auto SolutionStore::find(uint64_t hash) const -> std::optional<Solution> {
+    return WithRecord(hash, [](const Record &record) {
+        const auto *bytes = reinterpret_cast<const char *>(&record) + sizeof(Record);    // NOLINT
+        const auto *packed = reinterpret_cast<const uint8_t *>(bytes + record.solver_size);    // NOLINT
+        Solution solution;
+        solution.metadata = {
+            .solver = std::string(bytes, record.solver_size),
+            .expansions = record.expansions,
+            .seconds = record.seconds,
+            .optimal = (record.flags & kFlagOptimal) != 0,
+        };
+        solution.actions.reserve(record.length);
+        for (std::size_t i = 0; i < record.length; ++i) {
+            const auto bits = (packed[i / kActionsPerByte] >> (2 * (i % kActionsPerByte))) & 0b11;    // NOLINT
+            solution.actions.push_back(static_cast<Action>(bits));
+        }
+        return solution;
+    });
+}
+
+auto SolutionStore::solution_length(uint64_t hash) const -> std::optional<std::size_t> {
+    return WithRecord(hash, [](const Record &record) { return static_cast<std::size_t>(record.length); });
+}
+
+auto SolutionStore::contains(uint64_t hash) const -> bool {
+    const std::shared_lock<std::shared_mutex> lock(mutex_);
+    return FindRecord(hash) != 0;
+}
+
+auto SolutionStore::size() const -> std::size_t {
+    const std::shared_lock<std::shared_mutex> lock(mutex_);
+    return atomic_load(GetHeader().count);
+}
+
+auto SolutionStore::capacity() const noexcept -> std::size_t {
+    return capacity_;
+}
+
+void SolutionStore::sync() const {
+    const std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (mode_ == Mode::kWrite && ::msync(base_, mapped_, MS_SYNC) != 0) {
+        throw_errno("Unable to sync solution store", path_);
+    }
+}
+
+void SolutionStore::Map(std::size_t length) const {
+    const int protection = mode_ == Mode::kWrite ? (PROT_READ | PROT_WRITE) : PROT_READ;
+    void *addr = ::mmap(nullptr, length, protection, MAP_SHARED, fd_, 0);
+    if (addr == MAP_FAILED) {    // NOLINT(*-cstyle-cast)
+        throw_errno("Unable to map solution store", path_);
+    }
+    Unmap();
+    base_ = static_cast<std::byte *>(addr);
+    mapped_ = length;
+}
+
+void SolutionStore::Unmap() const noexcept {
+    if (base_ != nullptr) {
+        ::munmap(base_, mapped_);
+        base_ = nullptr;
+        mapped_ = 0;
+    }
+}
+
+auto SolutionStore::FileSize() const -> std::size_t {
+    struct stat info {};
+    if (::fstat(fd_, &info) != 0) {
+        throw_errno("Unable to stat solution store", path_);
+    }
+    return static_cast<std::size_t>(info.st_size);
+}
+
+}    // namespace boulderdash
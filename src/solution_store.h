@@ -0,0 +1,130 @@
+#ifndef BOULDERDASH_SOLUTION_STORE_H_
+#define BOULDERDASH_SOLUTION_STORE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "definitions.h"
+
+namespace boulderdash {
+
+// Persistent store of level solutions, keyed by the hash of the level's initial state (see get_hash()).
+// The store is a memory-mapped file holding a fixed size open addressing table followed by an append-only record
+// log, with actions packed at 2 bits each. One process at a time may open the store for writing, while any
+// number of readers (in the same or other processes) see new solutions as soon as they are published.
+// Adding a solution for a known hash only replaces the stored one if it is strictly shorter.
+class SolutionStore {
+public:
+    enum class Mode {
+        kRead,
+        kWrite,
+    };
+
+    struct Metadata {
+        std::string solver;         // Name of the solver which found the solution
+        uint64_t expansions = 0;    // Search effort, e.g. number of expanded nodes
+        double seconds = 0;         // Wall time taken by the solver
+        bool optimal = false;       // Whether the solution is known to be shortest
+    };
+
+    struct Solution {
+        std::vector<Action> actions;
+        Metadata metadata;
+    };
+
+    /**
+     * Open a solution store, creating it when opened for writing and the file does not exist.
+     * @param path Path of the store file
+     * @param mode kRead for read-only access, kWrite for the single writer
+     * @param capacity Maximum number of distinct hashes, only used when creating the store
+     * @throw std::invalid_argument if the file is not a solution store or cannot be opened,
+     *        or another writer holds the store
+     */
+    SolutionStore(const std::string &path, Mode mode, std::size_t capacity = DEFAULT_CAPACITY);
+    ~SolutionStore();
+
+    SolutionStore(const SolutionStore &) = delete;
+    SolutionStore(SolutionStore &&) = delete;
+    auto operator=(const SolutionStore &) -> SolutionStore & = delete;
+    auto operator=(SolutionStore &&) -> SolutionStore & = delete;
+
+    /**
+     * Add a solution, keeping the stored one if it is no longer than the new one.
+     * @param hash Hash of the level's initial state
+     * @param actions The solution
+     * @param metadata Information about the solver which found it
+     * @return True if the solution was stored
+     * @throw std::runtime_error if the store was opened read-only or is full
+     */
+    auto put(uint64_t hash, std::span<const Action> actions, const Metadata &metadata) -> bool;
+
+    /**
+     * Lookup the solution for a level.
+     * @param hash Hash of the level's initial state
+     * @return The stored solution, or std::nullopt if none
+     */
+    [[nodiscard]] auto find(uint64_t hash) const -> std::optional<Solution>;
+
+    /**
+     * Lookup only the solution length for a level, without decoding its actions.
+     * @param hash Hash of the level's initial state
+     * @return Number of actions in the stored solution, or std::nullopt if none
+     */
+    [[nodiscard]] auto solution_length(uint64_t hash) const -> std::optional<std::size_t>;
+
+    [[nodiscard]] auto contains(uint64_t hash) const -> bool;
+
+    /**
+     * Number of distinct hashes with a stored solution
+     */
+    [[nodiscard]] auto size() const -> std::size_t;
+
+    /**
+     * Maximum number of distinct hashes the store can hold
+     */
+    [[nodiscard]] auto capacity() const noexcept -> std::size_t;
+
+    /**
+     * Flush written solutions to disk. The store is always flushed when the writer is destroyed.
+     */
+    void sync() const;
+
+    static constexpr std::size_t DEFAULT_CAPACITY = 1 << 20;
+
+private:
+    struct Header;
+    struct Slot;
+    struct Record;
+
+    [[nodiscard]] auto GetHeader() const noexcept -> Header &;
+    [[nodiscard]] auto GetSlots() const noexcept -> Slot *;
+    [[nodiscard]] auto FindSlot(uint64_t hash) const noexcept -> Slot *;
+    // Offset of the record for hash, or 0 if not present. Requires the shared lock.
+    [[nodiscard]] auto FindRecord(uint64_t hash) const noexcept -> std::size_t;
+    // Run fn on the record for hash with the shared lock held, remapping first if another process grew the file
+    template <typename F>
+    auto WithRecord(uint64_t hash, F &&fn) const -> std::optional<std::invoke_result_t<F, const Record &>>;
+    // Map the first length bytes of the file, replacing the current mapping only once the new one is in place
+    void Map(std::size_t length) const;
+    void Unmap() const noexcept;
+    [[nodiscard]] auto FileSize() const -> std::size_t;
+
+    std::string path_;
+    Mode mode_;
+    int fd_ = -1;
+    std::size_t capacity_ = 0;
+    std::size_t num_slots_ = 0;
+    mutable std::byte *base_ = nullptr;
+    mutable std::size_t mapped_ = 0;
+    mutable std::shared_mutex mutex_;
+};
+
+}    // namespace boulderdash
+
+#endif    // BOULDERDASH_SOLUTION_STORE_H_
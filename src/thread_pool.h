@@ -0,0 +1,154 @@
+#ifndef BOULDERDASH_THREAD_POOL_H_
+#define BOULDERDASH_THREAD_POOL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace boulderdash {
+
+// Small persistent pool of worker threads used by the batched/parallel routines.
+// The calling thread always participates in parallel_for, so work completes even if every worker is busy,
+// which also makes nested calls safe.
+class ThreadPool {
+public:
+    explicit ThreadPool(int num_threads) {
+        num_threads = std::max(num_threads, 0);
+        workers_.reserve(static_cast<std::size_t>(num_threads));
+        for (int i = 0; i < num_threads; ++i) {
+            workers_.emplace_back([this]() { WorkerLoop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        for (auto &worker : workers_) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool(ThreadPool &&) = delete;
+    auto operator=(const ThreadPool &) -> ThreadPool & = delete;
+    auto operator=(ThreadPool &&) -> ThreadPool & = delete;
+
+    /**
+     * Get the process wide pool, sized to the hardware concurrency (less the calling thread).
+     */
+    static auto global() -> ThreadPool & {
+        static ThreadPool pool(static_cast<int>(std::max(std::thread::hardware_concurrency(), 1U)) - 1);
+        return pool;
+    }
+
+    /**
+     * Number of threads which can work on a parallel_for, including the caller
+     */
+    [[nodiscard]] auto concurrency() const noexcept -> int {
+        return static_cast<int>(workers_.size()) + 1;
+    }
+
+    /**
+     * Call fn(i) for every i in [0, n), blocking until all calls have returned.
+     * Indices are handed out dynamically, in increasing order.
+     * @param n Number of indices
+     * @param fn Callable taking a std::size_t index
+     * @param max_threads Upper bound on the number of threads used (including the caller), 0 for no limit
+     */
+    template <typename F>
+    void parallel_for(std::size_t n, F &&fn, int max_threads = 0) {
+        if (n == 0) {
+            return;
+        }
+        int num_threads = (max_threads <= 0) ? concurrency() : std::min(max_threads, concurrency());
+        num_threads = static_cast<int>(std::min(static_cast<std::size_t>(num_threads), n));
+        if (num_threads <= 1) {
+            for (std::size_t i = 0; i < n; ++i) {
+                fn(i);
+            }
+            return;
+        }
+
+        auto job = std::make_shared<Job>();
+        job->n = n;
+        job->fn = [&fn](std::size_t i) { fn(i); };
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            for (int i = 0; i < num_threads - 1; ++i) {
+                tasks_.emplace(job);
+            }
+        }
+        cv_.notify_all();
+        job->Run();
+
+        // Helpers which never started are dropped, only wait on the ones still running
+        std::unique_lock<std::mutex> lock(job->mutex);
+        job->closed = true;
+        job->cv.wait(lock, [&job]() { return job->active == 0; });
+    }
+
+private:
+    struct Job {
+        std::size_t n = 0;
+        std::atomic<std::size_t> next = 0;
+        std::function<void(std::size_t)> fn;
+        std::mutex mutex;
+        std::condition_variable cv;
+        int active = 0;
+        bool closed = false;
+
+        void Run() {
+            for (std::size_t i = next.fetch_add(1); i < n; i = next.fetch_add(1)) {
+                fn(i);
+            }
+        }
+    };
+
+    void WorkerLoop() {
+        while (true) {
+            std::shared_ptr<Job> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+                if (stopping_ && tasks_.empty()) {
+                    return;
+                }
+                job = std::move(tasks_.front());
+                tasks_.pop();
+            }
+            {
+                const std::lock_guard<std::mutex> lock(job->mutex);
+                if (job->closed) {
+                    continue;
+                }
+                ++job->active;
+            }
+            job->Run();
+            {
+                const std::lock_guard<std::mutex> lock(job->mutex);
+                --job->active;
+            }
+            job->cv.notify_all();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::queue<std::shared_ptr<Job>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+};
+
+}    // namespace boulderdash
+
+#endif    // BOULDERDASH_THREAD_POOL_H_
@@ -0,0 +1,170 @@
+#include "trace.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace boulderdash {
+
+namespace detail {
+std::atomic<bool> trace_enabled = false;
+}    // namespace detail
+
+namespace {
+constexpr std::array<const char *, kNumTracePhases> kPhaseNames = {
+    "Step", "StartScan", "AgentUpdate", "ElementScan", "Explosion", "EndScan", "Observation", "Render",
+};
+
+struct Event {
+    uint64_t begin;
+    uint64_t end;
+    TracePhase phase;
+};
+
+// Spans of one thread for one trace. Only the owning thread writes, the size is published with release stores so
+// the exporter can read every event below it. A new trace gets new buffers rather than clearing these, so a thread
+// still recording into an old buffer never races the exporter.
+struct ThreadBuffer {
+    // Left uninitialised, so pages are only touched as spans are recorded
+    ThreadBuffer(int tid, uint64_t epoch, std::size_t capacity)
+        : tid(tid), epoch(epoch), capacity(capacity), events(std::make_unique_for_overwrite<Event[]>(capacity)) {}
+
+    int tid;
+    uint64_t epoch;
+    std::size_t capacity;
+    std::unique_ptr<Event[]> events;    // NOLINT(*-avoid-c-arrays)
+    std::atomic<std::size_t> size = 0;
+    std::atomic<uint64_t> dropped = 0;
+};
+
+struct Registry {
+    std::mutex mutex;
+    uint64_t epoch = 0;
+    std::size_t capacity = 0;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;    // Buffers of the current trace
+};
+
+auto GetRegistry() -> Registry & {
+    static Registry registry;
+    return registry;
+}
+
+std::atomic<uint64_t> current_epoch = 0;
+std::atomic<int> next_tid = 0;
+const auto kOrigin = std::chrono::steady_clock::now();
+
+auto NewBuffer(int tid) -> std::shared_ptr<ThreadBuffer> {
+    Registry &registry = GetRegistry();
+    const std::lock_guard<std::mutex> lock(registry.mutex);
+    auto buffer = std::make_shared<ThreadBuffer>(tid, registry.epoch, registry.capacity);
+    registry.buffers.push_back(buffer);
+    return buffer;
+}
+}    // namespace
+
+namespace detail {
+auto trace_now() noexcept -> uint64_t {
+    // Offset by one so a recorded begin time is never the not recording marker
+    return static_cast<uint64_t>(
+               std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - kOrigin)
+                   .count()) +
+           1;
+}
+
+void trace_record(TracePhase phase, uint64_t begin, uint64_t end) noexcept {
+    thread_local const int tid = next_tid.fetch_add(1, std::memory_order_relaxed);
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+    if (!buffer || buffer->epoch != current_epoch.load(std::memory_order_acquire)) {
+        try {
+            buffer = NewBuffer(tid);
+        } catch (...) {
+            buffer.reset();
+            return;
+        }
+    }
+    const std::size_t size = buffer->size.load(std::memory_order_relaxed);
+    if (size == buffer->capacity) {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer->events[size] = {begin, end, phase};
+    buffer->size.store(size + 1, std::memory_order_release);
+}
+}    // namespace detail
+
+auto trace_phase_name(TracePhase phase) noexcept -> const char * {
+    return kPhaseNames[static_cast<std::size_t>(phase)];
+}
+
+void start_trace(std::size_t events_per_thread) {
+    Registry &registry = GetRegistry();
+    {
+        const std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.buffers.clear();
+        registry.capacity = events_per_thread;
+        current_epoch.store(++registry.epoch, std::memory_order_release);
+    }
+    detail::trace_enabled.store(true, std::memory_order_relaxed);
+}
+
+void stop_trace() noexcept {
+    detail::trace_enabled.store(false, std::memory_order_relaxed);
+}
+
+auto chrome_trace_json() -> std::string {
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        Registry &registry = GetRegistry();
+        const std::lock_guard<std::mutex> lock(registry.mutex);
+        buffers = registry.buffers;
+    }
+
+    // Complete events ("X") with times in microseconds, plus a name for each thread
+    std::string out = R"({"displayTimeUnit":"ns","traceEvents":[)";
+    out += R"({"name":"process_name","ph":"M","pid":1,"tid":0,"args":{"name":"boulderdash"}})";
+    for (const auto &buffer : buffers) {
+        const std::string tid = std::to_string(buffer->tid);
+        out += R"(,{"name":"thread_name","ph":"M","pid":1,"tid":)" + tid + R"(,"args":{"name":"thread )" + tid + R"("}})";
+        const std::size_t size = buffer->size.load(std::memory_order_acquire);
+        for (std::size_t i = 0; i < size; ++i) {
+            const Event &event = buffer->events[i];
+            out += R"(,{"name":")";
+            out += trace_phase_name(event.phase);
+            out += R"(","cat":"engine","ph":"X","pid":1,"tid":)" + tid;
+            out += std::format(R"(,"ts":{:.3f},"dur":{:.3f})", static_cast<double>(event.begin) / 1e3,
+                               static_cast<double>(event.end - event.begin) / 1e3);
+            out += "}";
+        }
+    }
+    out += "]}\n";
+    return out;
+}
+
+void write_chrome_trace(const std::string &path) {
+    const std::string json = chrome_trace_json();
+    std::ofstream file(path, std::ios::binary);
+    if (!file || !file.write(json.data(), static_cast<std::streamsize>(json.size())) || !file.flush()) {
+        throw std::runtime_error(std::format("Unable to write trace file {:s}", path));
+    }
+}
+
+auto trace_dropped_events() noexcept -> uint64_t {
+    Registry &registry = GetRegistry();
+    const std::lock_guard<std::mutex> lock(registry.mutex);
+    uint64_t dropped = 0;
+    for (const auto &buffer : registry.buffers) {
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    return dropped;
+}
+
+}    // namespace boulderdash
@@ -0,0 +1,91 @@
+#ifndef BOULDERDASH_TRACE_H_
+#define BOULDERDASH_TRACE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace boulderdash {
+
+// Engine phases recorded by the tracer
+enum class TracePhase : uint8_t {
+    kStep = 0,           // A whole apply_action()
+    kStartScan = 1,
+    kAgentUpdate = 2,
+    kElementScan = 3,    // Update of every element but the agent
+    kExplosion = 4,      // One explosion, chains show as nested spans
+    kEndScan = 5,
+    kObservation = 6,    // Observation encoding
+    kRender = 7,         // Rendering an observation to an image
+};
+constexpr int kNumTracePhases = 8;
+
+/**
+ * Name of a phase as shown in the trace
+ */
+[[nodiscard]] auto trace_phase_name(TracePhase phase) noexcept -> const char *;
+
+// Timeline tracing of engine phases, off by default.
+// Each thread records spans into its own fixed size buffer, so recording takes no locks and threads never contend.
+// Spans which do not fit are dropped and counted. While tracing is off a span costs one relaxed atomic load.
+
+/**
+ * Clear all recorded spans and start recording.
+ * Must not run concurrently with chrome_trace_json() or write_chrome_trace().
+ * @param events_per_thread Buffer size of each recording thread
+ */
+void start_trace(std::size_t events_per_thread = std::size_t{1} << 20);
+
+/**
+ * Stop recording, keeping the recorded spans for export
+ */
+void stop_trace() noexcept;
+
+/**
+ * Export the recorded spans in the Chrome trace event format, loadable in chrome://tracing or Perfetto.
+ * Spans still being recorded by other threads may be missing.
+ */
+[[nodiscard]] auto chrome_trace_json() -> std::string;
+
+/**
+ * Write chrome_trace_json() to a file
+ * @throw std::runtime_error if the file cannot be written
+ */
+void write_chrome_trace(const std::string &path);
+
+/**
+ * Number of spans dropped because a thread's buffer was full since the last start_trace()
+ */
+[[nodiscard]] auto trace_dropped_events() noexcept -> uint64_t;
+
+namespace detail {
+extern std::atomic<bool> trace_enabled;
+[[nodiscard]] auto trace_now() noexcept -> uint64_t;
+void trace_record(TracePhase phase, uint64_t begin, uint64_t end) noexcept;
+}    // namespace detail
+
+// Records the span from construction to destruction if tracing is on when it is constructed
+class TraceSpan {
+public:
+    explicit TraceSpan(TracePhase phase) noexcept
+        : phase_(phase), begin_(detail::trace_enabled.load(std::memory_order_relaxed) ? detail::trace_now() : 0) {}
+    ~TraceSpan() {
+        if (begin_ != 0) {
+            detail::trace_record(phase_, begin_, detail::trace_now());
+        }
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan(TraceSpan &&) = delete;
+    auto operator=(const TraceSpan &) -> TraceSpan & = delete;
+    auto operator=(TraceSpan &&) -> TraceSpan & = delete;
+
+private:
+    TracePhase phase_;
+    uint64_t begin_;    // 0 when not recording
+};
+
+}    // namespace boulderdash
+
+#endif    // BOULDERDASH_TRACE_H_
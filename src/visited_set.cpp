@@ -0,0 +1,121 @@
+#include "visited_set.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace boulderdash {
+
+namespace {
+// Odd multipliers picking one bit per word from the low 32 bits of the hash (as in Parquet's split block filter)
+constexpr std::array<uint32_t, 8> kSalts = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                                            0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+constexpr int kBitShift = 32 - 6;    // Top 6 bits of the salted hash select a bit in a 64 bit word
+constexpr double kBitsPerWord = 64.0;
+
+// splitmix64 finalizer, state hashes are xor combinations so spread their bits first
+constexpr auto mix(uint64_t x) noexcept -> uint64_t {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+constexpr auto bit_mask(uint64_t mixed, std::size_t word) noexcept -> uint64_t {
+    const auto low = static_cast<uint32_t>(mixed);
+    return uint64_t{1} << ((low * kSalts[word]) >> kBitShift);    // NOLINT(*-bounds-constant-array-index)
+}
+}    // namespace
+
+VisitedSet::VisitedSet(std::size_t memory_bytes)
+    : blocks_(std::clamp<std::size_t>(memory_bytes / sizeof(Block), 1, std::size_t{1} << 32)) {}
+
+auto VisitedSet::GetBlock(uint64_t mixed) const noexcept -> std::size_t {
+    // Map the high 32 bits onto [0, num_blocks) without a division
+    return static_cast<std::size_t>(((mixed >> 32) * static_cast<uint64_t>(blocks_.size())) >> 32);
+}
+
+auto VisitedSet::insert(uint64_t hash) noexcept -> bool {
+    const uint64_t mixed = mix(hash);
+    Block &block = blocks_[GetBlock(mixed)];
+    bool is_new = false;
+    for (std::size_t i = 0; i < kWordsPerBlock; ++i) {
+        const uint64_t mask = bit_mask(mixed, i);
+        auto &word = block.words[i];    // NOLINT(*-bounds-constant-array-index)
+        // Skip the read-modify-write once the bit is set, which is the common case for revisited states
+        if ((word.load(std::memory_order_relaxed) & mask) == 0) {
+            is_new |= (word.fetch_or(mask, std::memory_order_relaxed) & mask) == 0;
+        }
+    }
+    (is_new ? inserted_ : rejected_).value.fetch_add(1, std::memory_order_relaxed);
+    return is_new;
+}
+
+auto VisitedSet::contains(uint64_t hash) const noexcept -> bool {
+    const uint64_t mixed = mix(hash);
+    const Block &block = blocks_[GetBlock(mixed)];
+    for (std::size_t i = 0; i < kWordsPerBlock; ++i) {
+        const uint64_t mask = bit_mask(mixed, i);
+        if ((block.words[i].load(std::memory_order_relaxed) & mask) == 0) {    // NOLINT(*-bounds-constant-array-index)
+            return false;
+        }
+    }
+    return true;
+}
+
+void VisitedSet::SampleFill(double &fill, double &false_positive_rate) const noexcept {
+    // A new hash is a false positive if its bit is already set in every word of its block
+    const std::size_t num_samples = std::min(blocks_.size(), kSampleBlocks);
+    const std::size_t stride = blocks_.size() / num_samples;
+    double bits_set = 0;
+    double hit_probability = 0;
+    for (std::size_t sample = 0; sample < num_samples; ++sample) {
+        const Block &block = blocks_[sample * stride];
+        double block_probability = 1;
+        for (const auto &word : block.words) {
+            const auto count = static_cast<double>(std::popcount(word.load(std::memory_order_relaxed)));
+            bits_set += count;
+            block_probability *= count / kBitsPerWord;
+        }
+        hit_probability += block_probability;
+    }
+    fill = bits_set / (static_cast<double>(num_samples * kWordsPerBlock) * kBitsPerWord);
+    false_positive_rate = hit_probability / static_cast<double>(num_samples);
+}
+
+auto VisitedSet::estimated_false_positive_rate() const noexcept -> double {
+    double fill = 0;
+    double false_positive_rate = 0;
+    SampleFill(fill, false_positive_rate);
+    return false_positive_rate;
+}
+
+auto VisitedSet::stats() const noexcept -> Stats {
+    Stats stats{
+        .inserted = inserted_.value.load(std::memory_order_relaxed),
+        .rejected = rejected_.value.load(std::memory_order_relaxed),
+    };
+    SampleFill(stats.fill, stats.false_positive_rate);
+    return stats;
+}
+
+void VisitedSet::clear() noexcept {
+    for (auto &block : blocks_) {
+        for (auto &word : block.words) {
+            word.store(0, std::memory_order_relaxed);
+        }
+    }
+    inserted_.value.store(0, std::memory_order_relaxed);
+    rejected_.value.store(0, std::memory_order_relaxed);
+}
+
+auto VisitedSet::memory_bytes() const noexcept -> std::size_t {
+    return blocks_.size() * sizeof(Block);
+}
+
+}    // namespace boulderdash
@@ -0,0 +1,100 @@
+#ifndef BOULDERDASH_VISITED_SET_H_
+#define BOULDERDASH_VISITED_SET_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "boulderdash_base.h"
+
+namespace boulderdash {
+
+// Memory bounded, thread-safe set of visited state hashes (see get_hash()) for searches whose exact visited set
+// would not fit in memory. A visited state is never reported as new, but a new state may be reported as visited
+// with a small probability (a false positive), which grows as the set fills up.
+// Implemented as a split block Bloom filter: each hash sets one bit in each word of a single cache line sized
+// block, with atomic bit operations so any number of search threads can share it.
+class VisitedSet {
+public:
+    struct Stats {
+        uint64_t inserted = 0;             // Calls to insert() which reported a new state
+        uint64_t rejected = 0;             // Calls to insert() which reported a visited state
+        double fill = 0;                   // Fraction of bits set
+        double false_positive_rate = 0;    // Estimated chance of a new state being reported as visited
+    };
+
+    /**
+     * @param memory_bytes Memory budget for the filter, rounded down to whole 64 byte blocks (at least one)
+     */
+    explicit VisitedSet(std::size_t memory_bytes);
+
+    /**
+     * Mark a state as visited.
+     * Concurrent inserts of the same unseen state may all report it as new.
+     * @param hash The state hash
+     * @return True if the state was not visited before, false if it was (or on a false positive)
+     */
+    auto insert(uint64_t hash) noexcept -> bool;
+    auto insert(const BoulderDashGameState &state) noexcept -> bool {
+        return insert(state.get_hash());
+    }
+
+    /**
+     * Check if a state was visited, without marking it.
+     * @param hash The state hash
+     * @return True if the state was visited (or on a false positive)
+     */
+    [[nodiscard]] auto contains(uint64_t hash) const noexcept -> bool;
+    [[nodiscard]] auto contains(const BoulderDashGameState &state) const noexcept -> bool {
+        return contains(state.get_hash());
+    }
+
+    /**
+     * Estimate the current false positive rate from the fill of a sample of blocks.
+     * Safe to call while other threads insert, so searches can monitor it as they run.
+     */
+    [[nodiscard]] auto estimated_false_positive_rate() const noexcept -> double;
+
+    /**
+     * Get the insert counters and the current fill and false positive estimates
+     */
+    [[nodiscard]] auto stats() const noexcept -> Stats;
+
+    /**
+     * Remove all states and reset the counters. Must not run concurrently with other calls.
+     */
+    void clear() noexcept;
+
+    /**
+     * Memory used by the filter in bytes
+     */
+    [[nodiscard]] auto memory_bytes() const noexcept -> std::size_t;
+
+private:
+    static constexpr std::size_t kWordsPerBlock = 8;
+    static constexpr std::size_t kSampleBlocks = 4096;
+
+    struct alignas(64) Block {
+        std::array<std::atomic<uint64_t>, kWordsPerBlock> words{};
+    };
+
+    // Counters live on their own cache lines, away from the blocks and each other
+    struct alignas(64) Counter {
+        std::atomic<uint64_t> value = 0;
+    };
+
+    [[nodiscard]] auto GetBlock(uint64_t mixed) const noexcept -> std::size_t;
+    // Sample the fill of evenly spaced blocks, returning the mean fraction of bits set and the mean
+    // probability of a new hash hitting only set bits
+    void SampleFill(double &fill, double &false_positive_rate) const noexcept;
+
+    std::vector<Block> blocks_;
+    Counter inserted_;
+    Counter rejected_;
+};
+
+}    // namespace boulderdash
+
+#endif    // BOULDERDASH_VISITED_SET_H_
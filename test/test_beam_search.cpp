@@ -0,0 +1,121 @@
+#include <boulderdash/boulderdash.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace boulderdash;
+
+using std::chrono::duration;
+using std::chrono::high_resolution_clock;
+
+namespace {
+constexpr std::size_t WIDTH = 256;
+constexpr auto TIME_LIMIT = std::chrono::milliseconds(50);
+
+const std::string board_str =
+    "14|14|1|18|18|18|18|18|18|18|18|18|18|18|18|18|18|18|07|01|01|18|01|01|01|01|18|02|02|05|18|18|02|01|01|18|"
+    "02|02|02|02|18|02|32|01|18|18|01|01|02|36|02|02|02|01|18|01|01|02|18|18|18|18|18|18|01|01|01|01|18|34|18|18|"
+    "18|18|01|02|02|01|01|02|02|02|01|02|02|02|18|18|02|02|02|35|02|01|02|02|02|02|01|01|18|18|01|01|02|02|01|02|"
+    "02|01|02|02|01|01|18|18|02|02|02|01|02|01|01|02|01|01|02|02|18|18|18|18|18|18|00|02|01|01|18|18|18|18|18|18|"
+    "01|01|29|18|02|01|02|02|18|02|01|02|18|18|02|01|02|18|02|01|02|02|18|02|02|01|18|18|01|01|01|31|01|01|02|01|"
+    "28|01|38|02|18|18|18|18|18|18|18|18|18|18|18|18|18|18|18";
+
+auto plays_to_solution(const BoulderDashGameState &root, const BeamSearchResult &result) -> bool {
+    BoulderDashGameState state = root;
+    for (const auto action : result.plan) {
+        state.apply_action(action);
+    }
+    return result.solved && state.is_solution();
+}
+
+// The beam finds a solution, the same one for any thread count and for the batched scorer
+auto test_solve() -> bool {
+    const BoulderDashGameState root(board_str);
+    auto t1 = high_resolution_clock::now();
+    const auto result = beam_search(root, gem_distance_heuristic, {.width = WIDTH, .num_threads = 1});
+    auto t2 = high_resolution_clock::now();
+    const duration<double, std::milli> ms = t2 - t1;
+    std::cout << "beam search: " << (result.solved ? "solved" : "not solved") << " in " << result.plan.size()
+              << " steps, " << result.expanded << " expansions, " << ms.count() << " ms" << std::endl;
+    if (!plays_to_solution(root, result)) {
+        return false;
+    }
+
+    const auto parallel = beam_search(root, gem_distance_heuristic, {.width = WIDTH, .num_threads = 0});
+    std::size_t batches = 0;
+    const auto batched = beam_search(
+        root,
+        [&](std::span<const BoulderDashGameState *const> states, std::span<int64_t> scores) {
+            ++batches;
+            for (std::size_t i = 0; i < states.size(); ++i) {
+                scores[i] = gem_distance_heuristic(*states[i]);
+            }
+        },
+        {.width = WIDTH});
+    return parallel.plan == result.plan && batched.plan == result.plan && batches == result.depth;
+}
+
+// Under a time limit too short to solve, the plan leads to the best scored state found
+auto test_deadline() -> bool {
+    const BoulderDashGameState root(board_str);
+    const auto slow = [](const BoulderDashGameState &state) {
+        const auto until = high_resolution_clock::now() + std::chrono::microseconds(200);
+        while (high_resolution_clock::now() < until) {
+        }
+        return gem_distance_heuristic(state);
+    };
+    const auto t1 = high_resolution_clock::now();
+    const auto result = beam_search(root, slow, {.width = WIDTH, .time_limit = TIME_LIMIT});
+    const auto t2 = high_resolution_clock::now();
+    const duration<double, std::milli> ms = t2 - t1;
+    std::cout << "beam search with " << TIME_LIMIT.count() << " ms budget: returned after " << ms.count()
+              << " ms, depth " << result.depth << ", score " << result.score << std::endl;
+    if (result.solved || !result.timed_out || ms > TIME_LIMIT * 2) {
+        return false;
+    }
+    BoulderDashGameState state = root;
+    for (const auto action : result.plan) {
+        state.apply_action(action);
+    }
+    return gem_distance_heuristic(state) == result.score && result.score <= gem_distance_heuristic(root);
+}
+
+// A solution is returned without being scored, so a slow heuristic does not time out the layer holding it
+auto test_unscored_solution() -> bool {
+    const BoulderDashGameState root("3|4|0|19|19|19|19|19|00|08|19|19|19|19|19");
+    const auto slow = [&](const BoulderDashGameState &state) {
+        if (state.get_hash() != root.get_hash()) {
+            std::this_thread::sleep_for(TIME_LIMIT * 4);
+        }
+        return gem_distance_heuristic(state);
+    };
+    const auto result = beam_search(root, slow, {.width = WIDTH, .time_limit = TIME_LIMIT});
+    return plays_to_solution(root, result) && !result.timed_out && result.depth == 1 && result.score == 0;
+}
+
+// A width of one is a greedy walk, and a depth limit stops the search short
+auto test_limits() -> bool {
+    const BoulderDashGameState root(board_str);
+    const auto result = beam_search(root, gem_distance_heuristic, {.width = 1, .max_depth = 3});
+    try {
+        (void)beam_search(root, gem_distance_heuristic, {.width = 0});
+        return false;
+    } catch (const std::invalid_argument &) {
+    }
+    return !result.solved && !result.timed_out && result.depth == 3 && result.expanded == 3;
+}
+}    // namespace
+
+int main() {
+    const bool ok = test_solve() && test_deadline() && test_unscored_solution() && test_limits();
+    if (!ok) {
+        std::cerr << "Beam search returned unexpected results" << std::endl;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,81 @@
+#include <boulderdash/boulderdash.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <span>
+#include <string>
+#include <vector>
+
+using namespace boulderdash;
+
+namespace {
+// Agent, falling stone, firefly facing right and diamond, then brick wall, dirt, empty and orange facing down
+const std::string board_str = "4|6|0|19|19|19|19|19|19|19|00|04|13|05|19|19|18|02|01|45|19|19|19|19|19|19|19";
+constexpr int NUM_CELLS = 24;
+constexpr int NUM_WALLS = 17;
+constexpr int CAPACITY = 8;
+
+using Entity = std::array<int16_t, kNumEntityFields>;
+
+// Visible type, row, col, hidden type, falling, direction
+const std::vector<Entity> EXPECTED = {
+    {0, 1, 1, 0, 0, -1},
+    {3, 1, 2, 4, 1, -1},
+    {8, 1, 3, 13, 0, 1},
+    {4, 1, 4, 5, 0, -1},
+    {30, 2, 4, 45, 0, 2},
+};
+
+auto entity(std::span<const int16_t> out, std::size_t index) -> Entity {
+    Entity row{};
+    std::ranges::copy(out.subspan(index * kNumEntityFields, kNumEntityFields), row.begin());
+    return row;
+}
+
+// Every field of each element, with the background left out and the unused rows padded with -1
+auto test_fields() -> bool {
+    const BoulderDashGameState state(board_str);
+    std::vector<int16_t> out(static_cast<std::size_t>(CAPACITY * kNumEntityFields), 0);
+    if (state.get_entities(out) != static_cast<int>(EXPECTED.size())) {
+        std::cerr << "Unexpected entity count" << std::endl;
+        return false;
+    }
+    for (std::size_t i = 0; i < EXPECTED.size(); ++i) {
+        if (entity(out, i) != EXPECTED[i]) {
+            std::cerr << "Unexpected fields for entity " << i << std::endl;
+            return false;
+        }
+    }
+    const auto padding = std::span(out).subspan(EXPECTED.size() * kNumEntityFields);
+    return std::ranges::all_of(padding, [](int16_t value) { return value == -1; });
+}
+
+// Walls are kept unless filtered, and entities past the capacity are dropped
+auto test_filters() -> bool {
+    const BoulderDashGameState state(board_str);
+    std::vector<int16_t> out(static_cast<std::size_t>(NUM_CELLS * kNumEntityFields));
+    const int with_walls = state.get_entities(out, {.skip_walls = false});
+    if (with_walls != static_cast<int>(EXPECTED.size()) + NUM_WALLS ||
+        entity(out, 0) != Entity{11, 0, 0, 19, 0, -1}) {
+        std::cerr << "Unexpected entities with walls" << std::endl;
+        return false;
+    }
+    if (state.get_entities(out, {.skip_empty = false, .skip_dirt = false, .skip_walls = false}) != NUM_CELLS) {
+        std::cerr << "Unexpected entities without filters" << std::endl;
+        return false;
+    }
+    std::vector<int16_t> small(3 * kNumEntityFields);
+    return state.get_entities(small) == 3 && entity(small, 2) == EXPECTED[2];
+}
+}    // namespace
+
+int main() {
+    const bool ok = test_fields() && test_filters();
+    if (!ok) {
+        std::cerr << "Entity encoder returned unexpected results" << std::endl;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,128 @@
+#include <boulderdash/boulderdash.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace boulderdash;
+
+using std::chrono::duration;
+using std::chrono::high_resolution_clock;
+
+namespace {
+constexpr int NUM_TRIALS = 2000;
+constexpr std::size_t MAX_CELLS = 1000;
+constexpr std::size_t BENCH_CELLS = 1 << 20;
+constexpr int BENCH_REPEATS = 200;
+constexpr unsigned int SEED = 0;
+
+auto random_set(std::mt19937 &gen) -> ElementSet {
+    ElementSet elements;
+    const int size = static_cast<int>(gen() % 6);
+    for (int i = 0; i < size; ++i) {
+        elements.insert(static_cast<HiddenCellType>(gen() % kNumHiddenCellType));
+    }
+    return elements;
+}
+
+// Every query agrees with a plain loop, for all tail lengths and mixes of types
+auto test_against_scalar() -> bool {
+    std::mt19937 gen(SEED);
+    for (int trial = 0; trial < NUM_TRIALS; ++trial) {
+        std::vector<HiddenCellType> cells(gen() % MAX_CELLS);
+        // Few distinct types, so sets match often
+        const int num_types = 1 + static_cast<int>(gen() % 8);
+        for (auto &cell : cells) {
+            cell = static_cast<HiddenCellType>(gen() % static_cast<unsigned int>(num_types));
+        }
+        const ElementSet elements = random_set(gen);
+
+        std::vector<int> expected_indices;
+        std::vector<uint64_t> expected_mask((cells.size() + 63) / 64);
+        for (std::size_t i = 0; i < cells.size(); ++i) {
+            if (elements.contains(cells[i])) {
+                expected_indices.push_back(static_cast<int>(i));
+                expected_mask[i / 64] |= uint64_t{1} << (i % 64);
+            }
+        }
+        std::vector<int> indices;
+        find_cells(cells, elements, indices);
+        std::vector<uint64_t> mask(expected_mask.size(), ~uint64_t{0});
+        match_cells(cells, elements, mask);
+        if (count_cells(cells, elements) != expected_indices.size() ||
+            any_cells(cells, elements) != !expected_indices.empty() || indices != expected_indices ||
+            mask != expected_mask) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Throughput of counting against a plain loop over a large grid
+auto test_speed() -> bool {
+    std::mt19937 gen(SEED);
+    std::vector<HiddenCellType> cells(BENCH_CELLS);
+    for (auto &cell : cells) {
+        cell = static_cast<HiddenCellType>(gen() % kNumHiddenCellType);
+    }
+    const ElementSet falling{HiddenCellType::kStoneFalling, HiddenCellType::kDiamondFalling,
+                             HiddenCellType::kNutFalling, HiddenCellType::kBombFalling};
+
+    std::size_t scalar_count = 0;
+    auto t1 = high_resolution_clock::now();
+    for (int repeat = 0; repeat < BENCH_REPEATS; ++repeat) {
+        scalar_count = static_cast<std::size_t>(
+            std::ranges::count_if(cells, [&](HiddenCellType cell) { return falling.contains(cell); }));
+    }
+    auto t2 = high_resolution_clock::now();
+    const duration<double> scalar_s = t2 - t1;
+
+    std::size_t count = 0;
+    t1 = high_resolution_clock::now();
+    for (int repeat = 0; repeat < BENCH_REPEATS; ++repeat) {
+        count = count_cells(cells, falling);
+    }
+    t2 = high_resolution_clock::now();
+    const duration<double> simd_s = t2 - t1;
+
+    const double bytes = static_cast<double>(BENCH_CELLS) * BENCH_REPEATS;
+    std::cout << "count_cells (" << grid_query_isa() << "): " << bytes / simd_s.count() / 1e9
+              << " GB/s, plain loop: " << bytes / scalar_s.count() / 1e9 << " GB/s" << std::endl;
+    return count == scalar_count;
+}
+
+// State queries agree with the element counts
+auto test_state_queries() -> bool {
+    const std::string board_str =
+        "4|6|0|18|18|18|18|18|18|18|00|20|03|05|18|18|20|06|04|07|18|18|18|18|18|18|18";
+    const BoulderDashGameState state(board_str);
+    std::vector<int32_t> counts(kNumHiddenCellType);
+    state.get_element_counts(counts);
+    for (int element = 0; element < kNumHiddenCellType; ++element) {
+        const auto el = static_cast<HiddenCellType>(element);
+        const auto expected = counts[static_cast<std::size_t>(element)];
+        if (state.count_elements({el}) != expected || state.has_elements({el}) != (expected > 0) ||
+            state.get_indices(el).size() != static_cast<std::size_t>(expected)) {
+            return false;
+        }
+    }
+    const ElementSet falling{HiddenCellType::kStoneFalling, HiddenCellType::kDiamondFalling};
+    if (state.count_elements(falling) != 2 || state.get_indices(falling) != std::vector<int>{14, 15}) {
+        return false;
+    }
+    return true;
+}
+}    // namespace
+
+int main() {
+    const bool ok = test_against_scalar() && test_speed() && test_state_queries();
+    if (!ok) {
+        std::cerr << "Grid queries returned unexpected results" << std::endl;
+    }
+    return ok ? 0 : 1;
+}
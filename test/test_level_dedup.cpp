@@ -0,0 +1,74 @@
+#include <sys/wait.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+const std::string file_a = LEVEL_DEDUP_A;
+const std::string file_b = LEVEL_DEDUP_B;
+
+struct Report {
+    int exit_code = -1;
+    std::vector<std::string> rows;
+
+    [[nodiscard]] auto has(const std::string &row) const -> bool {
+        return std::ranges::find(rows, row) != rows.end();
+    }
+};
+
+// Run level_dedup with the given arguments, returning its exit code and report rows
+auto run_level_dedup(const std::string &args) -> Report {
+    const auto path = std::filesystem::temp_directory_path() / "boulderdash_test_level_dedup.csv";
+    const std::string command = std::string(LEVEL_DEDUP) + " " + args + " --output " + path.string();
+    Report report;
+    const int status = std::system(command.c_str());
+    report.exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    std::ifstream file(path);
+    for (std::string line; std::getline(file, line);) {
+        report.rows.push_back(line);
+    }
+    file.close();
+    std::filesystem::remove(path);
+    return report;
+}
+
+// A level repeated across files fails --check-disjoint, a single file passes
+auto test_exact() -> bool {
+    const auto single = run_level_dedup(file_a + " --check-disjoint");
+    const auto both = run_level_dedup(file_a + " " + file_b + " --check-disjoint");
+    return single.exit_code == 0 && single.rows.size() == 1 && both.exit_code == 2 &&
+           both.has("exact," + file_a + ",0," + file_b + ",0,0");
+}
+
+// Dirt and empty cells only compare equal when the background is normalized
+auto test_normalize_background() -> bool {
+    const std::string row = "exact," + file_a + ",2," + file_b + ",1,0";
+    const auto plain = run_level_dedup(file_a + " " + file_b);
+    const auto normalized = run_level_dedup(file_a + " " + file_b + " --normalize-background");
+    return plain.exit_code == 0 && !plain.has(row) && normalized.exit_code == 0 && normalized.has(row);
+}
+
+// Levels two cells apart are near duplicates within a distance of 2 but not of 1,
+// and a different gems required counts as a single difference
+auto test_near() -> bool {
+    const std::string cells_row = "near," + file_a + ",0," + file_a + ",1,2";
+    const std::string gems_row = "near," + file_a + ",0," + file_b + ",2,1";
+    const auto near_2 = run_level_dedup(file_a + " " + file_b + " --near 2");
+    const auto near_1 = run_level_dedup(file_a + " " + file_b + " --near 1");
+    return near_2.exit_code == 0 && near_2.has(cells_row) && near_2.has(gems_row) && near_1.exit_code == 0 &&
+           !near_1.has(cells_row) && near_1.has(gems_row);
+}
+}    // namespace
+
+int main() {
+    const bool ok = test_exact() && test_normalize_background() && test_near();
+    if (!ok) {
+        std::cerr << "Level dedup returned unexpected results" << std::endl;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+#include <boulderdash/boulderdash.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace boulderdash;
+
+using std::chrono::duration;
+using std::chrono::high_resolution_clock;
+
+namespace {
+constexpr int NUM_LEVELS = 500;
+constexpr int NUM_RESETS = 2000;
+constexpr std::size_t CAPACITY = 256;
+
+// Levels are fixed by their seed, parse, and have the pieces of their scenario
+auto test_generate() -> bool {
+    for (const auto scenario : {LevelScenario::kOneKey, LevelScenario::kThreeKeys, LevelScenario::kHard}) {
+        int reachable = 0;
+        for (int seed = 0; seed < NUM_LEVELS; ++seed) {
+            const std::string board_str = generate_level(scenario, static_cast<uint64_t>(seed));
+            if (board_str != generate_level(scenario, static_cast<uint64_t>(seed))) {
+                return false;
+            }
+            const BoulderDashGameState state(board_str);
+            const auto shape = state.observation_shape();
+            std::vector<int32_t> counts(kNumHiddenCellType);
+            state.get_element_counts(counts);
+            const auto count = [&](HiddenCellType el) { return counts[static_cast<std::size_t>(el)]; };
+            const int diamonds = scenario == LevelScenario::kHard ? 4 : 1;
+            const int closed_gates = scenario == LevelScenario::kThreeKeys ? 3 : 1;
+            const int gates = count(HiddenCellType::kGateRedClosed) + count(HiddenCellType::kGateBlueClosed) +
+                              count(HiddenCellType::kGateGreenClosed) + count(HiddenCellType::kGateYellowClosed);
+            if (shape[1] != 14 || shape[2] != 14 || count(HiddenCellType::kAgent) != 1 ||
+                count(HiddenCellType::kExitClosed) != 1 || count(HiddenCellType::kDiamond) != diamonds ||
+                gates != closed_gates) {
+                return false;
+            }
+            reachable += goals_reachable(state) ? 1 : 0;
+        }
+        // The layout keeps a door of every room and the corridors clear
+        if (reachable != NUM_LEVELS) {
+            return false;
+        }
+    }
+    return generate_level(LevelScenario::kOneKey, 0) != generate_level(LevelScenario::kOneKey, 1);
+}
+
+// Walled off and locked exits are caught by the reachability check
+auto test_goals_reachable() -> bool {
+    const BoulderDashGameState open("3|5|0|18|18|18|18|18|18|00|01|07|18|18|18|18|18|18");
+    const BoulderDashGameState walled("3|5|0|18|18|18|18|18|18|00|18|07|18|18|18|18|18|18");
+    const BoulderDashGameState locked("4|5|0|18|18|18|18|18|18|00|01|27|18|18|18|18|07|18|18|18|18|18|18");
+    const BoulderDashGameState keyed("4|5|0|18|18|18|18|18|18|00|29|27|18|18|18|18|07|18|18|18|18|18|18");
+    return goals_reachable(open) && !goals_reachable(walled) && !goals_reachable(locked) && goals_reachable(keyed);
+}
+
+// The stream gives the same levels whatever the thread count, and resets never wait once it is warm
+auto test_stream() -> bool {
+    std::vector<uint64_t> expected;
+    {
+        LevelStream stream({.scenario = LevelScenario::kThreeKeys, .seed = 7, .capacity = 16, .num_threads = 1});
+        for (int i = 0; i < NUM_LEVELS; ++i) {
+            const auto level = stream.next();
+            if (level.board_str != generate_level(LevelScenario::kThreeKeys, level.seed) ||
+                !goals_reachable(level.state)) {
+                return false;
+            }
+            expected.push_back(level.seed);
+        }
+    }
+    if (!std::ranges::is_sorted(expected) || expected.front() < 7) {
+        return false;
+    }
+
+    LevelStream stream({.scenario = LevelScenario::kThreeKeys, .seed = 7, .capacity = CAPACITY, .num_threads = 2});
+    while (stream.ready() < CAPACITY / 2) {
+        std::this_thread::yield();
+    }
+    const uint64_t warm_waits = stream.waits();
+    double max_us = 0;
+    for (int i = 0; i < NUM_RESETS; ++i) {
+        const auto t1 = high_resolution_clock::now();
+        const auto level = stream.next();
+        const auto t2 = high_resolution_clock::now();
+        max_us = std::max(max_us, duration<double, std::micro>(t2 - t1).count());
+        if (i < NUM_LEVELS && level.seed != expected[static_cast<std::size_t>(i)]) {
+            return false;
+        }
+        // Simulate an episode between resets
+        auto state = level.state;
+        for (int step = 0; step < 100 && !state.is_terminal(); ++step) {
+            state.apply_action(static_cast<Action>(step % kNumActions));
+        }
+    }
+    std::cout << "level stream: " << NUM_RESETS << " resets, " << stream.waits() - warm_waits << " waits, "
+              << stream.rejected() << " rejected, slowest reset " << max_us << " us" << std::endl;
+    return stream.waits() == warm_waits;
+}
+}    // namespace
+
+int main() {
+    const bool ok = test_generate() && test_goals_reachable() && test_stream();
+    if (!ok) {
+        std::cerr << "Level generation returned unexpected results" << std::endl;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+#include <boulderdash/boulderdash.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace boulderdash;
+
+using std::chrono::duration;
+using std::chrono::high_resolution_clock;
+
+namespace {
+constexpr std::size_t NUM_LEVELS = 20000;
+
+const std::string board_str =
+    "14|14|1|18|18|18|18|18|18|18|18|18|18|18|18|18|18|18|07|01|01|18|01|01|01|01|18|02|02|05|18|18|02|01|01|18|"
+    "02|02|02|02|18|02|32|01|18|18|01|01|02|36|02|02|02|01|18|01|01|02|18|18|18|18|18|18|01|01|01|01|18|34|18|18|"
+    "18|18|01|02|02|01|01|02|02|02|01|02|02|02|18|18|02|02|02|35|02|01|02|02|02|02|01|01|18|18|01|01|02|02|01|02|"
+    "02|01|02|02|01|01|18|18|02|02|02|01|02|01|01|02|01|01|02|02|18|18|18|18|18|18|00|02|01|01|18|18|18|18|18|18|"
+    "01|01|29|18|02|01|02|02|18|02|01|02|18|18|02|01|02|18|02|01|02|02|18|02|02|01|18|18|01|01|01|31|01|01|02|01|"
+    "28|01|38|02|18|18|18|18|18|18|18|18|18|18|18|18|18|18|18";
+
+// Parallel construction matches one by one construction, and a level file reads back the same levels
+auto test_make_states() -> bool {
+    const std::vector<std::string> levels(NUM_LEVELS, board_str);
+    auto t1 = high_resolution_clock::now();
+    std::vector<BoulderDashGameState> sequential;
+    sequential.reserve(levels.size());
+    for (const auto &level : levels) {
+        sequential.emplace_back(level);
+    }
+    auto t2 = high_resolution_clock::now();
+    const duration<double, std::milli> sequential_ms = t2 - t1;
+
+    t1 = high_resolution_clock::now();
+    const auto states = make_states(levels);
+    t2 = high_resolution_clock::now();
+    const duration<double, std::milli> parallel_ms = t2 - t1;
+    std::cout << "make_states: " << NUM_LEVELS << " levels in " << parallel_ms.count() << " ms, one by one "
+              << sequential_ms.count() << " ms" << std::endl;
+    if (states != sequential) {
+        return false;
+    }
+
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "boulderdash_test_levels.txt";
+    {
+        std::ofstream file(path);
+        file << "; comment\r\n" << board_str << "\r\n\n" << board_str << "\n";
+    }
+    const auto file_levels = read_level_file(path.string());
+    std::filesystem::remove(path);
+    if (file_levels != std::vector<std::string>{board_str, board_str}) {
+        return false;
+    }
+
+    // The first invalid level is named in the error
+    std::vector<std::string> invalid = levels;
+    invalid[NUM_LEVELS / 2] = "2|2|0|18|18";
+    invalid[NUM_LEVELS - 1] = "bad";
+    try {
+        (void)make_states(invalid);
+        return false;
+    } catch (const std::invalid_argument &e) {
+        return std::string(e.what()).starts_with(std::format("Invalid level {:d}", NUM_LEVELS / 2));
+    }
+}
+
+// Bulk grid and count queries agree with the per cell queries
+auto test_queries() -> bool {
+    const BoulderDashGameState state(board_str);
+    const auto shape = state.observation_shape();
+    const auto num_cells = static_cast<std::size_t>(shape[1] * shape[2]);
+    std::vector<int8_t> grid(num_cells);
+    state.get_hidden_grid(grid);
+    std::vector<int32_t> counts(kNumHiddenCellType);
+    state.get_element_counts(counts);
+    for (std::size_t i = 0; i < num_cells; ++i) {
+        if (grid[i] != static_cast<int8_t>(state.get_hidden_item(static_cast<int>(i)))) {
+            return false;
+        }
+    }
+    // Without magic walls the row-major storage is the grid itself
+    if (!std::ranges::equal(state.get_grid_storage(), grid, {}, [](HiddenCellType el) {
+            return static_cast<int8_t>(el);
+        })) {
+        return false;
+    }
+    for (int element = 0; element < kNumHiddenCellType; ++element) {
+        const auto indices = state.get_indices(static_cast<HiddenCellType>(element));
+        if (static_cast<std::size_t>(counts[static_cast<std::size_t>(element)]) != indices.size()) {
+            return false;
+        }
+    }
+    if (std::accumulate(counts.begin(), counts.end(), std::size_t{0}) != num_cells) {
+        return false;
+    }
+    return true;
+}
+}    // namespace
+
+int main() {
+    const bool ok = test_make_states() && test_queries();
+    if (!ok) {
+        std::cerr << "Bulk construction or queries returned unexpected results" << std::endl;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+#include <boulderdash/boulderdash.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "level_reader.h"
+
+using namespace boulderdash;
+using namespace boulderdash::tools;
+
+namespace {
+// index, rows, cols, gems_required, gems_available, gates, keys, exit_distance, rooms of each fixture level
+constexpr std::size_t NUM_FEATURES = 9;
+const std::vector<std::vector<int32_t>> expected_features = {
+    {0, 3, 8, 1, 1, 1, 1, 4, 2},
+    {1, 3, 7, 0, 0, 1, 1, -1, 2},
+    {2, 3, 7, 0, 1, 0, 0, -1, 3},
+};
+
+auto run_level_stats(const std::filesystem::path &output, const std::string &format) -> bool {
+    const std::string command =
+        std::string(LEVEL_STATS) + " " + LEVEL_STATS_LEVELS + " " + output.string() + " --format " + format;
+    return std::system(command.c_str()) == 0;
+}
+
+// The CSV has a header row, then one row per level in file order
+auto test_csv() -> bool {
+    const auto path = std::filesystem::temp_directory_path() / "boulderdash_test_level_stats.csv";
+    if (!run_level_stats(path, "csv")) {
+        return false;
+    }
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    if (!line.starts_with("index,rows,cols,gems_required,gems_available,gates,keys,exit_distance,rooms,count_agent")) {
+        std::cerr << "Unexpected CSV header " << line << std::endl;
+        return false;
+    }
+    std::vector<std::vector<int32_t>> features;
+    while (std::getline(file, line)) {
+        std::vector<int32_t> row;
+        std::istringstream fields(line);
+        for (std::string field; row.size() < NUM_FEATURES && std::getline(fields, field, ',');) {
+            row.push_back(std::stoi(field));
+        }
+        features.push_back(row);
+    }
+    file.close();
+    std::filesystem::remove(path);
+    if (features != expected_features) {
+        std::cerr << "Unexpected CSV features" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// The binary table holds the same values, column by column
+auto test_binary() -> bool {
+    const auto path = std::filesystem::temp_directory_path() / "boulderdash_test_level_stats.bin";
+    if (!run_level_stats(path, "binary")) {
+        return false;
+    }
+    std::ifstream file(path, std::ios::binary);
+    const std::vector<char> data{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    file.close();
+    std::filesystem::remove(path);
+
+    std::size_t pos = 0;
+    const auto read = [&]<typename T>(T &value) {
+        if (pos + sizeof(T) > data.size()) {
+            return false;
+        }
+        std::memcpy(&value, data.data() + pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    };
+    std::array<char, 4> magic{};
+    uint32_t version = 0;
+    uint32_t num_columns = 0;
+    uint64_t num_rows = 0;
+    if (!read(magic) || !read(version) || !read(num_columns) || !read(num_rows) ||
+        std::string_view(magic.data(), magic.size()) != "BDLS" || version != 1 ||
+        num_columns != NUM_FEATURES + kNumHiddenCellType || num_rows != expected_features.size()) {
+        std::cerr << "Unexpected binary header" << std::endl;
+        return false;
+    }
+    for (uint32_t col = 0; col < num_columns; ++col) {
+        uint32_t name_length = 0;
+        if (!read(name_length) || pos + name_length > data.size()) {
+            return false;
+        }
+        pos += name_length;
+    }
+    for (std::size_t col = 0; col < NUM_FEATURES; ++col) {
+        for (std::size_t row = 0; row < num_rows; ++row) {
+            int32_t value = 0;
+            if (!read(value) || value != expected_features[row][col]) {
+                std::cerr << "Unexpected binary value at row " << row << ", column " << col << std::endl;
+                return false;
+            }
+        }
+    }
+    return pos + (num_rows * (num_columns - NUM_FEATURES) * sizeof(int32_t)) == data.size();
+}
+
+// Lines straddling block boundaries, or longer than a block, are handed out whole and in order
+auto test_reader() -> bool {
+    const auto expected = read_level_file(LEVEL_STATS_LEVELS);
+    for (const std::size_t block_size : {1, 7, 16, 64, 100, 1 << 22}) {
+        LevelFileReader reader(LEVEL_STATS_LEVELS, block_size);
+        std::vector<std::string> lines;
+        std::vector<std::string_view> batch;
+        while (reader.next_batch(batch)) {
+            lines.insert(lines.end(), batch.begin(), batch.end());
+        }
+        if (lines != expected || reader.levels_read() != expected.size()) {
+            std::cerr << "Reading with blocks of " << block_size << " bytes returned unexpected lines" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+}    // namespace
+
+int main() {
+    const bool ok = test_csv() && test_binary() && test_reader();
+    if (!ok) {
+        std::cerr << "Level stats returned unexpected results" << std::endl;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,94 @@
+#include <boulderdash/boulderdash.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace boulderdash;
+
+namespace {
+// A magic wall above the stones, and a row of magic walls which a falling stone activates on tick 3.
+// The second stone lands on the row once the walls expired.
+const std::string board_str =
+    "12|6|0|19|19|19|19|19|19|19|20|03|01|00|19|19|01|01|01|01|19|19|01|01|01|01|19|19|01|01|01|01|19|19|01|01|03|"
+    "01|19|19|01|01|01|01|19|19|01|01|01|01|19|19|20|20|20|20|19|19|01|01|01|01|19|19|01|01|01|01|19|19|19|19|19|"
+    "19|19";
+constexpr int COLS = 6;
+constexpr int UPPER_WALL = (1 * COLS) + 1;
+constexpr int WALL_ROW = 8;
+constexpr int MAGIC_WALL_STEPS = 3;
+
+struct Tick {
+    HiddenCellType upper_wall;
+    HiddenCellType wall_row;
+};
+
+// Walls take the magic wall state when scanned, so the upper wall, scanned before the stone activates the walls,
+// only turns on a tick later
+constexpr std::array<Tick, 8> EXPECTED = {{
+    {HiddenCellType::kWallMagicDormant, HiddenCellType::kWallMagicDormant},
+    {HiddenCellType::kWallMagicDormant, HiddenCellType::kWallMagicDormant},
+    {HiddenCellType::kWallMagicDormant, HiddenCellType::kWallMagicOn},
+    {HiddenCellType::kWallMagicOn, HiddenCellType::kWallMagicOn},
+    {HiddenCellType::kWallMagicOn, HiddenCellType::kWallMagicOn},
+    {HiddenCellType::kWallMagicExpired, HiddenCellType::kWallMagicExpired},
+    {HiddenCellType::kWallMagicExpired, HiddenCellType::kWallMagicExpired},
+    {HiddenCellType::kWallMagicExpired, HiddenCellType::kWallMagicExpired},
+}};
+
+// The walls activate and expire on the same ticks whether or not the board is stepped in chunks
+auto test_ticks(int chunk_size) -> bool {
+    GameParameters params;
+    params.gravity = true;
+    params.magic_wall_steps = MAGIC_WALL_STEPS;
+    params.chunk_size = chunk_size;
+    BoulderDashGameState state(board_str, params);
+    for (std::size_t tick = 0; tick < EXPECTED.size(); ++tick) {
+        state.apply_action(Action::kUp);
+        bool ok = state.get_hidden_item(UPPER_WALL) == EXPECTED[tick].upper_wall;
+        for (int col = 1; col < COLS - 1; ++col) {
+            ok = ok && state.get_hidden_item((WALL_ROW * COLS) + col) == EXPECTED[tick].wall_row;
+        }
+        if (!ok) {
+            std::cerr << "Unexpected magic walls on tick " << tick + 1 << " with chunk size " << chunk_size
+                      << std::endl;
+            return false;
+        }
+    }
+    // The first stone passed through as a diamond, the second rests on the expired walls
+    return state.get_hidden_item(((WALL_ROW + 2) * COLS) + 3) == HiddenCellType::kDiamond &&
+           state.get_hidden_item(((WALL_ROW - 1) * COLS) + 2) == HiddenCellType::kStone;
+}
+
+// The grid storage, which the Python buffer aliases, holds the walls as they are while they switch state
+auto test_grid_storage() -> bool {
+    GameParameters params;
+    params.gravity = true;
+    params.magic_wall_steps = MAGIC_WALL_STEPS;
+    BoulderDashGameState state(board_str, params);
+    std::vector<int8_t> grid(state.get_grid_storage().size());
+    for (std::size_t tick = 0; tick < EXPECTED.size(); ++tick) {
+        state.apply_action(Action::kUp);
+        state.get_hidden_grid(grid);
+        const auto storage = state.get_grid_storage();
+        for (std::size_t i = 0; i < grid.size(); ++i) {
+            if (static_cast<int8_t>(storage[i]) != grid[i]) {
+                std::cerr << "Grid storage differs from the grid at cell " << i << " on tick " << tick + 1 << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+}    // namespace
+
+int main() {
+    const bool ok = test_ticks(0) && test_ticks(4) && test_grid_storage();
+    if (!ok) {
+        std::cerr << "Magic walls returned unexpected results" << std::endl;
+    }
+    return ok ? 0 : 1;
+}
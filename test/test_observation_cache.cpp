@@ -0,0 +1,128 @@
+#include <boulderdash/boulderdash.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace boulderdash;
+
+namespace {
+constexpr int NUM_STATES = 2000;
+constexpr int NUM_THREADS = 8;
+
+const std::string board_str =
+    "14|14|1|18|18|18|18|18|18|18|18|18|18|18|18|18|18|18|07|01|01|18|01|01|01|01|18|02|02|05|18|18|02|01|01|18|"
+    "02|02|02|02|18|02|32|01|18|18|01|01|02|36|02|02|02|01|18|01|01|02|18|18|18|18|18|18|01|01|01|01|18|34|18|18|"
+    "18|18|01|02|02|01|01|02|02|02|01|02|02|02|18|18|02|02|02|35|02|01|02|02|02|02|01|01|18|18|01|01|02|02|01|02|"
+    "02|01|02|02|01|01|18|18|02|02|02|01|02|01|01|02|01|01|02|02|18|18|18|18|18|18|00|02|01|01|18|18|18|18|18|18|"
+    "01|01|29|18|02|01|02|02|18|02|01|02|18|18|02|01|02|18|02|01|02|02|18|02|02|01|18|18|01|01|01|31|01|01|02|01|"
+    "28|01|38|02|18|18|18|18|18|18|18|18|18|18|18|18|18|18|18";
+
+// States from random play, starting over whenever an episode ends
+auto random_states(uint32_t seed) -> std::vector<BoulderDashGameState> {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<std::size_t> action(0, ALL_ACTIONS.size() - 1);
+    BoulderDashGameState state(board_str);
+    std::vector<BoulderDashGameState> states;
+    for (int i = 0; i < NUM_STATES; ++i) {
+        states.push_back(state);
+        if (state.is_terminal()) {
+            state = BoulderDashGameState(board_str);
+        } else {
+            state.apply_action(ALL_ACTIONS[action(rng)]);
+        }
+    }
+    return states;
+}
+
+// A miss computes the observation, and later lookups return the same observation
+auto test_hits() -> bool {
+    ObservationCache cache(NUM_STATES);
+    const auto states = random_states(0);
+    for (const auto &state : states) {
+        const auto observation = cache.get(state);
+        if (*observation != state.get_observation_compact() || cache.get(state) != observation ||
+            cache.find(state.get_hash()) != observation) {
+            std::cerr << "Cached observation differs from get_observation_compact()" << std::endl;
+            return false;
+        }
+    }
+    return cache.hits() + cache.misses() == 2 * states.size() && cache.misses() == cache.size();
+}
+
+// Each shard evicts its oldest entries, so the cache never holds more than its capacity
+auto test_eviction() -> bool {
+    const auto states = random_states(1);
+    for (const std::size_t capacity : {1, 10, 64, 250}) {
+        ObservationCache cache(capacity, 4);
+        for (const auto &state : states) {
+            const auto observation = cache.get(state);
+            if (cache.size() > capacity || cache.find(state.get_hash()) != observation) {
+                std::cerr << "Cache of capacity " << capacity << " holds " << cache.size() << " entries" << std::endl;
+                return false;
+            }
+        }
+        // Evicted observations stay valid for their holders
+        const auto first = cache.get(states.front());
+        cache.clear();
+        if (*first != states.front().get_observation_compact() || cache.size() != 0 || cache.hits() != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// A state of another board size with a colliding hash gets its own observation, not the cached one
+auto test_collision() -> bool {
+    ObservationCache cache(16);
+    const BoulderDashGameState state(board_str);
+    auto internal = BoulderDashGameState("3|4|0|19|19|19|19|19|00|08|19|19|19|19|19").pack();
+    internal.hash = state.get_hash();
+    const BoulderDashGameState colliding(std::move(internal));
+    const auto observation = cache.get(state);
+    const auto other = cache.get(colliding);
+    return *other == colliding.get_observation_compact() && cache.get(state) == observation && cache.misses() == 2;
+}
+
+// Threads sharing a small cache all get the right observations
+auto test_concurrent() -> bool {
+    ObservationCache cache(128);
+    std::atomic<bool> ok = true;
+    std::atomic<uint64_t> num_gets = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; ++t) {
+        // Half the threads play the same game, so they race to insert the same states
+        threads.emplace_back([&, t]() {
+            for (const auto &state : random_states(static_cast<uint32_t>(t % 2))) {
+                if (*cache.get(state) != state.get_observation_compact()) {
+                    ok = false;
+                }
+                (void)cache.find(state.get_hash());
+                num_gets.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    if (!ok || cache.size() > cache.capacity() || cache.hits() + cache.misses() != num_gets) {
+        std::cerr << "Concurrent cache returned unexpected results" << std::endl;
+        return false;
+    }
+    return true;
+}
+}    // namespace
+
+int main() {
+    const bool ok = test_hits() && test_eviction() && test_collision() && test_concurrent();
+    if (!ok) {
+        std::cerr << "Observation cache returned unexpected results" << std::endl;
+    }
+    return ok ? 0 : 1;
+}
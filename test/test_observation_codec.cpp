@@ -0,0 +1,169 @@
+#include <boulderdash/boulderdash.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace boulderdash;
+
+using std::chrono::duration;
+using std::chrono::high_resolution_clock;
+
+namespace {
+constexpr int NUM_FRAMES = 5000;
+constexpr uint32_t KEYFRAME_INTERVAL = 64;
+constexpr double MIN_RATIO = 10;
+constexpr std::size_t HEADER_SIZE = 40;
+constexpr std::size_t ROWS_OFFSET = 8;
+constexpr std::size_t COLS_OFFSET = 12;
+
+const std::string board_str =
+    "14|14|1|18|18|18|18|18|18|18|18|18|18|18|18|18|18|18|07|01|01|18|01|01|01|01|18|02|02|05|18|18|02|01|01|18|"
+    "02|02|02|02|18|02|32|01|18|18|01|01|02|36|02|02|02|01|18|01|01|02|18|18|18|18|18|18|01|01|01|01|18|34|18|18|"
+    "18|18|01|02|02|01|01|02|02|02|01|02|02|02|18|18|02|02|02|35|02|01|02|02|02|02|01|01|18|18|01|01|02|02|01|02|"
+    "02|01|02|02|01|01|18|18|02|02|02|01|02|01|01|02|01|01|02|02|18|18|18|18|18|18|00|02|01|01|18|18|18|18|18|18|"
+    "01|01|29|18|02|01|02|02|18|02|01|02|18|18|02|01|02|18|02|01|02|02|18|02|02|01|18|18|01|01|01|31|01|01|02|01|"
+    "28|01|38|02|18|18|18|18|18|18|18|18|18|18|18|18|18|18|18";
+
+// Random play, starting over whenever an episode ends
+auto record_frames() -> std::vector<std::vector<int8_t>> {
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<std::size_t> action(0, ALL_ACTIONS.size() - 1);
+    BoulderDashGameState state(board_str);
+    std::vector<std::vector<int8_t>> frames;
+    for (int i = 0; i < NUM_FRAMES; ++i) {
+        frames.push_back(state.get_observation_compact());
+        if (state.is_terminal()) {
+            state = BoulderDashGameState(board_str);
+        } else {
+            state.apply_action(ALL_ACTIONS[action(rng)]);
+        }
+    }
+    return frames;
+}
+
+auto throws(const auto &fn) -> bool {
+    try {
+        fn();
+    } catch (const std::invalid_argument &) {
+        return true;
+    }
+    return false;
+}
+
+// Every frame decodes exactly, in order and at random, and the stream is much smaller than the raw frames
+auto test_round_trip() -> bool {
+    const auto frames = record_frames();
+    const BoulderDashGameState state(board_str);
+    const auto [channels, rows, cols] = state.observation_shape();
+    ObservationEncoder encoder(rows, cols, KEYFRAME_INTERVAL);
+    const auto t1 = high_resolution_clock::now();
+    for (const auto &frame : frames) {
+        encoder.append(frame);
+    }
+    const std::vector<uint8_t> data = encoder.finish();
+    const auto t2 = high_resolution_clock::now();
+
+    ObservationDecoder decoder(data);
+    if (decoder.rows() != rows || decoder.cols() != cols || decoder.num_frames() != frames.size()) {
+        std::cerr << "Unexpected stream header" << std::endl;
+        return false;
+    }
+    std::vector<int8_t> out(frames[0].size());
+    for (std::size_t i = 0; i < frames.size(); ++i) {
+        decoder.decode(i, out);
+        if (out != frames[i]) {
+            std::cerr << "Frame " << i << " decoded in order differs" << std::endl;
+            return false;
+        }
+    }
+    const auto t3 = high_resolution_clock::now();
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<std::size_t> pick(0, frames.size() - 1);
+    for (int i = 0; i < 1000; ++i) {
+        const std::size_t frame = pick(rng);
+        if (decoder.decode(frame) != frames[frame]) {
+            std::cerr << "Frame " << frame << " decoded at random differs" << std::endl;
+            return false;
+        }
+    }
+    const auto t4 = high_resolution_clock::now();
+
+    const double ratio = static_cast<double>(frames.size() * frames[0].size()) / static_cast<double>(data.size());
+    std::cout << "codec: " << frames.size() << " frames in " << data.size() << " bytes, ratio " << ratio
+              << ", encode " << duration<double, std::nano>(t2 - t1).count() / NUM_FRAMES << " ns/frame, decode "
+              << duration<double, std::nano>(t3 - t2).count() / NUM_FRAMES << " ns/frame, seek "
+              << duration<double, std::nano>(t4 - t3).count() / 1000 << " ns/frame" << std::endl;
+    return ratio >= MIN_RATIO;
+}
+
+// Bad input is rejected rather than read out of bounds
+auto test_errors() -> bool {
+    ObservationEncoder encoder(2, 3, 4);
+    if (!throws([&]() { encoder.append(std::vector<int8_t>(5)); }) ||
+        !throws([]() { ObservationEncoder(0, 3); }) || !throws([]() { ObservationEncoder(2, 3, 0); }) ||
+        !throws([]() { ObservationEncoder(32768, 3); })) {
+        return false;
+    }
+    for (int i = 0; i < 10; ++i) {
+        encoder.append(std::vector<int8_t>{1, 1, static_cast<int8_t>(i), 2, 2, 2});
+    }
+    const std::vector<uint8_t> data = encoder.finish();
+    ObservationDecoder decoder(data);
+    std::vector<int8_t> small(5);
+    if (!throws([&]() { (void)decoder.decode(10); }) || !throws([&]() { decoder.decode(0, small); })) {
+        return false;
+    }
+
+    // Truncations either fail to open or fail to decode, never crash
+    for (std::size_t size = 0; size < data.size(); ++size) {
+        const bool rejected = throws([&]() {
+            ObservationDecoder truncated(std::vector<uint8_t>(data.begin(), data.begin() + size));
+            for (uint64_t frame = 0; frame < truncated.num_frames(); ++frame) {
+                (void)truncated.decode(frame);
+            }
+        });
+        if (!rejected) {
+            std::cerr << "Truncated stream of " << size << " bytes was accepted" << std::endl;
+            return false;
+        }
+    }
+    // Dimensions beyond a board side are rejected before allocating a frame
+    for (const uint32_t side : {32768U, 100000U, 0x80000000U, 0xFFFFFFFFU}) {
+        for (const std::size_t offset : {ROWS_OFFSET, COLS_OFFSET}) {
+            std::vector<uint8_t> oversized = data;
+            std::memcpy(oversized.data() + offset, &side, sizeof(side));
+            if (!throws([&]() { ObservationDecoder stream(oversized); })) {
+                std::cerr << "Stream with a side of " << side << " was accepted" << std::endl;
+                return false;
+            }
+        }
+    }
+    // Damaged frame data decodes or throws, within bounds
+    for (std::size_t i = HEADER_SIZE; i < data.size(); ++i) {
+        std::vector<uint8_t> damaged = data;
+        damaged[i] ^= 0xFF;
+        (void)throws([&]() {
+            ObservationDecoder stream(damaged);
+            for (uint64_t frame = 0; frame < stream.num_frames(); ++frame) {
+                (void)stream.decode(frame);
+            }
+        });
+    }
+    return true;
+}
+}    // namespace
+
+int main() {
+    const bool ok = test_round_trip() && test_errors();
+    if (!ok) {
+        std::cerr << "Observation codec returned unexpected results" << std::endl;
+    }
+    return ok ? 0 : 1;
+}
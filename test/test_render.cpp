@@ -0,0 +1,111 @@
+#include <boulderdash/boulderdash.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace boulderdash;
+
+namespace {
+constexpr int NUM_STATES = 64;
+constexpr int SMALL_SPRITE_SIZE = 8;
+
+const std::string board_str =
+    "14|14|1|18|18|18|18|18|18|18|18|18|18|18|18|18|18|18|07|01|01|18|01|01|01|01|18|02|02|05|18|18|02|01|01|18|"
+    "02|02|02|02|18|02|32|01|18|18|01|01|02|36|02|02|02|01|18|01|01|02|18|18|18|18|18|18|01|01|01|01|18|34|18|18|"
+    "18|18|01|02|02|01|01|02|02|02|01|02|02|02|18|18|02|02|02|35|02|01|02|02|02|02|01|01|18|18|01|01|02|02|01|02|"
+    "02|01|02|02|01|01|18|18|02|02|02|01|02|01|01|02|01|01|02|02|18|18|18|18|18|18|00|02|01|01|18|18|18|18|18|18|"
+    "01|01|29|18|02|01|02|02|18|02|01|02|18|18|02|01|02|18|02|01|02|02|18|02|02|01|18|18|01|01|01|31|01|01|02|01|"
+    "28|01|38|02|18|18|18|18|18|18|18|18|18|18|18|18|18|18|18";
+const std::string small_board_str = "3|4|0|18|18|18|18|18|00|10|18|18|18|18|18";
+
+// States from random play, starting over whenever an episode ends
+auto random_states() -> std::vector<BoulderDashGameState> {
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<std::size_t> action(0, ALL_ACTIONS.size() - 1);
+    BoulderDashGameState state(board_str);
+    std::vector<BoulderDashGameState> states;
+    for (int i = 0; i < NUM_STATES; ++i) {
+        states.push_back(state);
+        if (state.is_terminal()) {
+            state = BoulderDashGameState(board_str);
+        } else {
+            state.apply_action(ALL_ACTIONS[action(rng)]);
+        }
+    }
+    return states;
+}
+
+auto batch_size(const std::vector<BoulderDashGameState> &states, int sprite_size) -> std::size_t {
+    const auto shape = batch_image_shape(states.size(), states[0], sprite_size);
+    return static_cast<std::size_t>(shape[0]) * static_cast<std::size_t>(shape[1]) *
+           static_cast<std::size_t>(shape[2]) * static_cast<std::size_t>(shape[3]);
+}
+
+auto throws(const auto &fn) -> bool {
+    try {
+        fn();
+    } catch (const std::invalid_argument &) {
+        return true;
+    }
+    return false;
+}
+
+// Each image of the batch equals rendering its state alone, whatever the number of threads
+auto test_batch() -> bool {
+    const auto states = random_states();
+    const std::size_t image_len = states[0].to_image().size();
+    for (const int num_threads : {0, 1, 4}) {
+        std::vector<uint8_t> batch(batch_size(states, SPRITE_WIDTH));
+        render_batch(states, batch.data(), SPRITE_WIDTH, num_threads);
+        for (std::size_t i = 0; i < states.size(); ++i) {
+            if (!std::ranges::equal(std::span(batch).subspan(i * image_len, image_len), states[i].to_image())) {
+                std::cerr << "Image " << i << " of the batch differs from to_image() with " << num_threads
+                          << " threads" << std::endl;
+                return false;
+            }
+        }
+    }
+
+    // Smaller sprites render as the observation with the smaller atlas
+    std::vector<uint8_t> batch(batch_size(states, SMALL_SPRITE_SIZE));
+    render_batch(states, batch.data(), SMALL_SPRITE_SIZE);
+    const std::size_t small_len = batch.size() / states.size();
+    std::vector<uint8_t> image(small_len);
+    for (std::size_t i = 0; i < states.size(); ++i) {
+        const auto [channels, rows, cols] = states[i].observation_shape();
+        render_observation(states[i].get_observation_compact(), rows, cols, SpriteAtlas::get(SMALL_SPRITE_SIZE),
+                           image.data());
+        if (!std::ranges::equal(std::span(batch).subspan(i * small_len, small_len), image)) {
+            std::cerr << "Image " << i << " of the batch differs with sprite size " << SMALL_SPRITE_SIZE << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// A batch mixing board shapes, or with an invalid sprite size, is rejected
+auto test_errors() -> bool {
+    auto states = random_states();
+    std::vector<uint8_t> batch(batch_size(states, SPRITE_WIDTH));
+    if (!throws([&]() { render_batch(states, batch.data(), SPRITE_WIDTH / 2 + 1); })) {
+        return false;
+    }
+    states.emplace_back(small_board_str);
+    return throws([&]() { render_batch(states, batch.data()); });
+}
+}    // namespace
+
+int main() {
+    const bool ok = test_batch() && test_errors();
+    if (!ok) {
+        std::cerr << "Batch rendering returned unexpected results" << std::endl;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+#include <boulderdash/boulderdash.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace boulderdash;
+
+using std::chrono::duration;
+using std::chrono::high_resolution_clock;
+
+namespace {
+constexpr uint64_t CHECKPOINT_INTERVAL = 5000;
+constexpr uint64_t STOP_AFTER = 12345;    // Not a multiple of the interval, so expansions after the last checkpoint
+                                          // are lost and redone
+const std::string board_str =
+    "8|8|3|18|18|18|18|18|18|18|18|18|00|02|02|03|02|05|18|18|02|03|02|02|02|02|18|18|02|02|01|03|02|02|18|"
+    "18|05|02|02|02|03|02|18|18|02|03|02|02|02|02|18|18|02|02|02|05|02|07|18|18|18|18|18|18|18|18|18";
+
+// Manhattan distance from the agent to the exit
+auto exit_distance(const BoulderDashGameState &state) -> int64_t {
+    auto exits = state.get_positions(HiddenCellType::kExitClosed);
+    if (exits.empty()) {
+        exits = state.get_positions(HiddenCellType::kExitOpen);
+    }
+    if (exits.empty()) {
+        return 0;
+    }
+    const auto [agent_row, agent_col] = state.index_to_position(state.get_agent_index());
+    return std::abs(agent_row - exits.front().first) + std::abs(agent_col - exits.front().second);
+}
+
+// Check the solution reaches the exit when played from the start
+auto is_valid_solution(const SearchResult &result) -> bool {
+    BoulderDashGameState state(board_str);
+    for (const auto action : result.solution) {
+        state.apply_action(action);
+    }
+    return result.solved && state.is_solution();
+}
+
+// Run a search uninterrupted, then again with checkpoints, stopping part way and resuming into a new driver from
+// the checkpoint directory. Both must expand and generate the same number of states and find the same solution.
+template <typename MakeSearch>
+auto test_resume(const std::string &name, MakeSearch make_search) -> bool {
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / ("boulderdash_test_search_" + name);
+    std::filesystem::remove_all(dir);
+    const SearchOptions options{.checkpoint_dir = dir.string(), .checkpoint_interval = CHECKPOINT_INTERVAL};
+
+    auto t1 = high_resolution_clock::now();
+    const SearchResult reference = make_search(SearchOptions{})->run();
+    auto t2 = high_resolution_clock::now();
+    const duration<double, std::milli> reference_ms = t2 - t1;
+
+    // Interrupted run, timing the pause of each explicit checkpoint
+    double max_pause_ms = 0;
+    {
+        auto search = make_search(options);
+        uint64_t remaining = STOP_AFTER;
+        while (remaining > 0) {
+            const uint64_t step = std::min<uint64_t>(remaining, 1000);
+            search->run(step);
+            remaining -= step;
+            t1 = high_resolution_clock::now();
+            search->checkpoint();
+            t2 = high_resolution_clock::now();
+            max_pause_ms = std::max(max_pause_ms, duration<double, std::milli>(t2 - t1).count());
+        }
+        // Expansions after the last checkpoint are lost
+        search->wait_for_checkpoint();
+        search->run(CHECKPOINT_INTERVAL / 2);
+    }
+
+    t1 = high_resolution_clock::now();
+    auto resumed_search = make_search(options);
+    t2 = high_resolution_clock::now();
+    const duration<double, std::milli> resume_ms = t2 - t1;
+    const uint64_t resumed_from = resumed_search->expanded();
+    const SearchResult resumed = resumed_search->run();
+    resumed_search->wait_for_checkpoint();
+
+    // A solved checkpoint resumes straight to the result
+    const SearchResult reloaded = make_search(options)->run();
+    std::filesystem::remove_all(dir);
+
+    std::cout << name << ": " << reference.expanded << " expanded, " << reference.generated << " generated, solution "
+              << reference.solution.size() << " actions in " << reference_ms.count() << " ms; resumed from "
+              << resumed_from << " expanded in " << resume_ms.count() << " ms, max checkpoint pause " << max_pause_ms
+              << " ms" << std::endl;
+    return resumed_search->resumed() && resumed_from == STOP_AFTER && is_valid_solution(reference) &&
+           resumed.solution == reference.solution && resumed.expanded == reference.expanded &&
+           resumed.generated == reference.generated && reloaded.solution == reference.solution &&
+           reloaded.expanded == reference.expanded;
+}
+}    // namespace
+
+int main() {
+    const BoulderDashGameState root(board_str);
+    const bool ok = test_resume("breadth_first",
+                                [&](const SearchOptions &options) {
+                                    return std::make_unique<BreadthFirstSearch>(root, options);
+                                }) &&
+                    test_resume("best_first", [&](const SearchOptions &options) {
+                        return std::make_unique<BestFirstSearch>(root, exit_distance, 1, options);
+                    });
+    if (!ok) {
+        std::cerr << "Resumed search differs from the uninterrupted search" << std::endl;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+#include <boulderdash/boulderdash.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace boulderdash;
+
+using std::chrono::duration;
+using std::chrono::high_resolution_clock;
+
+namespace {
+constexpr std::size_t NUM_SOLUTIONS = 200000;
+constexpr std::size_t NUM_READERS = 3;
+constexpr std::size_t MAX_LENGTH = 300;
+constexpr unsigned int SEED = 0;
+
+// Deterministic solution for a given id, so readers can check what they find
+auto make_solution(std::size_t id) -> std::vector<Action> {
+    std::minstd_rand gen(static_cast<unsigned int>(SEED + id + 1));
+    std::vector<Action> actions(1 + (id % MAX_LENGTH));
+    for (auto &action : actions) {
+        action = ALL_ACTIONS[gen() % ALL_ACTIONS.size()];    // NOLINT(*-bounds-constant-array-index)
+    }
+    return actions;
+}
+
+// Spread ids over the hash space like state hashes
+auto make_hash(std::size_t id) -> uint64_t {
+    return (static_cast<uint64_t>(id) + 1) * 0x9e3779b97f4a7c15ULL;
+}
+
+auto test_solution_store() -> bool {
+    const auto path = std::filesystem::temp_directory_path() / "boulderdash_test_solution_store.bin";
+    std::filesystem::remove(path);
+    bool ok = true;
+    {
+        SolutionStore writer(path.string(), SolutionStore::Mode::kWrite, NUM_SOLUTIONS);
+        const SolutionStore reader(path.string(), SolutionStore::Mode::kRead);
+        std::atomic<std::size_t> published = 0;
+        std::atomic<bool> reader_ok = true;
+
+        // Readers check every solution published so far while the writer keeps appending (and growing the file)
+        std::vector<std::thread> readers;
+        for (std::size_t r = 0; r < NUM_READERS; ++r) {
+            readers.emplace_back([&, r]() {
+                std::size_t checked = 0;
+                while (checked < NUM_SOLUTIONS) {
+                    const std::size_t limit = published.load(std::memory_order_acquire);
+                    for (; checked < limit; ++checked) {
+                        const auto solution = reader.find(make_hash(checked));
+                        if (!solution || solution->actions != make_solution(checked) ||
+                            solution->metadata.expansions != checked) {
+                            reader_ok = false;
+                        }
+                    }
+                    if (r == 0 && reader.contains(make_hash(NUM_SOLUTIONS))) {
+                        reader_ok = false;
+                    }
+                }
+            });
+        }
+
+        const auto t1 = high_resolution_clock::now();
+        for (std::size_t i = 0; i < NUM_SOLUTIONS; ++i) {
+            const SolutionStore::Metadata metadata{.solver = "test", .expansions = i, .optimal = i % 2 == 0};
+            writer.put(make_hash(i), make_solution(i), metadata);
+            published.store(i + 1, std::memory_order_release);
+        }
+        const auto t2 = high_resolution_clock::now();
+        for (auto &reader_thread : readers) {
+            reader_thread.join();
+        }
+        const duration<double, std::milli> write_ms = t2 - t1;
+        std::cout << "put: " << write_ms.count() * 1000 / NUM_SOLUTIONS << " us/solution" << std::endl;
+
+        // Only strictly shorter solutions replace stored ones
+        const std::vector<Action> shorter = {Action::kUp};
+        ok = ok && reader_ok && !writer.put(make_hash(0), make_solution(0), {}) &&
+             writer.put(make_hash(1), shorter, {.solver = "shorter"}) && writer.size() == NUM_SOLUTIONS;
+    }
+
+    // Everything survives reopening
+    const SolutionStore reader(path.string(), SolutionStore::Mode::kRead);
+    std::vector<uint64_t> hashes(NUM_SOLUTIONS);
+    for (std::size_t i = 0; i < NUM_SOLUTIONS; ++i) {
+        hashes[i] = make_hash(i);
+    }
+    std::shuffle(hashes.begin(), hashes.end(), std::mt19937(SEED));
+    const auto t1 = high_resolution_clock::now();
+    std::size_t total_length = 0;
+    for (const auto hash : hashes) {
+        total_length += reader.solution_length(hash).value_or(0);
+    }
+    const auto t2 = high_resolution_clock::now();
+    const duration<double, std::milli> read_ms = t2 - t1;
+    std::cout << "solution_length: " << read_ms.count() * 1e6 / NUM_SOLUTIONS << " ns/lookup" << std::endl;
+
+    const auto replaced = reader.find(make_hash(1));
+    ok = ok && reader.size() == NUM_SOLUTIONS && total_length > 0 && replaced && replaced->actions.size() == 1 &&
+         replaced->metadata.solver == "shorter" && reader.find(make_hash(2))->metadata.optimal;
+    std::filesystem::remove(path);
+    if (!ok) {
+        std::cerr << "Solution store returned unexpected results" << std::endl;
+    }
+    return ok;
+}
+}    // namespace
+
+int main() {
+    return test_solution_store() ? 0 : 1;
+}
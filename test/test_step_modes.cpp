@@ -0,0 +1,336 @@
+#include <boulderdash/boulderdash.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace boulderdash;
+
+namespace {
+constexpr int NUM_STEPS = 150;
+constexpr int NUM_BOARDS = 6;
+constexpr int NUM_LONG_STEPS = 600;    // The scan epoch wraps every 255 steps
+constexpr int MIN_THREADS = 2;
+constexpr int MAX_THREADS = 8;
+
+using InternalState = BoulderDashGameState::InternalState;
+
+// Fireflies, butterflies and bombs packed densely enough that explosions chain, with no element which keeps the
+// scan sequential so the wavefront runs
+const std::vector<HiddenCellType> EXPLOSIVE_CELLS = {
+    HiddenCellType::kEmpty,     HiddenCellType::kEmpty,          HiddenCellType::kEmpty,
+    HiddenCellType::kDirt,      HiddenCellType::kDirt,           HiddenCellType::kStone,
+    HiddenCellType::kStone,     HiddenCellType::kStoneFalling,   HiddenCellType::kDiamond,
+    HiddenCellType::kWallBrick, HiddenCellType::kDiamondFalling, HiddenCellType::kNut,
+    HiddenCellType::kFireflyUp, HiddenCellType::kFireflyLeft,    HiddenCellType::kButterflyDown,
+    HiddenCellType::kBomb,      HiddenCellType::kBomb,           HiddenCellType::kBombFalling,
+};
+
+// Mostly settled background, so chunks go dormant until a falling object or a firefly reaches them
+const std::vector<HiddenCellType> SPARSE_CELLS = [] {
+    std::vector<HiddenCellType> cells(40, HiddenCellType::kDirt);
+    cells.insert(cells.end(), 20, HiddenCellType::kEmpty);
+    cells.insert(cells.end(), 6, HiddenCellType::kWallBrick);
+    cells.insert(cells.end(), 3, HiddenCellType::kStone);
+    cells.insert(cells.end(), {HiddenCellType::kDiamond, HiddenCellType::kFireflyUp, HiddenCellType::kBomb});
+    return cells;
+}();
+
+// Every kind of element, including those which keep the scan sequential
+const std::vector<HiddenCellType> MIXED_CELLS = [] {
+    std::vector<HiddenCellType> cells = EXPLOSIVE_CELLS;
+    cells.insert(cells.end(), {HiddenCellType::kBlob, HiddenCellType::kWallMagicDormant, HiddenCellType::kOrangeUp,
+                               HiddenCellType::kExitClosed, HiddenCellType::kKeyRed, HiddenCellType::kGateRedClosed});
+    return cells;
+}();
+
+// Blobs running from next to the agent past the edge of a window of radius 2.
+// Inside the window the first blob is enclosed while the part outside is not, and the second blob is not enclosed
+// but larger than the max blob size of 11 outside of the window.
+const std::string enclosed_blob_str =
+    "5|10|0|19|19|19|19|19|19|19|19|19|19|19|00|18|23|23|23|23|01|01|19|19|18|18|23|23|23|23|01|01|19|19|18|18|18|"
+    "18|18|18|18|18|19|19|19|19|19|19|19|19|19|19|19";
+const std::string large_blob_str =
+    "6|12|0|19|19|19|19|19|19|19|19|19|19|19|19|19|00|01|23|23|23|23|23|23|23|23|19|19|18|18|23|23|23|23|23|23|23|"
+    "23|19|19|18|18|18|18|18|18|18|18|18|18|19|19|18|18|18|18|18|18|18|18|18|18|19|19|19|19|19|19|19|19|19|19|19|"
+    "19|19";
+constexpr int WINDOW_RADIUS = 2;
+
+// Falling stone onto a row of bombs, the first explosion reaches the second bomb on the first step
+const std::string chain_board_str =
+    "6|7|0|19|19|19|19|19|19|19|19|01|01|01|01|00|19|19|01|04|01|01|01|19|19|01|41|41|01|01|19|19|02|02|02|02|02|19|"
+    "19|19|19|19|19|19|19";
+
+// Board of random cells inside a steel border. The agent sits walled in at the top left so it outlives the board.
+auto random_board(std::mt19937 &rng, int rows, int cols, const std::vector<HiddenCellType> &cells) -> std::string {
+    std::uniform_int_distribution<std::size_t> pick(0, cells.size() - 1);
+    std::string board_str = std::to_string(rows) + "|" + std::to_string(cols) + "|0";
+    for (int i = 0; i < rows * cols; ++i) {
+        const int row = i / cols;
+        const int col = i % cols;
+        HiddenCellType el = cells[pick(rng)];
+        if (row == 0 || row == rows - 1 || col == 0 || col == cols - 1 || (row <= 2 && col <= 2)) {
+            el = HiddenCellType::kWallSteel;
+        }
+        if (row == 1 && col == 1) {
+            el = HiddenCellType::kAgent;
+        }
+        board_str += "|" + std::to_string(static_cast<int>(el));
+    }
+    return board_str;
+}
+
+// Tall board of dirt, with a stone falling down an empty shaft onto a stone pile which has been dormant since the
+// first step, and rolls off once hit
+auto shaft_board(int rows, int cols) -> std::string {
+    const int shaft = cols / 2;
+    std::string board_str = std::to_string(rows) + "|" + std::to_string(cols) + "|0";
+    for (int i = 0; i < rows * cols; ++i) {
+        const int row = i / cols;
+        const int col = i % cols;
+        HiddenCellType el = HiddenCellType::kDirt;
+        if (row == 0 || row == rows - 1 || col == 0 || col == cols - 1) {
+            el = HiddenCellType::kWallSteel;
+        } else if (row == 1 && col == 1) {
+            el = HiddenCellType::kAgent;
+        } else if (row == 1 && col == shaft) {
+            el = HiddenCellType::kStone;
+        } else if ((col == shaft && row < rows - 3) || (row >= rows - 4 && row <= rows - 3 && col != shaft)) {
+            el = HiddenCellType::kEmpty;
+        } else if (row == rows - 2 || col == shaft) {
+            el = HiddenCellType::kStone;
+        }
+        board_str += "|" + std::to_string(static_cast<int>(el));
+    }
+    return board_str;
+}
+
+// Gravity on, so stones and diamonds fall and roll
+auto make_params(int chunk_size, int step_threads, int sim_radius = 0) -> GameParameters {
+    GameParameters params;
+    params.gravity = true;
+    params.chunk_size = chunk_size;
+    params.step_threads = step_threads;
+    params.sim_radius = sim_radius;
+    return params;
+}
+
+// Everything but how the states are stepped
+auto same_pack(const InternalState &lhs, const InternalState &rhs) -> bool {
+    const auto fields = [](const InternalState &s) {
+        return std::tie(s.magic_wall_steps, s.blob_max_size, s.butterfly_explosion_ver, s.butterfly_move_ver,
+                        s.gems_collected, s.magic_wall_steps_remaining, s.blob_size, s.rows, s.cols, s.agent_idx,
+                        s.gems_required, s.random_state, s.reward_signal, s.hash, s.blob_chance, s.gravity,
+                        s.disable_explosions, s.magic_active, s.blob_enclosed, s.is_agent_alive, s.is_agent_in_exit,
+                        s.blob_swap, s.grid, s.has_updated);
+    };
+    return fields(lhs) == fields(rhs);
+}
+
+// Step both states with the same random actions, checking after every step that they agree.
+// Approximate states have their hash salted, which is the difference of the initial hashes.
+auto run_lockstep(const std::string &board_str, const GameParameters &reference_params,
+                  const GameParameters &params, uint32_t seed, int num_steps) -> bool {
+    BoulderDashGameState reference(board_str, reference_params);
+    BoulderDashGameState state(board_str, params);
+    const uint64_t salt = reference.get_hash() ^ state.get_hash();
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<std::size_t> action(0, ALL_ACTIONS.size() - 1);
+    for (int step = 0; step < num_steps && !reference.is_terminal(); ++step) {
+        const Action next = ALL_ACTIONS[action(rng)];
+        reference.apply_action(next);
+        state.apply_action(next);
+        InternalState packed = state.pack();
+        packed.hash ^= salt;
+        if ((reference.get_hash() ^ salt) != state.get_hash() || !same_pack(reference.pack(), packed) ||
+            reference.get_changed_cells() != state.get_changed_cells()) {
+            std::cerr << "Step " << step << " differs with chunk size " << params.chunk_size << ", "
+                      << params.step_threads << " step threads and sim radius " << params.sim_radius << " on board "
+                      << board_str << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// The row wavefront steps boards exactly as the sequential scan, including steps abandoned for a chain explosion
+auto test_wavefront() -> bool {
+    std::mt19937 rng(0);
+    std::vector<std::string> boards = {chain_board_str};
+    for (int i = 0; i < NUM_BOARDS; ++i) {
+        boards.push_back(random_board(rng, 24, 32, EXPLOSIVE_CELLS));
+    }
+    const GameParameters reference_params = make_params(0, 1);
+    for (int threads = MIN_THREADS; threads <= MAX_THREADS; ++threads) {
+        const GameParameters params = make_params(0, threads);
+        for (std::size_t i = 0; i < boards.size(); ++i) {
+            if (!run_lockstep(boards[i], reference_params, params, static_cast<uint32_t>(i), NUM_STEPS)) {
+                return false;
+            }
+        }
+    }
+
+    // The chain board does chain, so the abandoned wavefront step was checked above
+    BoulderDashGameState chained(chain_board_str, reference_params);
+    chained.apply_action(Action::kUp);
+    return chained.get_hidden_item((3 * 7) + 3) != HiddenCellType::kBomb;
+}
+
+// Chunked stepping skips dormant chunks without changing the result, alone and with the wavefront
+auto test_chunks() -> bool {
+    std::mt19937 rng(1);
+    std::vector<std::string> boards = {shaft_board(80, 24)};
+    for (int i = 0; i < NUM_BOARDS / 2; ++i) {
+        boards.push_back(random_board(rng, 64, 96, SPARSE_CELLS));
+    }
+    const GameParameters reference_params = make_params(0, 1);
+    for (const int chunk_size : {8, 16, 32}) {
+        for (const int threads : {1, 4}) {
+            const GameParameters params = make_params(chunk_size, threads);
+            for (std::size_t i = 0; i < boards.size(); ++i) {
+                if (!run_lockstep(boards[i], reference_params, params, static_cast<uint32_t>(i), NUM_STEPS)) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// A window covering the board steps it exactly, apart from the hash salt
+auto test_full_window() -> bool {
+    std::mt19937 rng(2);
+    const GameParameters reference_params = make_params(0, 1);
+    for (int i = 0; i < NUM_BOARDS; ++i) {
+        const std::string board_str = random_board(rng, 20, 28, MIXED_CELLS);
+        for (const int sim_radius : {28, 1000}) {
+            if (!run_lockstep(board_str, reference_params, make_params(0, 1, sim_radius), static_cast<uint32_t>(i),
+                              NUM_STEPS)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// The blob decisions only see the blob inside of the window
+auto test_window_blob() -> bool {
+    const auto step = [](const std::string &board_str, int sim_radius) {
+        BoulderDashGameState state(board_str, make_params(0, 1, sim_radius));
+        state.apply_action(Action::kUp);
+        state.apply_action(Action::kUp);
+        return state;
+    };
+    // The window finds the first blob enclosed and turns the part inside of it into diamonds, while the exact scan
+    // leaves it to grow. The part outside is left as it is.
+    const BoulderDashGameState enclosed_window = step(enclosed_blob_str, WINDOW_RADIUS);
+    const BoulderDashGameState enclosed_exact = step(enclosed_blob_str, 0);
+    if (enclosed_window.get_hidden_item(13) != HiddenCellType::kDiamond ||
+        enclosed_window.get_hidden_item(16) != HiddenCellType::kBlob ||
+        enclosed_exact.get_hidden_item(13) != HiddenCellType::kBlob) {
+        std::cerr << "Unexpected enclosed blob in the window" << std::endl;
+        return false;
+    }
+    // The exact scan turns the second blob into stones as it is too large, the window only sees 2 of its cells
+    const BoulderDashGameState large_window = step(large_blob_str, WINDOW_RADIUS);
+    const BoulderDashGameState large_exact = step(large_blob_str, 0);
+    if (large_window.get_hidden_item(27) != HiddenCellType::kBlob ||
+        large_exact.get_hidden_item(27) != HiddenCellType::kStone) {
+        std::cerr << "Unexpected large blob in the window" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Step a state for long enough to wrap its scan epoch, against a reference rebuilt from pack() before every step,
+// which restarts its epoch so it never wraps. The state must also survive its own pack and unpack on every step.
+auto run_epoch_wrap(const std::string &board_str, const GameParameters &params, uint32_t seed) -> bool {
+    BoulderDashGameState state(board_str, params);
+    BoulderDashGameState reference(board_str, params);
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<std::size_t> action(0, ALL_ACTIONS.size() - 1);
+    for (int step = 0; step < NUM_LONG_STEPS && !state.is_terminal(); ++step) {
+        reference = BoulderDashGameState(reference.pack());
+        const Action next = ALL_ACTIONS[action(rng)];
+        reference.apply_action(next);
+        state.apply_action(next);
+        const InternalState packed = state.pack();
+        if (state.get_hash() != reference.get_hash() || !same_pack(packed, reference.pack()) ||
+            state.get_changed_cells() != reference.get_changed_cells() ||
+            BoulderDashGameState(state.pack()) != state) {
+            std::cerr << "Step " << step << " differs across the epoch wrap with chunk size " << params.chunk_size
+                      << ", " << params.step_threads << " step threads and sim radius " << params.sim_radius
+                      << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Every stepping mode keeps the per-cell updated flags right when the scan epoch wraps
+auto test_epoch_wrap() -> bool {
+    std::mt19937 rng(3);
+    const std::vector<std::string> boards = {random_board(rng, 24, 32, EXPLOSIVE_CELLS),
+                                             random_board(rng, 24, 32, MIXED_CELLS)};
+    const std::vector<GameParameters> modes = {make_params(0, 1),  make_params(0, 4),   make_params(16, 1),
+                                               make_params(16, 4), make_params(0, 1, 1000)};
+    for (const auto &params : modes) {
+        for (std::size_t i = 0; i < boards.size(); ++i) {
+            if (!run_epoch_wrap(boards[i], params, static_cast<uint32_t>(i))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Replaying the changed cells of a step, in order, turns the grid before the step into the grid after it
+auto test_changed_cells() -> bool {
+    std::mt19937 rng(4);
+    const std::vector<std::string> boards = {random_board(rng, 24, 32, EXPLOSIVE_CELLS),
+                                             random_board(rng, 24, 32, MIXED_CELLS), chain_board_str};
+    const std::vector<GameParameters> modes = {make_params(0, 1), make_params(0, 4), make_params(16, 1),
+                                               make_params(0, 1, WINDOW_RADIUS)};
+    for (const auto &params : modes) {
+        for (std::size_t i = 0; i < boards.size(); ++i) {
+            BoulderDashGameState state(boards[i], params);
+            std::vector<int8_t> replayed(state.get_grid_storage().size());
+            std::vector<int8_t> grid(replayed.size());
+            state.get_hidden_grid(replayed);
+            std::mt19937 action_rng(static_cast<uint32_t>(i));
+            std::uniform_int_distribution<std::size_t> action(0, ALL_ACTIONS.size() - 1);
+            for (int step = 0; step < NUM_STEPS && !state.is_terminal(); ++step) {
+                state.apply_action(ALL_ACTIONS[action(action_rng)]);
+                for (const auto &change : state.get_changed_cells()) {
+                    auto &cell = replayed[static_cast<std::size_t>(change.index)];
+                    if (cell != static_cast<int8_t>(change.old_type)) {
+                        std::cerr << "Changed cell " << change.index << " on step " << step
+                                  << " does not start from the previous type" << std::endl;
+                        return false;
+                    }
+                    cell = static_cast<int8_t>(change.new_type);
+                }
+                state.get_hidden_grid(grid);
+                if (replayed != grid) {
+                    std::cerr << "Replayed changed cells do not give the grid after step " << step << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+}    // namespace
+
+int main() {
+    const bool ok = test_wavefront() && test_chunks() && test_full_window() && test_window_blob() &&
+                    test_epoch_wrap() && test_changed_cells();
+    if (!ok) {
+        std::cerr << "Step modes returned unexpected results" << std::endl;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+#include <boulderdash/boulderdash.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace boulderdash;
+
+using std::chrono::duration;
+using std::chrono::high_resolution_clock;
+
+namespace {
+constexpr int NUM_THREADS = 3;
+constexpr int NUM_STEPS = 2000;
+
+// Agent next to a firefly, which explodes on the first step
+const std::string explosion_board_str = "3|4|0|18|18|18|18|18|00|10|18|18|18|18|18";
+const std::string board_str =
+    "14|14|1|18|18|18|18|18|18|18|18|18|18|18|18|18|18|18|07|01|01|18|01|01|01|01|18|02|02|05|18|18|02|01|01|18|"
+    "02|02|02|02|18|02|32|01|18|18|01|01|02|36|02|02|02|01|18|01|01|02|18|18|18|18|18|18|01|01|01|01|18|34|18|18|"
+    "18|18|01|02|02|01|01|02|02|02|01|02|02|02|18|18|02|02|02|35|02|01|02|02|02|02|01|01|18|18|01|01|02|02|01|02|"
+    "02|01|02|02|01|01|18|18|02|02|02|01|02|01|01|02|01|01|02|02|18|18|18|18|18|18|00|02|01|01|18|18|18|18|18|18|"
+    "01|01|29|18|02|01|02|02|18|02|01|02|18|18|02|01|02|18|02|01|02|02|18|02|02|01|18|18|01|01|01|31|01|01|02|01|"
+    "28|01|38|02|18|18|18|18|18|18|18|18|18|18|18|18|18|18|18";
+
+auto count(const std::string &json, const std::string &needle) -> std::size_t {
+    std::size_t n = 0;
+    for (std::size_t pos = json.find(needle); pos != std::string::npos; pos = json.find(needle, pos + 1)) {
+        ++n;
+    }
+    return n;
+}
+
+void run_steps(int num_steps) {
+    BoulderDashGameState state(board_str);
+    for (int step = 0; step < num_steps; ++step) {
+        state.apply_action(ALL_ACTIONS[static_cast<std::size_t>(step) % ALL_ACTIONS.size()]);
+        (void)state.get_observation_compact();
+    }
+    (void)state.to_image();
+}
+
+// Every phase is recorded, on every thread, and nothing is recorded once stopped
+auto test_trace() -> bool {
+    start_trace();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < NUM_THREADS; ++i) {
+        threads.emplace_back([]() { run_steps(NUM_STEPS); });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    BoulderDashGameState exploding(explosion_board_str);
+    exploding.apply_action(Action::kUp);
+    stop_trace();
+    run_steps(NUM_STEPS);
+
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "boulderdash_test_trace.json";
+    write_chrome_trace(path.string());
+    std::ifstream file(path);
+    const std::string json((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::filesystem::remove(path);
+
+    for (int phase = 0; phase < kNumTracePhases; ++phase) {
+        const auto name = std::string(R"("name":")") + trace_phase_name(static_cast<TracePhase>(phase)) + "\"";
+        if (count(json, name) == 0) {
+            std::cerr << "Missing phase " << name << std::endl;
+            return false;
+        }
+    }
+    const std::size_t steps = count(json, R"("name":"Step")");
+    const std::size_t thread_names = count(json, R"("name":"thread_name")");
+    std::cout << "trace: " << json.size() / 1024 << " KiB, " << steps << " steps on " << thread_names
+              << " threads, " << trace_dropped_events() << " dropped" << std::endl;
+    return json.starts_with("{") && json.ends_with("]}\n") && steps == (NUM_THREADS * NUM_STEPS) + 1 &&
+           thread_names == NUM_THREADS + 1 && trace_dropped_events() == 0;
+}
+
+// Full buffers drop spans rather than growing, and a new trace starts empty
+auto test_capacity() -> bool {
+    start_trace(10);
+    run_steps(NUM_STEPS);
+    stop_trace();
+    const std::string json = chrome_trace_json();
+    const bool full = count(json, R"("ph":"X")") == 10 && trace_dropped_events() > 0;
+    start_trace(10);
+    stop_trace();
+    return full && count(chrome_trace_json(), R"("ph":"X")") == 0 && trace_dropped_events() == 0;
+}
+
+// Cost of the spans, with tracing off and on
+auto test_overhead() -> bool {
+    const auto time_steps = []() {
+        const auto t1 = high_resolution_clock::now();
+        BoulderDashGameState state(board_str);
+        for (int step = 0; step < NUM_STEPS * 10; ++step) {
+            state.apply_action(ALL_ACTIONS[static_cast<std::size_t>(step) % ALL_ACTIONS.size()]);
+        }
+        const auto t2 = high_resolution_clock::now();
+        return duration<double, std::nano>(t2 - t1).count() / (NUM_STEPS * 10);
+    };
+    const double off_ns = time_steps();
+    start_trace();
+    const double on_ns = time_steps();
+    stop_trace();
+    std::cout << "step: " << off_ns << " ns with tracing off, " << on_ns << " ns with tracing on" << std::endl;
+    return true;
+}
+}    // namespace
+
+int main() {
+    const bool ok = test_trace() && test_capacity() && test_overhead();
+    if (!ok) {
+        std::cerr << "Tracing returned unexpected results" << std::endl;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,132 @@
+#include <boulderdash/boulderdash.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+using namespace boulderdash;
+
+using std::chrono::duration;
+using std::chrono::high_resolution_clock;
+
+namespace {
+constexpr std::size_t MEMORY_BYTES = 1 << 20;
+constexpr std::array<std::size_t, 4> BITS_PER_STATE = {32, 16, 8, 4};
+constexpr std::size_t NUM_THREADS = 4;
+constexpr std::size_t NUM_PROBES = 1 << 20;
+constexpr std::size_t MAX_SEARCH_STATES = 200000;
+constexpr unsigned int SEED = 0;
+
+// Fill filters to several loads from multiple threads, then compare the measured false positive rate on unseen
+// hashes against the running estimate
+auto test_false_positive_rate() -> bool {
+    bool ok = true;
+    std::cout << std::setw(14) << "bits/state" << std::setw(14) << "fill" << std::setw(14) << "estimated"
+              << std::setw(14) << "measured" << std::setw(14) << "ns/insert" << std::endl;
+    for (const std::size_t bits_per_state : BITS_PER_STATE) {
+        VisitedSet visited(MEMORY_BYTES);
+        const std::size_t num_states = visited.memory_bytes() * 8 / bits_per_state;
+        std::vector<uint64_t> hashes(num_states);
+        std::mt19937_64 gen(SEED);
+        std::ranges::generate(hashes, std::ref(gen));
+
+        const auto t1 = high_resolution_clock::now();
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0; t < NUM_THREADS; ++t) {
+            threads.emplace_back([&, t]() {
+                for (std::size_t i = t; i < num_states; i += NUM_THREADS) {
+                    visited.insert(hashes[i]);
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        const auto t2 = high_resolution_clock::now();
+        const duration<double, std::nano> insert_ns = t2 - t1;
+
+        // Inserted hashes are always found
+        ok = ok && std::ranges::all_of(hashes, [&](uint64_t hash) { return visited.contains(hash); });
+        std::size_t false_positives = 0;
+        for (std::size_t i = 0; i < NUM_PROBES; ++i) {
+            false_positives += visited.contains(gen()) ? 1 : 0;
+        }
+        const auto stats = visited.stats();
+        const double measured = static_cast<double>(false_positives) / static_cast<double>(NUM_PROBES);
+        std::cout << std::setw(14) << bits_per_state << std::setw(14) << std::setprecision(4) << stats.fill
+                  << std::setw(14) << stats.false_positive_rate << std::setw(14) << measured << std::setw(14)
+                  << insert_ns.count() / static_cast<double>(num_states) << std::endl;
+        // The estimate should be within a factor of two once false positives are common enough to measure
+        if (measured > 1e-3 && (stats.false_positive_rate < measured / 2 || stats.false_positive_rate > measured * 2)) {
+            ok = false;
+        }
+        ok = ok && stats.inserted + stats.rejected == num_states;
+    }
+    return ok;
+}
+
+// Breadth first search from the start state, pruning with the given visited set, returning states expanded
+template <typename Visited>
+auto search(const std::string &board_str, Visited &&is_new) -> std::size_t {
+    std::deque<BoulderDashGameState> open;
+    open.emplace_back(board_str);
+    is_new(open.front());
+    std::size_t expanded = 0;
+    while (!open.empty() && expanded < MAX_SEARCH_STATES) {
+        const BoulderDashGameState state = std::move(open.front());
+        open.pop_front();
+        ++expanded;
+        for (const auto action : ALL_ACTIONS) {
+            BoulderDashGameState child = state;
+            child.apply_action(action);
+            if (!child.is_terminal() && is_new(child)) {
+                open.push_back(std::move(child));
+            }
+        }
+    }
+    return expanded;
+}
+
+// Breadth first search with the filter in place of an exact set, on a budget well below the exact set's size
+auto test_search() -> bool {
+    const std::string board_str =
+        "14|14|1|18|18|18|18|18|18|18|18|18|18|18|18|18|18|18|07|01|01|18|01|01|01|01|18|02|02|05|18|18|02|01|01|18|"
+        "02|02|02|02|18|02|32|01|18|18|01|01|02|36|02|02|02|01|18|01|01|02|18|18|18|18|18|18|01|01|01|01|18|34|18|18|"
+        "18|18|01|02|02|01|01|02|02|02|01|02|02|02|18|18|02|02|02|35|02|01|02|02|02|02|01|01|18|18|01|01|02|02|01|02|"
+        "02|01|02|02|01|01|18|18|02|02|02|01|02|01|01|02|01|01|02|02|18|18|18|18|18|18|00|02|01|01|18|18|18|18|18|18|"
+        "01|01|29|18|02|01|02|02|18|02|01|02|18|18|02|01|02|18|02|01|02|02|18|02|02|01|18|18|01|01|01|31|01|01|02|01|"
+        "28|01|38|02|18|18|18|18|18|18|18|18|18|18|18|18|18|18|18";
+    std::unordered_set<uint64_t> exact;
+    const std::size_t exact_expanded =
+        search(board_str, [&](const BoulderDashGameState &state) { return exact.insert(state.get_hash()).second; });
+
+    VisitedSet visited(MAX_SEARCH_STATES * 2);    // 16 bits per expanded state
+    const std::size_t filter_expanded =
+        search(board_str, [&](const BoulderDashGameState &state) { return visited.insert(state); });
+    const auto stats = visited.stats();
+    std::cout << "search: exact set " << exact_expanded << " expanded, " << exact.size() * sizeof(uint64_t)
+              << "+ bytes; filter " << filter_expanded << " expanded, " << visited.memory_bytes()
+              << " bytes, estimated false positive rate " << stats.false_positive_rate << std::endl;
+    // False positives only prune, so the filtered search can never expand more states
+    return filter_expanded <= exact_expanded && stats.inserted > 0;
+}
+}    // namespace
+
+int main() {
+    const bool ok = test_false_positive_rate() && test_search();
+    if (!ok) {
+        std::cerr << "Visited set returned unexpected results" << std::endl;
+    }
+    return ok ? 0 : 1;
+}
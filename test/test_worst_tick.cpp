@@ -0,0 +1,66 @@
+#include <boulderdash/boulderdash.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace boulderdash;
+
+using std::chrono::duration;
+using std::chrono::high_resolution_clock;
+
+namespace {
+constexpr int NUM_REPEATS = 200;
+
+const std::string reference_board_str =
+    "14|14|1|18|18|18|18|18|18|18|18|18|18|18|18|18|18|18|07|01|01|18|01|01|01|01|18|02|02|05|18|18|02|01|01|18|"
+    "02|02|02|02|18|02|32|01|18|18|01|01|02|36|02|02|02|01|18|01|01|02|18|18|18|18|18|18|01|01|01|01|18|34|18|18|"
+    "18|18|01|02|02|01|01|02|02|02|01|02|02|02|18|18|02|02|02|35|02|01|02|02|02|02|01|01|18|18|01|01|02|02|01|02|"
+    "02|01|02|02|01|01|18|18|02|02|02|01|02|01|01|02|01|01|02|02|18|18|18|18|18|18|00|02|01|01|18|18|18|18|18|18|"
+    "01|01|29|18|02|01|02|02|18|02|01|02|18|18|02|01|02|18|02|01|02|02|18|02|02|01|18|18|01|01|01|31|01|01|02|01|"
+    "28|01|38|02|18|18|18|18|18|18|18|18|18|18|18|18|18|18|18";
+
+// Fastest time of the slowest first step over all actions
+auto worst_step_ns(const BoulderDashGameState &state) -> double {
+    double worst = 0;
+    for (const auto action : ALL_ACTIONS) {
+        double best = std::numeric_limits<double>::max();
+        for (int repeat = 0; repeat < NUM_REPEATS; ++repeat) {
+            BoulderDashGameState child = state;
+            const auto t1 = high_resolution_clock::now();
+            child.apply_action(action);
+            const auto t2 = high_resolution_clock::now();
+            best = std::min(best, duration<double, std::nano>(t2 - t1).count());
+        }
+        worst = std::max(worst, best);
+    }
+    return worst;
+}
+
+// Step time of the worst case boards found by tools/worst_tick, against a typical board
+auto test_worst_tick() -> bool {
+    const auto boards = read_level_file(WORST_TICK_BOARDS);
+    if (boards.empty()) {
+        return false;
+    }
+    const double reference_ns = worst_step_ns(BoulderDashGameState(reference_board_str));
+    std::cout << "reference board: " << reference_ns << " ns" << std::endl;
+    for (std::size_t i = 0; i < boards.size(); ++i) {
+        const double ns = worst_step_ns(BoulderDashGameState(boards[i]));
+        std::cout << "worst tick board " << i << ": " << ns << " ns (" << ns / reference_ns << "x)" << std::endl;
+    }
+    return true;
+}
+}    // namespace
+
+int main() {
+    const bool ok = test_worst_tick();
+    if (!ok) {
+        std::cerr << "No worst case boards found" << std::endl;
+    }
+    return ok ? 0 : 1;
+}
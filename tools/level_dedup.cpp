@@ -0,0 +1,408 @@
+// Finds exact and near duplicate levels within and across level files, e.g. to check train/test separation.
+//
+// Usage: level_dedup <levels.txt>... [--output report.csv] [--normalize-background] [--near K]
+//                    [--max-bucket N] [--threads N] [--check-disjoint]
+//
+// Each level gets a canonical hash over its size, gems required and cells. With --normalize-background, dirt is
+// treated as empty so levels which only differ in their background compare equal.
+// Levels with the same canonical content are exact duplicates. With --near K, distinct levels of the same size
+// which differ in at most K cells (counting a different gems required as one cell) are near duplicates, such as
+// levels which only differ in decoy placement. Candidates come from splitting the board into K + 1 bands: two
+// boards within K differences agree on at least one band, so only levels sharing a band hash are compared.
+// Bands shared by more than --max-bucket levels (default 4096) are skipped and reported, as they hold no
+// information.
+//
+// The report is a CSV of kind,file_a,level_a,file_b,level_b,distance rows, where levels are indexed per file
+// skipping comment lines. Exact duplicates are reported against the first occurrence, near duplicates between
+// the first occurrences of each distinct level. A summary is written to stderr, and with --check-disjoint the
+// exit code is 2 if any level is duplicated across files.
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "definitions.h"
+#include "level_reader.h"
+#include "thread_pool.h"
+
+using namespace boulderdash;
+using namespace boulderdash::tools;
+
+namespace {
+
+constexpr int kCheckDisjointFailure = 2;
+constexpr std::size_t kDefaultMaxBucket = 4096;
+
+struct Options {
+    std::vector<std::string> input_paths;
+    std::string output_path;
+    bool normalize_background = false;
+    int near_distance = 0;
+    std::size_t max_bucket = kDefaultMaxBucket;
+    int num_threads = 0;
+    bool check_disjoint = false;
+};
+
+struct Level {
+    uint32_t file = 0;
+    uint32_t index = 0;    // Index within its file
+    int32_t rows = 0;
+    int32_t cols = 0;
+    int32_t gems_required = 0;
+    std::size_t offset = 0;    // Start of its cells in the shared cell store
+    uint64_t hash = 0;
+};
+
+struct Match {
+    uint32_t a = 0;    // Level ids, a < b
+    uint32_t b = 0;
+    int32_t distance = 0;
+
+    auto operator<=>(const Match &) const = default;
+};
+
+// splitmix64 finalizer
+constexpr auto mix(uint64_t x) noexcept -> uint64_t {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+auto hash_cells(uint64_t seed, std::span<const HiddenCellType> cells) noexcept -> uint64_t {
+    uint64_t hash = mix(seed);
+    for (const auto el : cells) {
+        hash = mix(hash ^ static_cast<uint8_t>(el));
+    }
+    return hash;
+}
+
+// All levels of all input files, with their cells in one contiguous store
+class LevelSet {
+public:
+    /**
+     * Read and hash every level of a file, in parallel.
+     * @param path Path of the level file
+     * @param normalize_background True to store dirt as empty
+     * @param num_threads Upper bound on the threads used, 0 for all
+     */
+    void add_file(const std::string &path, bool normalize_background, int num_threads) {
+        const auto file = static_cast<uint32_t>(file_paths.size());
+        file_paths.push_back(path);
+        LevelFileReader reader(path);
+        std::vector<std::string_view> lines;
+        std::vector<std::optional<std::string>> errors;
+        while (reader.next_batch(lines)) {
+            // Cells are written straight into the store, so size each level from its header first
+            const std::size_t first = levels.size();
+            const std::size_t first_index = reader.levels_read() - lines.size();
+            std::size_t offset = cells.size();
+            for (std::size_t i = 0; i < lines.size(); ++i) {
+                levels.push_back({.file = file, .index = static_cast<uint32_t>(first_index + i), .offset = offset});
+                offset += peek_num_cells(lines[i]);
+            }
+            cells.resize(offset);
+            errors.assign(lines.size(), std::nullopt);
+            ThreadPool::global().parallel_for(
+                lines.size(),
+                [&](std::size_t i) {
+                    thread_local LevelParser parser;
+                    try {
+                        const LevelView view = parser.parse(lines[i]);
+                        Level &level = levels[first + i];
+                        level.rows = view.rows;
+                        level.cols = view.cols;
+                        level.gems_required = view.gems_required;
+                        const auto stored = std::span(cells).subspan(level.offset, view.cells.size());
+                        std::ranges::copy(view.cells, stored.begin());
+                        if (normalize_background) {
+                            std::ranges::replace(stored, HiddenCellType::kDirt, HiddenCellType::kEmpty);
+                        }
+                        level.hash = hash_cells(header_seed(level), stored);
+                    } catch (const std::invalid_argument &e) {
+                        errors[i] = e.what();
+                    }
+                },
+                num_threads);
+            for (std::size_t i = 0; i < lines.size(); ++i) {
+                if (errors[i]) {
+                    throw std::invalid_argument(
+                        std::format("{:s}, level {:d}: {:s}", path, first_index + i, *errors[i]));
+                }
+            }
+        }
+    }
+
+    [[nodiscard]] auto level_cells(const Level &level) const noexcept -> std::span<const HiddenCellType> {
+        return std::span(cells).subspan(level.offset,
+                                        static_cast<std::size_t>(level.rows) * static_cast<std::size_t>(level.cols));
+    }
+
+    /**
+     * Number of differing cells between two levels of the same size, plus one if their gems required differ.
+     * Counting stops early once the limit is exceeded.
+     */
+    [[nodiscard]] auto distance(const Level &lhs, const Level &rhs, int limit) const noexcept -> int {
+        int distance = lhs.gems_required != rhs.gems_required ? 1 : 0;
+        const auto lhs_cells = level_cells(lhs);
+        const auto rhs_cells = level_cells(rhs);
+        for (std::size_t i = 0; i < lhs_cells.size() && distance <= limit; ++i) {
+            distance += lhs_cells[i] != rhs_cells[i] ? 1 : 0;
+        }
+        return distance;
+    }
+
+    static auto header_seed(const Level &level) noexcept -> uint64_t {
+        return (static_cast<uint64_t>(level.rows) << 48) ^ (static_cast<uint64_t>(level.cols) << 32) ^
+               static_cast<uint32_t>(level.gems_required);
+    }
+
+    std::vector<std::string> file_paths;
+    std::vector<Level> levels;
+    std::vector<HiddenCellType> cells;
+};
+
+// Group levels with identical content, returning the id of each group's first level per level
+auto find_exact(const LevelSet &set) -> std::vector<uint32_t> {
+    std::vector<uint32_t> order(set.levels.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        order[i] = static_cast<uint32_t>(i);
+    }
+    std::ranges::sort(order, [&](uint32_t lhs, uint32_t rhs) {
+        const Level &a = set.levels[lhs];
+        const Level &b = set.levels[rhs];
+        return std::tie(a.hash, a.rows, a.cols, lhs) < std::tie(b.hash, b.rows, b.cols, rhs);
+    });
+    // Hash collisions are resolved by comparing against every distinct level seen in the run of equal hashes
+    std::vector<uint32_t> representative(set.levels.size());
+    std::vector<uint32_t> distinct;
+    for (std::size_t begin = 0; begin < order.size();) {
+        std::size_t end = begin;
+        const Level &first = set.levels[order[begin]];
+        distinct.clear();
+        for (; end < order.size() && set.levels[order[end]].hash == first.hash; ++end) {
+            const uint32_t id = order[end];
+            const Level &level = set.levels[id];
+            const auto it = std::ranges::find_if(distinct, [&](uint32_t other) {
+                const Level &rep = set.levels[other];
+                return rep.rows == level.rows && rep.cols == level.cols && set.distance(rep, level, 0) == 0;
+            });
+            representative[id] = (it == distinct.end()) ? id : *it;
+            if (it == distinct.end()) {
+                distinct.push_back(id);
+            }
+        }
+        begin = end;
+    }
+    return representative;
+}
+
+// Pairs of distinct levels within the given number of differences, found through K + 1 band hashes
+auto find_near(const LevelSet &set, const std::vector<uint32_t> &representative, const Options &options,
+               std::size_t &skipped_buckets) -> std::vector<Match> {
+    const auto num_bands = static_cast<std::size_t>(options.near_distance) + 1;
+    struct BandEntry {
+        uint64_t hash;
+        uint32_t id;
+    };
+    std::vector<BandEntry> entries;
+    for (std::size_t id = 0; id < set.levels.size(); ++id) {
+        if (representative[id] != id) {
+            continue;
+        }
+        const Level &level = set.levels[id];
+        const auto cells = set.level_cells(level);
+        for (std::size_t band = 0; band < num_bands; ++band) {
+            const std::size_t begin = band * cells.size() / num_bands;
+            const std::size_t end = (band + 1) * cells.size() / num_bands;
+            // Bands ignore gems required, which only adds one to the distance
+            const uint64_t seed =
+                mix((static_cast<uint64_t>(level.rows) << 48) ^ (static_cast<uint64_t>(level.cols) << 32) ^ band);
+            entries.push_back({hash_cells(seed, cells.subspan(begin, end - begin)), static_cast<uint32_t>(id)});
+        }
+    }
+    std::ranges::sort(entries, [](const BandEntry &lhs, const BandEntry &rhs) {
+        return std::tie(lhs.hash, lhs.id) < std::tie(rhs.hash, rhs.id);
+    });
+
+    std::vector<std::pair<std::size_t, std::size_t>> buckets;
+    for (std::size_t begin = 0; begin < entries.size();) {
+        std::size_t end = begin + 1;
+        while (end < entries.size() && entries[end].hash == entries[begin].hash) {
+            ++end;
+        }
+        if (end - begin > options.max_bucket) {
+            ++skipped_buckets;
+        } else if (end - begin > 1) {
+            buckets.emplace_back(begin, end);
+        }
+        begin = end;
+    }
+
+    std::vector<Match> matches;
+    std::mutex matches_mutex;
+    ThreadPool::global().parallel_for(
+        buckets.size(),
+        [&](std::size_t bucket) {
+            std::vector<Match> found;
+            const auto [begin, end] = buckets[bucket];
+            for (std::size_t i = begin; i < end; ++i) {
+                const Level &a = set.levels[entries[i].id];
+                for (std::size_t j = i + 1; j < end; ++j) {
+                    const Level &b = set.levels[entries[j].id];
+                    if (a.rows != b.rows || a.cols != b.cols) {
+                        continue;
+                    }
+                    const int distance = set.distance(a, b, options.near_distance);
+                    if (distance <= options.near_distance) {
+                        found.push_back({entries[i].id, entries[j].id, distance});
+                    }
+                }
+            }
+            if (!found.empty()) {
+                const std::lock_guard<std::mutex> lock(matches_mutex);
+                matches.insert(matches.end(), found.begin(), found.end());
+            }
+        },
+        options.num_threads);
+    // A pair sharing several bands is found once per band
+    std::ranges::sort(matches);
+    const auto duplicates = std::ranges::unique(matches, [](const Match &lhs, const Match &rhs) {
+        return lhs.a == rhs.a && lhs.b == rhs.b;
+    });
+    matches.erase(duplicates.begin(), duplicates.end());
+    return matches;
+}
+
+auto parse_options(int argc, char **argv) -> Options {
+    const std::vector<std::string_view> args(argv + 1, argv + argc);    // NOLINT(*-pointer-arithmetic)
+    Options options;
+    const auto parse_int = [](std::string_view name, std::string_view value) {
+        int result = 0;
+        const auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), result);
+        if (ec != std::errc{} || ptr != value.data() + value.size() || result < 0) {
+            throw std::invalid_argument(std::format("Invalid {:s} {:s}", name, value));
+        }
+        return result;
+    };
+    for (std::size_t i = 0; i < args.size(); ++i) {
+        const bool has_value = i + 1 < args.size();
+        if (args[i] == "--output" && has_value) {
+            options.output_path = args[++i];
+        } else if (args[i] == "--normalize-background") {
+            options.normalize_background = true;
+        } else if (args[i] == "--near" && has_value) {
+            options.near_distance = parse_int("near distance", args[++i]);
+        } else if (args[i] == "--max-bucket" && has_value) {
+            options.max_bucket = static_cast<std::size_t>(parse_int("bucket size", args[++i]));
+        } else if (args[i] == "--threads" && has_value) {
+            options.num_threads = parse_int("thread count", args[++i]);
+        } else if (args[i] == "--check-disjoint") {
+            options.check_disjoint = true;
+        } else {
+            options.input_paths.emplace_back(args[i]);
+        }
+    }
+    if (options.input_paths.empty()) {
+        throw std::invalid_argument(
+            "Usage: level_dedup <levels.txt>... [--output report.csv] [--normalize-background] [--near K] "
+            "[--max-bucket N] [--threads N] [--check-disjoint]");
+    }
+    return options;
+}
+
+auto run(const Options &options) -> int {
+    LevelSet set;
+    for (const auto &path : options.input_paths) {
+        set.add_file(path, options.normalize_background, options.num_threads);
+    }
+    const auto representative = find_exact(set);
+    std::size_t skipped_buckets = 0;
+    const auto near = options.near_distance > 0 ? find_near(set, representative, options, skipped_buckets)
+                                                : std::vector<Match>{};
+
+    std::ofstream file;
+    if (!options.output_path.empty()) {
+        file.open(options.output_path);
+        if (!file) {
+            throw std::invalid_argument(std::format("Unable to open output file {:s}", options.output_path));
+        }
+    }
+    std::ostream &out = options.output_path.empty() ? std::cout : file;
+    out << "kind,file_a,level_a,file_b,level_b,distance\n";
+
+    // Summary counters, indexed by whether the pair spans two files
+    std::array<std::size_t, 2> exact_pairs{};
+    std::array<std::size_t, 2> near_pairs{};
+    std::vector<std::size_t> file_levels(set.file_paths.size());
+    std::vector<std::size_t> file_unique(set.file_paths.size());
+    const auto write = [&](std::string_view kind, const Level &a, const Level &b, int distance) {
+        out << kind << ',' << set.file_paths[a.file] << ',' << a.index << ',' << set.file_paths[b.file] << ','
+            << b.index << ',' << distance << '\n';
+    };
+    for (std::size_t id = 0; id < set.levels.size(); ++id) {
+        const Level &level = set.levels[id];
+        const Level &rep = set.levels[representative[id]];
+        ++file_levels[level.file];
+        if (representative[id] == id) {
+            ++file_unique[level.file];
+            continue;
+        }
+        ++exact_pairs[rep.file != level.file ? 1 : 0];
+        write("exact", rep, level, 0);
+    }
+    for (const auto &match : near) {
+        const Level &a = set.levels[match.a];
+        const Level &b = set.levels[match.b];
+        ++near_pairs[a.file != b.file ? 1 : 0];
+        write("near", a, b, match.distance);
+    }
+
+    for (std::size_t file_id = 0; file_id < set.file_paths.size(); ++file_id) {
+        std::cerr << std::format("{:s}: {:d} levels, {:d} distinct", set.file_paths[file_id], file_levels[file_id],
+                                 file_unique[file_id])
+                  << std::endl;
+    }
+    std::cerr << std::format("Exact duplicates: {:d} within files, {:d} across files", exact_pairs[0], exact_pairs[1])
+              << std::endl;
+    if (options.near_distance > 0) {
+        std::cerr << std::format("Near duplicates (<= {:d}): {:d} within files, {:d} across files",
+                                 options.near_distance, near_pairs[0], near_pairs[1])
+                  << std::endl;
+        if (skipped_buckets > 0) {
+            std::cerr << std::format("Skipped {:d} bands shared by more than {:d} levels", skipped_buckets,
+                                     options.max_bucket)
+                      << std::endl;
+        }
+    }
+    const bool overlap = exact_pairs[1] > 0 || near_pairs[1] > 0;
+    return (options.check_disjoint && overlap) ? kCheckDisjointFailure : 0;
+}
+
+}    // namespace
+
+int main(int argc, char **argv) {
+    try {
+        return run(parse_options(argc, argv));
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
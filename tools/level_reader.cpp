@@ -0,0 +1,141 @@
+#include "level_reader.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#include <system_error>
+
+namespace boulderdash::tools {
+
+namespace {
+constexpr int kMaxBoardSide = 32767;
+}    // namespace
+
+auto LevelParser::parse(std::string_view line) -> LevelView {
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    if (!line.empty() && line.back() == '|') {
+        line.remove_suffix(1);
+    }
+    const char *it = line.data();
+    const char *const end = it + line.size();
+    // Each field must be followed by a delimiter, or by the end of the line for the last one
+    auto next_field = [&](const char *name) -> int {
+        int value = 0;
+        const auto [ptr, ec] = std::from_chars(it, end, value);
+        if (ec != std::errc{} || (ptr != end && *ptr != '|')) {
+            throw std::invalid_argument(std::format("Malformed {} field at column {:d}", name, it - line.data()));
+        }
+        it = (ptr == end) ? end : ptr + 1;
+        return value;
+    };
+
+    LevelView level;
+    level.rows = next_field("rows");
+    level.cols = next_field("cols");
+    level.gems_required = next_field("gems_required");
+    if (level.rows <= 0 || level.cols <= 0 || level.rows > kMaxBoardSide || level.cols > kMaxBoardSide) {
+        throw std::invalid_argument(std::format("Invalid board size ({:d}, {:d}), expected 1 to {:d} rows and columns",
+                                                level.rows, level.cols, kMaxBoardSide));
+    }
+
+    const std::size_t num_cells = static_cast<std::size_t>(level.rows) * static_cast<std::size_t>(level.cols);
+    cells_.resize(num_cells);
+    for (std::size_t i = 0; i < num_cells; ++i) {
+        if (it == end) {
+            throw std::invalid_argument(std::format("Expected {:d} cells, found {:d}", num_cells, i));
+        }
+        const int hidden_type = next_field("cell");
+        if (hidden_type < 0 || hidden_type >= kNumHiddenCellType) {
+            throw std::invalid_argument(std::format("Unknown element type: {:d}", hidden_type));
+        }
+        cells_[i] = static_cast<HiddenCellType>(hidden_type);
+    }
+    if (it != end) {
+        throw std::invalid_argument(std::format("Expected {:d} cells, found trailing fields", num_cells));
+    }
+    level.cells = cells_;
+    return level;
+}
+
+auto peek_num_cells(std::string_view line) noexcept -> std::size_t {
+    const char *const end = line.data() + line.size();
+    int rows = 0;
+    int cols = 0;
+    const auto rows_result = std::from_chars(line.data(), end, rows);
+    if (rows_result.ec != std::errc{} || rows_result.ptr == end || *rows_result.ptr != '|') {
+        return 0;
+    }
+    const auto cols_result = std::from_chars(rows_result.ptr + 1, end, cols);
+    if (cols_result.ec != std::errc{} || rows <= 0 || cols <= 0 || rows > kMaxBoardSide || cols > kMaxBoardSide) {
+        return 0;
+    }
+    return static_cast<std::size_t>(rows) * static_cast<std::size_t>(cols);
+}
+
+LevelFileReader::LevelFileReader(const std::string &path, std::size_t block_size)
+    : file_(path, std::ios::binary), block_size_(std::max<std::size_t>(block_size, 1)) {
+    if (!file_) {
+        throw std::invalid_argument(std::format("Unable to open level file {:s}", path));
+    }
+}
+
+auto LevelFileReader::next_batch(std::vector<std::string_view> &lines) -> bool {
+    lines.clear();
+    while (lines.empty()) {
+        // Move the partial line to the front, then fill the rest of the block behind it
+        const std::size_t carry = pending_end_ - pending_begin_;
+        if (carry > 0 && pending_begin_ > 0) {
+            std::memmove(buffer_.data(), buffer_.data() + pending_begin_, carry);
+        }
+        if (!file_ && carry == 0) {
+            return false;
+        }
+        // Grow the block when a single line fills it
+        const std::size_t capacity = std::max(buffer_.size(), carry + block_size_);
+        if (buffer_.size() < capacity) {
+            buffer_.resize(capacity);
+        }
+        std::size_t filled = carry;
+        if (file_) {
+            file_.read(buffer_.data() + carry, static_cast<std::streamsize>(capacity - carry));
+            filled += static_cast<std::size_t>(file_.gcount());
+        }
+        if (filled == 0) {
+            return false;
+        }
+
+        // Everything up to the last newline is complete, the final line of the file may lack one
+        const std::string_view block(buffer_.data(), filled);
+        std::size_t complete = file_ ? block.rfind('\n') : filled - 1;
+        if (complete == std::string_view::npos) {
+            pending_begin_ = 0;
+            pending_end_ = filled;
+            block_size_ *= 2;
+            continue;
+        }
+        pending_begin_ = complete + 1;
+        pending_end_ = filled;
+
+        std::size_t start = 0;
+        while (start <= complete) {
+            std::size_t stop = block.find('\n', start);
+            stop = (stop == std::string_view::npos || stop > complete) ? complete + 1 : stop;
+            std::string_view line = block.substr(start, stop - start);
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            if (!line.empty() && line.front() != ';') {
+                lines.push_back(line);
+            }
+            start = stop + 1;
+        }
+    }
+    levels_read_ += lines.size();
+    return true;
+}
+
+}    // namespace boulderdash::tools
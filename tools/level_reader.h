@@ -0,0 +1,84 @@
+#ifndef BOULDERDASH_TOOLS_LEVEL_READER_H_
+#define BOULDERDASH_TOOLS_LEVEL_READER_H_
+
+#include <cstddef>
+#include <fstream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "definitions.h"
+
+namespace boulderdash::tools {
+
+// A parsed level, valid until the owning LevelParser parses the next line
+struct LevelView {
+    int rows = 0;
+    int cols = 0;
+    int gems_required = 0;
+    std::span<const HiddenCellType> cells;    // row-major, rows * cols entries
+};
+
+// Parses `|` delimited level strings (see the Level Format section of the README) into a reused cell buffer,
+// so a parser kept per thread performs no allocations once it has seen the largest level.
+class LevelParser {
+public:
+    /**
+     * Parse a single level string.
+     * A trailing delimiter and carriage return are accepted.
+     * @param line The level string
+     * @return View of the parsed level, valid until the next call
+     * @throw std::invalid_argument if the line is malformed or holds an unknown element id
+     */
+    auto parse(std::string_view line) -> LevelView;
+
+private:
+    std::vector<HiddenCellType> cells_;
+};
+
+/**
+ * Read the board size of a level string without parsing its cells, for sizing storage ahead of a full parse.
+ * @param line The level string
+ * @return Number of cells on the board, 0 if the header is malformed (LevelParser::parse reports the error)
+ */
+auto peek_num_cells(std::string_view line) noexcept -> std::size_t;
+
+// Streams a level file in fixed size blocks, handing out whole lines as views into the block.
+// Blank lines and lines starting with `;` (comments) are skipped.
+class LevelFileReader {
+public:
+    /**
+     * @param path Path of the level file
+     * @param block_size Number of bytes read per block, grown if a single line does not fit
+     * @throw std::invalid_argument if the file cannot be opened
+     */
+    explicit LevelFileReader(const std::string &path, std::size_t block_size = 1 << 22);
+
+    /**
+     * Read the next batch of levels.
+     * Views handed out by the previous call are invalidated.
+     * @param lines Cleared, then filled with the level lines of the next block
+     * @return False once the file is exhausted
+     */
+    auto next_batch(std::vector<std::string_view> &lines) -> bool;
+
+    /**
+     * Number of levels handed out so far, i.e. the index of the next level.
+     */
+    [[nodiscard]] auto levels_read() const noexcept -> std::size_t {
+        return levels_read_;
+    }
+
+private:
+    std::ifstream file_;
+    std::string buffer_;
+    std::size_t block_size_;
+    std::size_t pending_begin_ = 0;    // Partial line left over from the previous block
+    std::size_t pending_end_ = 0;
+    std::size_t levels_read_ = 0;
+};
+
+}    // namespace boulderdash::tools
+
+#endif    // BOULDERDASH_TOOLS_LEVEL_READER_H_
@@ -0,0 +1,434 @@
+// Computes a per-level feature table for a level file, for building curricula over large level sets.
+//
+// Usage: level_stats <levels.txt> <output> [--format csv|binary] [--threads N]
+//
+// Each row holds the board size, gems available (diamonds on the board) versus gems required, the number of
+// gates and keys, the BFS distance from the agent to the exit, the number of rooms and the count of every
+// element type. Rows are in file order, skipping comment lines.
+//
+// The exit distance is the number of agent moves on the static board: the agent walks over empty, dirt, diamond
+// and key cells, collecting a key opens every gate of its colour, and open gates are crossed in a single move
+// onto the traversable cell behind them. Stones, creatures and other elements block the way, and the exit counts
+// as reached whether or not it is open. Unreachable exits (or boards without an agent) report -1.
+// Rooms are the 4-connected regions of cells which are not walls or gates.
+//
+// The binary format is columnar, little endian:
+//   char[4] magic "BDLS", uint32 version (1), uint32 num_columns, uint64 num_rows,
+//   num_columns x (uint32 name_length, char[name_length] name),
+//   num_columns x int32[num_rows] values.
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "definitions.h"
+#include "level_reader.h"
+#include "thread_pool.h"
+
+using namespace boulderdash;
+using namespace boulderdash::tools;
+
+namespace {
+
+constexpr std::array<const char *, kNumHiddenCellType> kCellNames = {
+    "agent", "empty", "dirt", "stone", "stone_falling", "diamond", "diamond_falling", "exit_closed", "exit_open",
+    "agent_in_exit", "firefly_up", "firefly_left", "firefly_down", "firefly_right", "butterfly_up", "butterfly_left",
+    "butterfly_down", "butterfly_right", "wall_brick", "wall_steel", "wall_magic_dormant", "wall_magic_on",
+    "wall_magic_expired", "blob", "explosion_diamond", "explosion_boulder", "explosion_empty", "gate_red_closed",
+    "gate_red_open", "key_red", "gate_blue_closed", "gate_blue_open", "key_blue", "gate_green_closed",
+    "gate_green_open", "key_green", "gate_yellow_closed", "gate_yellow_open", "key_yellow", "nut", "nut_falling",
+    "bomb", "bomb_falling", "orange_up", "orange_left", "orange_down", "orange_right", "pebble_in_dirt",
+    "stone_in_dirt", "void_in_dirt",
+};
+
+constexpr std::array<const char *, 8> kFeatureNames = {
+    "index", "rows", "cols", "gems_required", "gems_available", "gates", "keys", "exit_distance",
+};
+constexpr const char *kRoomsName = "rooms";
+constexpr std::size_t kNumColumns = kFeatureNames.size() + 1 + kCellNames.size();
+
+// How the agent interacts with a cell when computing reachability
+enum class Passage : uint8_t {
+    kBlocked,
+    kWalk,    // Empty, dirt, diamonds and the agent's own cell
+    kKey,     // Walkable, and opens the gates of its colour
+    kGate,    // Crossed in one move if open (or its key is held) and the cell behind is walkable
+    kExit,
+};
+
+struct CellClass {
+    Passage passage = Passage::kBlocked;
+    int8_t colour = -1;    // Key/gate colour bit, -1 for none
+    bool gate_open = false;
+    bool room_wall = false;    // Separates rooms
+};
+
+consteval auto MakeCellClasses() -> std::array<CellClass, kNumHiddenCellType> {
+    std::array<CellClass, kNumHiddenCellType> classes{};
+    auto set = [&](HiddenCellType el, CellClass cell_class) {
+        classes[static_cast<std::size_t>(to_underlying(el))] = cell_class;
+    };
+    for (const auto el : {HiddenCellType::kAgent, HiddenCellType::kEmpty, HiddenCellType::kDirt,
+                          HiddenCellType::kDiamond, HiddenCellType::kDiamondFalling}) {
+        set(el, {.passage = Passage::kWalk});
+    }
+    for (const auto el : {HiddenCellType::kExitClosed, HiddenCellType::kExitOpen, HiddenCellType::kAgentInExit}) {
+        set(el, {.passage = Passage::kExit});
+    }
+    for (const auto el : {HiddenCellType::kWallBrick, HiddenCellType::kWallSteel, HiddenCellType::kWallMagicDormant,
+                          HiddenCellType::kWallMagicOn, HiddenCellType::kWallMagicExpired}) {
+        set(el, {.room_wall = true});
+    }
+    constexpr std::array<std::array<HiddenCellType, 3>, 4> kGateKeys = {{
+        {HiddenCellType::kGateRedClosed, HiddenCellType::kGateRedOpen, HiddenCellType::kKeyRed},
+        {HiddenCellType::kGateBlueClosed, HiddenCellType::kGateBlueOpen, HiddenCellType::kKeyBlue},
+        {HiddenCellType::kGateGreenClosed, HiddenCellType::kGateGreenOpen, HiddenCellType::kKeyGreen},
+        {HiddenCellType::kGateYellowClosed, HiddenCellType::kGateYellowOpen, HiddenCellType::kKeyYellow},
+    }};
+    for (std::size_t colour = 0; colour < kGateKeys.size(); ++colour) {
+        const auto bit = static_cast<int8_t>(colour);
+        set(kGateKeys[colour][0], {.passage = Passage::kGate, .colour = bit, .room_wall = true});
+        set(kGateKeys[colour][1], {.passage = Passage::kGate, .colour = bit, .gate_open = true, .room_wall = true});
+        set(kGateKeys[colour][2], {.passage = Passage::kKey, .colour = bit});
+    }
+    return classes;
+}
+
+constinit const auto kCellClasses = MakeCellClasses();
+constexpr std::size_t kNumKeySets = 1 << 4;
+
+auto cell_class(HiddenCellType el) noexcept -> const CellClass & {
+    return kCellClasses[static_cast<std::size_t>(to_underlying(el))];    // NOLINT(*-bounds-constant-array-index)
+}
+
+// Per thread search buffers, reused across levels
+struct Workspace {
+    LevelParser parser;
+    std::vector<int32_t> distance;
+    std::vector<std::size_t> queue;
+};
+
+struct Options {
+    std::string input_path;
+    std::string output_path;
+    bool binary = false;
+    int num_threads = 0;
+};
+
+// BFS over (cell, keys held) from the agent, returning the moves needed to step onto the exit or -1
+auto exit_distance(const LevelView &level, Workspace &workspace) -> int32_t {
+    const auto agent = std::ranges::find_if(level.cells, [](HiddenCellType el) {
+        return el == HiddenCellType::kAgent || el == HiddenCellType::kAgentInExit;
+    });
+    if (agent == level.cells.end()) {
+        return -1;
+    }
+    if (*agent == HiddenCellType::kAgentInExit) {
+        return 0;
+    }
+
+    auto &distance = workspace.distance;
+    auto &queue = workspace.queue;
+    const auto start = static_cast<std::size_t>(agent - level.cells.begin());
+    distance.assign(level.cells.size() * kNumKeySets, -1);
+    queue.clear();
+    distance[start * kNumKeySets] = 0;
+    queue.push_back(start * kNumKeySets);
+
+    const auto cell_at = [&](int row, int col) -> const CellClass & {
+        return cell_class(level.cells[static_cast<std::size_t>(row) * static_cast<std::size_t>(level.cols) +
+                                      static_cast<std::size_t>(col)]);
+    };
+    const auto in_bounds = [&](int row, int col) {
+        return row >= 0 && col >= 0 && row < level.rows && col < level.cols;
+    };
+    constexpr std::array<std::pair<int, int>, 4> kOffsets = {{{-1, 0}, {0, 1}, {1, 0}, {0, -1}}};
+    for (std::size_t head = 0; head < queue.size(); ++head) {
+        const std::size_t node = queue[head];
+        const std::size_t index = node / kNumKeySets;
+        const auto keys = static_cast<int>(node % kNumKeySets);
+        const auto row = static_cast<int>(index / static_cast<std::size_t>(level.cols));
+        const auto col = static_cast<int>(index % static_cast<std::size_t>(level.cols));
+        const int32_t next_distance = distance[node] + 1;
+        for (const auto &[d_row, d_col] : kOffsets) {
+            int r = row + d_row;
+            int c = col + d_col;
+            if (!in_bounds(r, c)) {
+                continue;
+            }
+            const CellClass *target = &cell_at(r, c);
+            if (target->passage == Passage::kGate) {
+                if (!target->gate_open && (keys & (1 << target->colour)) == 0) {
+                    continue;
+                }
+                // Land on the cell behind the gate, which must be walkable
+                r += d_row;
+                c += d_col;
+                if (!in_bounds(r, c)) {
+                    continue;
+                }
+                target = &cell_at(r, c);
+                if (target->passage != Passage::kWalk && target->passage != Passage::kKey) {
+                    continue;
+                }
+            }
+            if (target->passage == Passage::kExit) {
+                return next_distance;
+            }
+            if (target->passage == Passage::kBlocked) {
+                continue;
+            }
+            const int next_keys = (target->passage == Passage::kKey) ? (keys | (1 << target->colour)) : keys;
+            const std::size_t next_node =
+                (static_cast<std::size_t>(r) * static_cast<std::size_t>(level.cols) + static_cast<std::size_t>(c)) *
+                    kNumKeySets +
+                static_cast<std::size_t>(next_keys);
+            if (distance[next_node] < 0) {
+                distance[next_node] = next_distance;
+                queue.push_back(next_node);
+            }
+        }
+    }
+    return -1;
+}
+
+// Number of 4-connected regions of cells which are not walls or gates
+auto count_rooms(const LevelView &level, Workspace &workspace) -> int32_t {
+    const std::size_t num_cells = level.cells.size();
+    const auto cols = static_cast<std::size_t>(level.cols);
+    auto &visited = workspace.distance;
+    auto &stack = workspace.queue;
+    visited.assign(num_cells, 0);
+    const auto is_open = [&](std::size_t index) {
+        return visited[index] == 0 && !cell_class(level.cells[index]).room_wall;
+    };
+    int32_t rooms = 0;
+    for (std::size_t seed = 0; seed < num_cells; ++seed) {
+        if (!is_open(seed)) {
+            continue;
+        }
+        ++rooms;
+        visited[seed] = 1;
+        stack.assign(1, seed);
+        while (!stack.empty()) {
+            const std::size_t index = stack.back();
+            stack.pop_back();
+            const std::size_t col = index % cols;
+            const std::array<bool, 4> has_neighbour = {index >= cols, index + cols < num_cells, col > 0,
+                                                       col + 1 < cols};
+            const std::array<std::size_t, 4> neighbours = {index - cols, index + cols, index - 1, index + 1};
+            for (std::size_t i = 0; i < neighbours.size(); ++i) {
+                if (has_neighbour[i] && is_open(neighbours[i])) {
+                    visited[neighbours[i]] = 1;
+                    stack.push_back(neighbours[i]);
+                }
+            }
+        }
+    }
+    return rooms;
+}
+
+// Fill one row of the feature table, in column order
+void compute_features(const LevelView &level, std::size_t level_index, Workspace &workspace, std::span<int32_t> row) {
+    std::array<int32_t, kNumHiddenCellType> counts{};
+    for (const auto el : level.cells) {
+        ++counts[static_cast<std::size_t>(to_underlying(el))];    // NOLINT(*-bounds-constant-array-index)
+    }
+    auto count = [&](HiddenCellType el) {
+        return counts[static_cast<std::size_t>(to_underlying(el))];    // NOLINT(*-bounds-constant-array-index)
+    };
+    int32_t gates = 0;
+    int32_t keys = 0;
+    for (std::size_t i = 0; i < counts.size(); ++i) {
+        const auto passage = kCellClasses[i].passage;    // NOLINT(*-bounds-constant-array-index)
+        gates += (passage == Passage::kGate) ? counts[i] : 0;
+        keys += (passage == Passage::kKey) ? counts[i] : 0;
+    }
+
+    std::size_t col = 0;
+    row[col++] = static_cast<int32_t>(level_index);
+    row[col++] = level.rows;
+    row[col++] = level.cols;
+    row[col++] = level.gems_required;
+    row[col++] = count(HiddenCellType::kDiamond) + count(HiddenCellType::kDiamondFalling);
+    row[col++] = gates;
+    row[col++] = keys;
+    row[col++] = exit_distance(level, workspace);
+    row[col++] = count_rooms(level, workspace);
+    std::ranges::copy(counts, row.begin() + static_cast<std::ptrdiff_t>(col));
+}
+
+auto column_names() -> std::vector<std::string> {
+    std::vector<std::string> names(kFeatureNames.begin(), kFeatureNames.end());
+    names.emplace_back(kRoomsName);
+    for (const auto *name : kCellNames) {
+        names.push_back(std::string("count_") + name);
+    }
+    return names;
+}
+
+template <typename T>
+void write_le(std::ofstream &out, T value) {
+    std::array<char, sizeof(T)> bytes{};
+    const auto bits = static_cast<std::make_unsigned_t<T>>(value);
+    for (std::size_t i = 0; i < sizeof(T); ++i) {
+        bytes[i] = static_cast<char>((bits >> (8 * i)) & 0xFF);    // NOLINT(*-bounds-constant-array-index)
+    }
+    out.write(bytes.data(), bytes.size());
+}
+
+auto parse_options(int argc, char **argv) -> Options {
+    const std::vector<std::string_view> args(argv + 1, argv + argc);    // NOLINT(*-pointer-arithmetic)
+    Options options;
+    std::vector<std::string_view> positional;
+    for (std::size_t i = 0; i < args.size(); ++i) {
+        if (args[i] == "--format" && i + 1 < args.size()) {
+            const auto format = args[++i];
+            if (format != "csv" && format != "binary") {
+                throw std::invalid_argument(std::format("Unknown format {:s}, expected csv or binary", format));
+            }
+            options.binary = format == "binary";
+        } else if (args[i] == "--threads" && i + 1 < args.size()) {
+            const auto value = args[++i];
+            const auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), options.num_threads);
+            if (ec != std::errc{} || ptr != value.data() + value.size() || options.num_threads < 0) {
+                throw std::invalid_argument(std::format("Invalid thread count {:s}", value));
+            }
+        } else {
+            positional.push_back(args[i]);
+        }
+    }
+    if (positional.size() != 2) {
+        throw std::invalid_argument("Usage: level_stats <levels.txt> <output> [--format csv|binary] [--threads N]");
+    }
+    options.input_path = positional[0];
+    options.output_path = positional[1];
+    return options;
+}
+
+void append_csv_row(std::string &csv, std::span<const int32_t> row) {
+    std::array<char, 16> digits{};
+    for (std::size_t i = 0; i < row.size(); ++i) {
+        if (i > 0) {
+            csv.push_back(',');
+        }
+        const auto result = std::to_chars(digits.data(), digits.data() + digits.size(), row[i]);
+        csv.append(digits.data(), result.ptr);
+    }
+    csv.push_back('\n');
+}
+
+void write_binary(std::ofstream &out, const std::vector<std::string> &names,
+                  const std::vector<std::vector<int32_t>> &columns, std::size_t num_rows) {
+    out.write("BDLS", 4);
+    write_le<uint32_t>(out, 1);
+    write_le<uint32_t>(out, static_cast<uint32_t>(names.size()));
+    write_le<uint64_t>(out, num_rows);
+    for (const auto &name : names) {
+        write_le<uint32_t>(out, static_cast<uint32_t>(name.size()));
+        out.write(name.data(), static_cast<std::streamsize>(name.size()));
+    }
+    for (const auto &column : columns) {
+        if constexpr (std::endian::native == std::endian::little) {
+            out.write(reinterpret_cast<const char *>(column.data()),    // NOLINT(*-reinterpret-cast)
+                      static_cast<std::streamsize>(column.size() * sizeof(int32_t)));
+        } else {
+            for (const auto value : column) {
+                write_le(out, value);
+            }
+        }
+    }
+}
+
+void run(const Options &options) {
+    LevelFileReader reader(options.input_path);
+    std::ofstream out(options.output_path, std::ios::binary);
+    if (!out) {
+        throw std::invalid_argument(std::format("Unable to open output file {:s}", options.output_path));
+    }
+    const auto names = column_names();
+    std::string csv;
+    if (!options.binary) {
+        for (std::size_t i = 0; i < names.size(); ++i) {
+            csv += (i > 0 ? "," : "") + names[i];
+        }
+        csv.push_back('\n');
+    }
+
+    // Rows of a batch are computed in parallel, then appended in file order
+    std::vector<std::string_view> lines;
+    std::vector<int32_t> batch;
+    std::vector<std::optional<std::string>> errors;
+    std::vector<std::vector<int32_t>> columns(options.binary ? kNumColumns : 0);
+    std::size_t num_rows = 0;
+    while (reader.next_batch(lines)) {
+        batch.resize(lines.size() * kNumColumns);
+        errors.assign(lines.size(), std::nullopt);
+        ThreadPool::global().parallel_for(
+            lines.size(),
+            [&](std::size_t i) {
+                thread_local Workspace workspace;
+                try {
+                    const LevelView level = workspace.parser.parse(lines[i]);
+                    compute_features(level, num_rows + i, workspace,
+                                     std::span(batch).subspan(i * kNumColumns, kNumColumns));
+                } catch (const std::invalid_argument &e) {
+                    errors[i] = e.what();
+                }
+            },
+            options.num_threads);
+
+        for (std::size_t i = 0; i < lines.size(); ++i) {
+            if (errors[i]) {
+                throw std::invalid_argument(std::format("Level {:d}: {:s}", num_rows + i, *errors[i]));
+            }
+            const auto row = std::span<const int32_t>(batch).subspan(i * kNumColumns, kNumColumns);
+            if (options.binary) {
+                for (std::size_t col = 0; col < kNumColumns; ++col) {
+                    columns[col].push_back(row[col]);
+                }
+            } else {
+                append_csv_row(csv, row);
+            }
+        }
+        num_rows += lines.size();
+        if (!options.binary) {
+            out.write(csv.data(), static_cast<std::streamsize>(csv.size()));
+            csv.clear();
+        }
+    }
+    if (options.binary) {
+        write_binary(out, names, columns, num_rows);
+    }
+    if (!out) {
+        throw std::invalid_argument(std::format("Failed writing to {:s}", options.output_path));
+    }
+    std::cerr << std::format("Wrote {:d} levels to {:s}", num_rows, options.output_path) << std::endl;
+}
+
+}    // namespace
+
+int main(int argc, char **argv) {
+    try {
+        run(parse_options(argc, argv));
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
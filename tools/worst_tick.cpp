@@ -0,0 +1,355 @@
+// Searches for boards on which a single apply_action does the most work, to use as worst case benchmark fixtures.
+//
+// Usage: worst_tick <output.txt> [--rows R] [--cols C] [--palette ID,ID,...] [--objective NAME] [--init levels.txt]
+//                   [--restarts N] [--iterations N] [--keep K] [--seed S] [--threads N]
+//
+// Each restart starts from a random board (steel border, one agent, interior cells drawn from the palette), or from
+// the next level of the --init file, and hill climbs by changing one to four random interior cells to palette
+// elements, keeping a change unless it lowers the score. The agent's cell is never changed. The score of a board
+// is the worst over all actions of one apply_action from it, measured by the objective:
+//   changes     cells written during the step (the SetItem count)
+//   explosions  cells turned into explosions during the step
+//   blob        cells the blob grew into, or blob cells replaced once it is enclosed or too large, during the step
+//   time        nanoseconds taken by the step, the fastest of several runs
+// Restarts run in parallel, each from its own seed, so for a given build the output only depends on the options
+// (except for the time objective).
+// The best distinct boards found are written as level strings, best first, each after a `;` comment line giving
+// its score and worst action, so the file can be read back as a level file.
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "boulderdash_base.h"
+#include "definitions.h"
+#include "level_reader.h"
+#include "thread_pool.h"
+
+using namespace boulderdash;
+using namespace boulderdash::tools;
+
+namespace {
+
+enum class Objective {
+    kChanges,
+    kExplosions,
+    kBlob,
+    kTime,
+};
+
+constexpr std::array<std::string_view, 4> kObjectiveNames = {"changes", "explosions", "blob", "time"};
+constexpr int kTimeRepeats = 5;
+constexpr int kMaxMutations = 4;
+constexpr double kMultiMutationChance = 0.25;
+
+// Falling rocks, creatures, blob and explosives, the elements which drive chains of updates
+const std::vector<HiddenCellType> kDefaultPalette = {
+    HiddenCellType::kEmpty,         HiddenCellType::kDirt,      HiddenCellType::kStone,
+    HiddenCellType::kStoneFalling,  HiddenCellType::kDiamond,   HiddenCellType::kFireflyUp,
+    HiddenCellType::kButterflyDown, HiddenCellType::kWallBrick, HiddenCellType::kWallMagicDormant,
+    HiddenCellType::kBlob,          HiddenCellType::kNut,       HiddenCellType::kBombFalling,
+    HiddenCellType::kOrangeLeft,
+};
+
+struct Options {
+    std::string output_path;
+    std::string init_path;
+    int rows = 14;
+    int cols = 14;
+    std::vector<HiddenCellType> palette = kDefaultPalette;
+    Objective objective = Objective::kChanges;
+    int restarts = 64;
+    int iterations = 2000;
+    std::size_t keep = 16;
+    uint64_t seed = 0;
+    int num_threads = 0;
+};
+
+struct Board {
+    int rows = 0;
+    int cols = 0;
+    std::vector<HiddenCellType> cells = {};
+
+    [[nodiscard]] auto to_string() const -> std::string {
+        std::string out = std::format("{:d}|{:d}|0", rows, cols);
+        for (const auto cell : cells) {
+            out += std::format("|{:02d}", static_cast<int>(cell));
+        }
+        return out;
+    }
+};
+
+struct Scored {
+    int64_t score = -1;
+    Action action = Action::kUp;
+    std::string board_str;
+};
+
+// Work of one step from state by the objective
+auto step_score(const BoulderDashGameState &state, Action action, Objective objective) -> int64_t {
+    if (objective == Objective::kTime) {
+        int64_t best = std::numeric_limits<int64_t>::max();
+        for (int repeat = 0; repeat < kTimeRepeats; ++repeat) {
+            BoulderDashGameState child = state;
+            const auto t1 = std::chrono::steady_clock::now();
+            child.apply_action(action);
+            const auto t2 = std::chrono::steady_clock::now();
+            best = std::min<int64_t>(best, std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count());
+        }
+        return best;
+    }
+    BoulderDashGameState child = state;
+    child.apply_action(action);
+    const auto &changes = child.get_changed_cells();
+    if (objective == Objective::kChanges) {
+        return static_cast<int64_t>(changes.size());
+    }
+    return std::ranges::count_if(changes, [&](const BoulderDashGameState::CellChange &change) {
+        if (objective == Objective::kBlob) {
+            return (change.new_type == HiddenCellType::kBlob) != (change.old_type == HiddenCellType::kBlob);
+        }
+        return change.new_type == HiddenCellType::kExplosionDiamond ||
+               change.new_type == HiddenCellType::kExplosionBoulder ||
+               change.new_type == HiddenCellType::kExplosionEmpty;
+    });
+}
+
+// Worst step over all actions
+auto score_board(const Board &board, Objective objective) -> Scored {
+    Scored scored{.board_str = board.to_string()};
+    const BoulderDashGameState state(scored.board_str);
+    for (const auto action : ALL_ACTIONS) {
+        const int64_t score = step_score(state, action, objective);
+        if (score > scored.score) {
+            scored.score = score;
+            scored.action = action;
+        }
+    }
+    return scored;
+}
+
+auto random_board(const Options &options, std::mt19937_64 &gen) -> Board {
+    Board board{.rows = options.rows, .cols = options.cols};
+    board.cells.resize(static_cast<std::size_t>(options.rows * options.cols));
+    std::uniform_int_distribution<std::size_t> pick(0, options.palette.size() - 1);
+    for (int r = 0; r < options.rows; ++r) {
+        for (int c = 0; c < options.cols; ++c) {
+            const bool border = r == 0 || c == 0 || r == options.rows - 1 || c == options.cols - 1;
+            board.cells[static_cast<std::size_t>((r * options.cols) + c)] =
+                border ? HiddenCellType::kWallSteel : options.palette[pick(gen)];
+        }
+    }
+    std::uniform_int_distribution<int> row(1, options.rows - 2);
+    std::uniform_int_distribution<int> col(1, options.cols - 2);
+    board.cells[static_cast<std::size_t>((row(gen) * options.cols) + col(gen))] = HiddenCellType::kAgent;
+    return board;
+}
+
+// Hill climb from board, recording every board reaching a new best score
+auto climb(Board board, const Options &options, std::mt19937_64 &gen) -> std::vector<Scored> {
+    std::vector<int> mutable_cells;
+    for (int r = 1; r < board.rows - 1; ++r) {
+        for (int c = 1; c < board.cols - 1; ++c) {
+            const int idx = (r * board.cols) + c;
+            if (board.cells[static_cast<std::size_t>(idx)] != HiddenCellType::kAgent) {
+                mutable_cells.push_back(idx);
+            }
+        }
+    }
+    std::vector<Scored> found;
+    Scored current = score_board(board, options.objective);
+    found.push_back(current);
+    if (mutable_cells.empty()) {
+        return found;
+    }
+    std::uniform_int_distribution<std::size_t> pick_cell(0, mutable_cells.size() - 1);
+    std::uniform_int_distribution<std::size_t> pick_element(0, options.palette.size() - 1);
+    std::uniform_int_distribution<int> pick_count(2, kMaxMutations);
+    std::bernoulli_distribution multi(kMultiMutationChance);
+    for (int iteration = 0; iteration < options.iterations; ++iteration) {
+        Board candidate = board;
+        const int count = multi(gen) ? pick_count(gen) : 1;
+        for (int i = 0; i < count; ++i) {
+            const auto idx = static_cast<std::size_t>(mutable_cells[pick_cell(gen)]);
+            candidate.cells[idx] = options.palette[pick_element(gen)];
+        }
+        Scored scored = score_board(candidate, options.objective);
+        if (scored.score >= current.score) {
+            if (scored.score > current.score) {
+                found.push_back(scored);
+            }
+            board = std::move(candidate);
+            current = std::move(scored);
+        }
+    }
+    return found;
+}
+
+auto parse_options(int argc, char **argv) -> Options {
+    const std::vector<std::string_view> args(argv + 1, argv + argc);    // NOLINT(*-pointer-arithmetic)
+    Options options;
+    const auto parse_int = [](std::string_view name, std::string_view value) {
+        int64_t result = 0;
+        const auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), result);
+        if (ec != std::errc{} || ptr != value.data() + value.size() || result < 0) {
+            throw std::invalid_argument(std::format("Invalid {:s} {:s}", name, value));
+        }
+        return result;
+    };
+    const auto parse_palette = [&](std::string_view value) {
+        std::vector<HiddenCellType> palette;
+        while (!value.empty()) {
+            const std::size_t comma = std::min(value.find(','), value.size());
+            const int64_t id = parse_int("palette element", value.substr(0, comma));
+            // The board holds exactly one agent, placed before climbing and never changed
+            if (id >= kNumHiddenCellType || static_cast<HiddenCellType>(id) == HiddenCellType::kAgent ||
+                static_cast<HiddenCellType>(id) == HiddenCellType::kAgentInExit) {
+                throw std::invalid_argument(std::format("Invalid palette element {:d}", id));
+            }
+            palette.push_back(static_cast<HiddenCellType>(id));
+            value.remove_prefix(std::min(comma + 1, value.size()));
+        }
+        return palette;
+    };
+    for (std::size_t i = 0; i < args.size(); ++i) {
+        const bool has_value = i + 1 < args.size();
+        if (args[i] == "--rows" && has_value) {
+            options.rows = static_cast<int>(parse_int("row count", args[++i]));
+        } else if (args[i] == "--cols" && has_value) {
+            options.cols = static_cast<int>(parse_int("column count", args[++i]));
+        } else if (args[i] == "--palette" && has_value) {
+            options.palette = parse_palette(args[++i]);
+        } else if (args[i] == "--objective" && has_value) {
+            const auto it = std::ranges::find(kObjectiveNames, args[++i]);
+            if (it == kObjectiveNames.end()) {
+                throw std::invalid_argument(std::format("Unknown objective {:s}", args[i]));
+            }
+            options.objective = static_cast<Objective>(it - kObjectiveNames.begin());
+        } else if (args[i] == "--init" && has_value) {
+            options.init_path = args[++i];
+        } else if (args[i] == "--restarts" && has_value) {
+            options.restarts = static_cast<int>(parse_int("restart count", args[++i]));
+        } else if (args[i] == "--iterations" && has_value) {
+            options.iterations = static_cast<int>(parse_int("iteration count", args[++i]));
+        } else if (args[i] == "--keep" && has_value) {
+            options.keep = static_cast<std::size_t>(parse_int("board count", args[++i]));
+        } else if (args[i] == "--seed" && has_value) {
+            options.seed = static_cast<uint64_t>(parse_int("seed", args[++i]));
+        } else if (args[i] == "--threads" && has_value) {
+            options.num_threads = static_cast<int>(parse_int("thread count", args[++i]));
+        } else if (options.output_path.empty()) {
+            options.output_path = args[i];
+        } else {
+            throw std::invalid_argument(std::format("Unexpected argument {:s}", args[i]));
+        }
+    }
+    if (options.output_path.empty()) {
+        throw std::invalid_argument(
+            "Usage: worst_tick <output.txt> [--rows R] [--cols C] [--palette ID,ID,...] "
+            "[--objective changes|explosions|blob|time] [--init levels.txt] [--restarts N] [--iterations N] "
+            "[--keep K] [--seed S] [--threads N]");
+    }
+    if (options.rows < 3 || options.cols < 3 || options.palette.empty()) {
+        throw std::invalid_argument("Boards need at least 3 rows and columns and a non-empty palette");
+    }
+    return options;
+}
+
+// Starting boards of the --init file, with an agent, cycled through by the restarts
+auto read_init_boards(const std::string &path) -> std::vector<Board> {
+    std::vector<Board> boards;
+    LevelFileReader reader(path);
+    LevelParser parser;
+    std::vector<std::string_view> lines;
+    while (reader.next_batch(lines)) {
+        for (const auto line : lines) {
+            const LevelView level = parser.parse(line);
+            if (std::ranges::count(level.cells, HiddenCellType::kAgent) != 1 ||
+                std::ranges::find(level.cells, HiddenCellType::kAgentInExit) != level.cells.end()) {
+                throw std::invalid_argument(std::format("Level {:d} of {:s} does not have one agent, outside the exit",
+                                                        boards.size(), path));
+            }
+            boards.push_back({level.rows, level.cols, {level.cells.begin(), level.cells.end()}});
+        }
+    }
+    if (boards.empty()) {
+        throw std::invalid_argument(std::format("No levels in {:s}", path));
+    }
+    return boards;
+}
+
+void run(const Options &options) {
+    const std::vector<Board> init_boards = options.init_path.empty() ? std::vector<Board>{}
+                                                                     : read_init_boards(options.init_path);
+    const auto num_restarts = static_cast<std::size_t>(options.restarts);
+    std::vector<std::vector<Scored>> found(num_restarts);
+    std::vector<std::string> errors(num_restarts);
+    ThreadPool::global().parallel_for(
+        num_restarts,
+        [&](std::size_t i) {
+            try {
+                std::mt19937_64 gen(options.seed + i);
+                Board board = init_boards.empty() ? random_board(options, gen) : init_boards[i % init_boards.size()];
+                found[i] = climb(std::move(board), options, gen);
+            } catch (const std::exception &e) {
+                errors[i] = e.what();
+            }
+        },
+        options.num_threads);
+
+    // Merge in restart order, so ties keep the same order whatever the thread count
+    std::vector<Scored> all;
+    for (std::size_t i = 0; i < num_restarts; ++i) {
+        if (!errors[i].empty()) {
+            throw std::invalid_argument(std::format("Restart {:d}: {:s}", i, errors[i]));
+        }
+        all.insert(all.end(), found[i].begin(), found[i].end());
+    }
+    std::ranges::stable_sort(all, std::ranges::greater{}, &Scored::score);
+    const std::string_view objective = kObjectiveNames[static_cast<std::size_t>(options.objective)];
+    std::unordered_set<std::string> written;
+    std::string out;
+    for (const auto &scored : all) {
+        if (written.size() == options.keep) {
+            break;
+        }
+        if (written.insert(scored.board_str).second) {
+            out += std::format("; {:s} {:d} action {:d}\n{:s}\n", objective, scored.score,
+                               static_cast<int>(scored.action), scored.board_str);
+        }
+    }
+
+    std::ofstream file(options.output_path, std::ios::binary);
+    if (!file || !file.write(out.data(), static_cast<std::streamsize>(out.size()))) {
+        throw std::invalid_argument(std::format("Unable to write output file {:s}", options.output_path));
+    }
+    std::cerr << std::format("Wrote {:d} boards to {:s}, worst {:s} {:d}", written.size(), options.output_path,
+                             objective, all.empty() ? 0 : all.front().score)
+              << std::endl;
+}
+
+}    // namespace
+
+int main(int argc, char **argv) {
+    try {
+        run(parse_options(argc, argv));
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}